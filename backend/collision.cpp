@@ -239,11 +239,25 @@ static void collision_resolve_interpenetration_constraint(collision_t *c) {
                 matter_to_global_direction(a, NULL, &n, &n);
                 vec3_multiply_f(&n, &n, -phi * ratio);
                 transform_translate(&b->transform, &n);
+                sb->version.fetch_add(1, std::memory_order_release);
             }
         }
     }
 }
 
+// bounds the distance to the intersection of both substances over the bound
+static void intersection_interval(substance_t **substances, bound3_t *bound,
+                                  interval_t *phi) {
+    interval_t phis[2];
+    for (int i = 0; i < 2; i++) {
+        bound3_t local_bound;
+        matter_to_local_bound(&substances[i]->matter, &local_bound, bound);
+        sdf_distance_interval(substances[i]->matter.sdf, &local_bound, &phis[i]);
+    }
+
+    interval_max(phi, &phis[0], &phis[1]);
+}
+
 static bool is_colliding_in_bound(substance_t **substances, bound3_t *bound) {
     vec3 radius;
     bound3_radius(bound, &radius);
@@ -251,6 +265,16 @@ static bool is_colliding_in_bound(substance_t **substances, bound3_t *bound) {
         return false;
     }
 
+    interval_t phi;
+    intersection_interval(substances, bound, &phi);
+    if (phi.lower > epsilon) {
+        return false;
+    }
+
+    if (interval_is_non_positive(&phi)) {
+        return true;
+    }
+
     bound3_t sub_bounds[2];
     bound3_bisect(bound, sub_bounds);
     double sub_bound_distances[2];
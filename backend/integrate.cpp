@@ -0,0 +1,211 @@
+#include "integrate.h"
+
+#include <thread>
+#include <vector>
+
+typedef struct moments_t {
+    double volume;
+    vec3 first;
+    mat3 second;
+} moments_t;
+
+typedef struct cell_t {
+    vec3 centre;
+    double phi;
+} cell_t;
+
+typedef array_t(cell_t) cell_array_t;
+
+static void moments_create(moments_t *moments) {
+    moments->volume = 0.0;
+    moments->first = vec3_zero;
+    for (int i = 0; i < MAT3_SIZE; i++) {
+        moments->second.v[i] = 0.0;
+    }
+}
+
+static void moments_add(moments_t *moments, const moments_t *other) {
+    moments->volume += other->volume;
+    vec3_add(&moments->first, &moments->first, &other->first);
+    for (int i = 0; i < MAT3_SIZE; i++) {
+        moments->second.v[i] += other->second.v[i];
+    }
+}
+
+// adds the moments of an axis aligned box, scaled by the fraction of the box
+// that is occupied
+static void moments_add_box(moments_t *moments, const vec3 *centre,
+                            const vec3 *radius, double fraction) {
+    double volume = 8.0 * radius->x * radius->y * radius->z * fraction;
+
+    moments->volume += volume;
+    for (int i = 0; i < 3; i++) {
+        moments->first.v[i] += volume * centre->v[i];
+
+        for (int j = 0; j < 3; j++) {
+            double m = centre->v[i] * centre->v[j];
+            if (i == j) {
+                m += radius->v[i] * radius->v[i] / 3.0;
+            }
+
+            moments->second.v[j * 3 + i] += volume * m;
+        }
+    }
+}
+
+typedef struct level_t {
+    sdf_t *sdf;
+    vec3 radius;
+    double radius_length;
+
+    cell_t *cells;
+    size_t begin;
+    size_t end;
+
+    moments_t inside;
+    cell_array_t straddling;
+} level_t;
+
+static void classify_cells(level_t *level) {
+    moments_create(&level->inside);
+    array_create(&level->straddling);
+
+    for (size_t i = level->begin; i < level->end; i++) {
+        cell_t *cell = &level->cells[i];
+        cell->phi = sdf_distance(level->sdf, &cell->centre);
+
+        if (cell->phi >= level->radius_length) {
+            continue;
+        }
+
+        if (cell->phi <= -level->radius_length) {
+            moments_add_box(&level->inside, &cell->centre, &level->radius, 1.0);
+            continue;
+        }
+
+        array_push_back(&level->straddling);
+        *level->straddling.last = *cell;
+    }
+}
+
+// estimates the occupied fraction of a straddling cell by assuming that the
+// surface is planar within the cell
+static double straddling_fraction(const cell_t *cell, const vec3 *radius) {
+    double mean_radius = (radius->x + radius->y + radius->z) / 3.0;
+    double fraction = 0.5 - cell->phi / (2.0 * mean_radius);
+    return fmax(0.0, fmin(fraction, 1.0));
+}
+
+void integrate_mass_properties(sdf_t *sdf, const bound3_t *bound, double tolerance,
+                               mass_properties_t *properties) {
+    moments_t total;
+    moments_create(&total);
+
+    cell_array_t cells;
+    array_create(&cells);
+    array_push_back(&cells);
+    bound3_midpoint(bound, &cells.last->centre);
+
+    vec3 radius;
+    bound3_radius(bound, &radius);
+
+    size_t number_of_threads = std::thread::hardware_concurrency();
+    if (number_of_threads == 0) {
+        number_of_threads = 1;
+    }
+
+    for (int depth = 0; !array_is_empty(&cells); depth++) {
+        size_t number_of_levels = 1;
+        if (cells.size >= SERAPHIM_INTEGRATE_PARALLEL_THRESHOLD) {
+            number_of_levels = number_of_threads;
+        }
+
+        std::vector<level_t> levels(number_of_levels);
+        for (size_t i = 0; i < number_of_levels; i++) {
+            levels[i].sdf = sdf;
+            levels[i].radius = radius;
+            levels[i].radius_length = vec3_length(&radius);
+            levels[i].cells = cells.data;
+            levels[i].begin = cells.size * i / number_of_levels;
+            levels[i].end = cells.size * (i + 1) / number_of_levels;
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < number_of_levels; i++) {
+            threads.emplace_back(classify_cells, &levels[i]);
+        }
+        classify_cells(&levels[0]);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        size_t number_of_straddling = 0;
+        for (auto &level : levels) {
+            moments_add(&total, &level.inside);
+            number_of_straddling += level.straddling.size;
+        }
+
+        double cell_volume = 8.0 * radius.x * radius.y * radius.z;
+        double uncertainty = cell_volume * (double)number_of_straddling;
+        bool is_converged = uncertainty <= tolerance * (total.volume + uncertainty);
+
+        array_clear(&cells);
+
+        for (auto &level : levels) {
+            for (size_t i = 0; i < level.straddling.size; i++) {
+                cell_t *cell = &level.straddling.data[i];
+
+                if (is_converged || depth >= SERAPHIM_INTEGRATE_MAX_DEPTH) {
+                    double fraction = straddling_fraction(cell, &radius);
+                    moments_add_box(&total, &cell->centre, &radius, fraction);
+                    continue;
+                }
+
+                for (int octant = 0; octant < 8; octant++) {
+                    array_push_back(&cells);
+                    for (int axis = 0; axis < 3; axis++) {
+                        double sign = (octant & (1 << axis)) != 0 ? 0.5 : -0.5;
+                        cells.last->centre.v[axis] =
+                            cell->centre.v[axis] + sign * radius.v[axis];
+                    }
+                }
+            }
+
+            array_clear(&level.straddling);
+        }
+
+        vec3_multiply_f(&radius, &radius, 0.5);
+    }
+
+    properties->volume = total.volume;
+
+    if (total.volume <= 0.0) {
+        properties->com = vec3_zero;
+        properties->inertia_tensor = mat3_identity;
+        return;
+    }
+
+    vec3 com;
+    vec3_divide_f(&com, &total.first, total.volume);
+    properties->com = com;
+
+    // second moments about the centre of mass per unit volume
+    mat3 covariance;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            covariance.v[j * 3 + i] =
+                total.second.v[j * 3 + i] / total.volume - com.v[i] * com.v[j];
+        }
+    }
+
+    double trace = covariance.v[0] + covariance.v[4] + covariance.v[8];
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            double iij = -covariance.v[j * 3 + i];
+            if (i == j) {
+                iij += trace;
+            }
+            properties->inertia_tensor.v[j * 3 + i] = iij;
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef SERAPHIM_INTEGRATE_H
+#define SERAPHIM_INTEGRATE_H
+
+#include "sdf.h"
+
+// deepest level of octree refinement before straddling cells are estimated
+#define SERAPHIM_INTEGRATE_MAX_DEPTH 9
+
+// levels with fewer cells than this are evaluated on the calling thread
+#define SERAPHIM_INTEGRATE_PARALLEL_THRESHOLD 4096
+
+typedef struct mass_properties_t {
+    double volume;
+    vec3 com;
+
+    // inertia tensor about the centre of mass for a body of unit mass
+    mat3 inertia_tensor;
+} mass_properties_t;
+
+// integrates the volume, centre of mass and inertia tensor of the region where
+// the sdf is negative within the given bound. cells are classified as inside,
+// outside or straddling the surface using the distance at their centre, and
+// only straddling cells are refined, until the volume of the remaining
+// straddling cells is at most the given fraction of the total volume.
+void integrate_mass_properties(sdf_t *sdf, const bound3_t *bound, double tolerance,
+                               mass_properties_t *properties);
+
+#endif
@@ -0,0 +1,703 @@
+#include "mesh.h"
+
+#include <float.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include "../common/file.h"
+
+static const uint32_t cache_magic = 0x48505253; // "SRPH"
+static const uint32_t cache_version = 1;
+
+typedef struct mesh_cache_header_t {
+    uint32_t magic;
+    uint32_t version;
+    vec3u size;
+    uint32_t _1;
+    vec3 origin;
+    double cell_size;
+    bound3_t bound;
+    sphere_t bounding_sphere;
+} mesh_cache_header_t;
+
+// ray directions used to decide whether a point is inside the mesh. they are
+// chosen to avoid running along the edges of axis aligned faces.
+static const vec3 parity_directions[3] = {
+    {{0.8017837, 0.2672612, 0.5345225}},
+    {{-0.2672612, 0.5345225, -0.8017837}},
+    {{0.5345225, -0.8017837, -0.2672612}},
+};
+
+static uint64_t hash_bytes(const uint8_t *bytes, size_t size, uint64_t hash) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+static void mesh_add_triangle(mesh_t *self, const vec3 *a, const vec3 *b, const vec3 *c) {
+    array_push_back(&self->triangles);
+    self->triangles.last->vertices[0] = *a;
+    self->triangles.last->vertices[1] = *b;
+    self->triangles.last->vertices[2] = *c;
+}
+
+static bool mesh_load_obj(mesh_t *self, const char *text) {
+    array_t(vec3) vertices;
+    array_create(&vertices);
+
+    const char *line = text;
+    while (line != NULL && *line != '\0') {
+        if (line[0] == 'v' && line[1] == ' ') {
+            array_push_back(&vertices);
+            vec3 *v = vertices.last;
+            if (sscanf(line + 2, "%lf %lf %lf", &v->x, &v->y, &v->z) != 3) {
+                array_clear(&vertices);
+                return false;
+            }
+        } else if (line[0] == 'f' && line[1] == ' ') {
+            // faces with more than three vertices are split into a fan
+            const char *token = line + 2;
+            long indices[3];
+            int count = 0;
+
+            while (true) {
+                char *end;
+                long index = strtol(token, &end, 10);
+                if (end == token) {
+                    break;
+                }
+
+                index = index < 0 ? (long)vertices.size + index : index - 1;
+                if (index < 0 || index >= (long)vertices.size) {
+                    array_clear(&vertices);
+                    return false;
+                }
+
+                if (count < 3) {
+                    indices[count++] = index;
+                } else {
+                    indices[1] = indices[2];
+                    indices[2] = index;
+                }
+
+                if (count == 3) {
+                    mesh_add_triangle(self, &vertices.data[indices[0]],
+                                      &vertices.data[indices[1]],
+                                      &vertices.data[indices[2]]);
+                }
+
+                // skip texture coordinate and normal indices
+                token = end;
+                while (*token != '\0' && *token != ' ' && *token != '\n') {
+                    token++;
+                }
+            }
+        }
+
+        line = strchr(line, '\n');
+        if (line != NULL) {
+            line++;
+        }
+    }
+
+    array_clear(&vertices);
+    return true;
+}
+
+static bool mesh_load_stl(mesh_t *self, const uint8_t *bytes, size_t size) {
+    uint32_t number_of_triangles = 0;
+    if (size >= 84) {
+        memcpy(&number_of_triangles, bytes + 80, sizeof(uint32_t));
+    }
+
+    if (size >= 84 && size == 84 + 50 * (size_t)number_of_triangles) {
+        for (uint32_t i = 0; i < number_of_triangles; i++) {
+            // skip the normal at the start of each triangle
+            const uint8_t *record = bytes + 84 + 50 * i + 12;
+
+            vec3 vs[3];
+            for (int j = 0; j < 3; j++) {
+                float v[3];
+                memcpy(v, record + 12 * j, sizeof(v));
+                vs[j] = {{v[0], v[1], v[2]}};
+            }
+
+            mesh_add_triangle(self, &vs[0], &vs[1], &vs[2]);
+        }
+
+        return true;
+    }
+
+    const char *text = (const char *)bytes;
+    vec3 vs[3];
+    int count = 0;
+    while ((text = strstr(text, "vertex")) != NULL) {
+        text += strlen("vertex");
+
+        vec3 *v = &vs[count];
+        if (sscanf(text, "%lf %lf %lf", &v->x, &v->y, &v->z) != 3) {
+            return false;
+        }
+
+        count++;
+        if (count == 3) {
+            mesh_add_triangle(self, &vs[0], &vs[1], &vs[2]);
+            count = 0;
+        }
+    }
+
+    return true;
+}
+
+static void triangle_centroid(const triangle_t *t, vec3 *c) {
+    vec3_add(c, &t->vertices[0], &t->vertices[1]);
+    vec3_add(c, c, &t->vertices[2]);
+    vec3_divide_f(c, c, 3.0);
+}
+
+// internal nodes are immediately followed by their left child and store the
+// index of their right child
+static uint32_t mesh_build_bvh(mesh_t *self, uint32_t first, uint32_t count) {
+    uint32_t index = (uint32_t)self->nodes.size;
+    array_push_back(&self->nodes);
+
+    bound3_t bound, centroid_bound;
+    bound3_create(&bound);
+    bound3_create(&centroid_bound);
+    for (uint32_t i = first; i < first + count; i++) {
+        triangle_t *t = &self->triangles.data[i];
+        for (int j = 0; j < 3; j++) {
+            bound3_capture(&bound, &t->vertices[j]);
+        }
+
+        vec3 c;
+        triangle_centroid(t, &c);
+        bound3_capture(&centroid_bound, &c);
+    }
+
+    self->nodes.data[index].bound = bound;
+
+    if (count <= SERAPHIM_MESH_LEAF_SIZE) {
+        self->nodes.data[index].first = first;
+        self->nodes.data[index].count = count;
+        return index;
+    }
+
+    vec3 radius;
+    bound3_radius(&centroid_bound, &radius);
+    int axis = 0;
+    for (int i = 1; i < 3; i++) {
+        if (radius.v[i] > radius.v[axis]) {
+            axis = i;
+        }
+    }
+
+    triangle_t *triangles = self->triangles.data;
+    uint32_t half = count / 2;
+    std::nth_element(triangles + first, triangles + first + half, triangles + first + count,
+                     [axis](const triangle_t &a, const triangle_t &b) {
+                         vec3 ca, cb;
+                         triangle_centroid(&a, &ca);
+                         triangle_centroid(&b, &cb);
+                         return ca.v[axis] < cb.v[axis];
+                     });
+
+    mesh_build_bvh(self, first, half);
+    uint32_t right = mesh_build_bvh(self, first + half, count - half);
+
+    self->nodes.data[index].first = right;
+    self->nodes.data[index].count = 0;
+    return index;
+}
+
+bool mesh_load(mesh_t *self, const char *filename) {
+    array_create(&self->triangles);
+    array_create(&self->nodes);
+
+    size_t size;
+    uint8_t *bytes = file_load_binary(filename, &size);
+    if (bytes == NULL) {
+        return false;
+    }
+
+    const char *extension = strrchr(filename, '.');
+    bool is_loaded = false;
+    if (extension != NULL && strcasecmp(extension, ".obj") == 0) {
+        is_loaded = mesh_load_obj(self, (const char *)bytes);
+    } else if (extension != NULL && strcasecmp(extension, ".stl") == 0) {
+        is_loaded = mesh_load_stl(self, bytes, size);
+    }
+
+    free(bytes);
+
+    if (!is_loaded || array_is_empty(&self->triangles)) {
+        mesh_destroy(self);
+        return false;
+    }
+
+    mesh_build_bvh(self, 0, (uint32_t)self->triangles.size);
+    return true;
+}
+
+void mesh_destroy(mesh_t *self) {
+    array_clear(&self->triangles);
+    array_clear(&self->nodes);
+}
+
+static void triangle_closest_point(const triangle_t *t, const vec3 *p, vec3 *closest) {
+    const vec3 *a = &t->vertices[0];
+    const vec3 *b = &t->vertices[1];
+    const vec3 *c = &t->vertices[2];
+
+    vec3 ab, ac, ap;
+    vec3_subtract(&ab, b, a);
+    vec3_subtract(&ac, c, a);
+    vec3_subtract(&ap, p, a);
+
+    double d1 = vec3_dot(&ab, &ap);
+    double d2 = vec3_dot(&ac, &ap);
+    if (d1 <= 0.0 && d2 <= 0.0) {
+        *closest = *a;
+        return;
+    }
+
+    vec3 bp;
+    vec3_subtract(&bp, p, b);
+    double d3 = vec3_dot(&ab, &bp);
+    double d4 = vec3_dot(&ac, &bp);
+    if (d3 >= 0.0 && d4 <= d3) {
+        *closest = *b;
+        return;
+    }
+
+    double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+        vec3_multiply_f(closest, &ab, d1 / (d1 - d3));
+        vec3_add(closest, closest, a);
+        return;
+    }
+
+    vec3 cp;
+    vec3_subtract(&cp, p, c);
+    double d5 = vec3_dot(&ab, &cp);
+    double d6 = vec3_dot(&ac, &cp);
+    if (d6 >= 0.0 && d5 <= d6) {
+        *closest = *c;
+        return;
+    }
+
+    double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+        vec3_multiply_f(closest, &ac, d2 / (d2 - d6));
+        vec3_add(closest, closest, a);
+        return;
+    }
+
+    double va = d3 * d6 - d5 * d4;
+    if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0) {
+        vec3 bc;
+        vec3_subtract(&bc, c, b);
+        vec3_multiply_f(closest, &bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        vec3_add(closest, closest, b);
+        return;
+    }
+
+    double denominator = 1.0 / (va + vb + vc);
+    vec3 v, w;
+    vec3_multiply_f(&v, &ab, vb * denominator);
+    vec3_multiply_f(&w, &ac, vc * denominator);
+    vec3_add(closest, a, &v);
+    vec3_add(closest, closest, &w);
+}
+
+static bool triangle_intersects_ray(const triangle_t *t, const vec3 *origin,
+                                    const vec3 *direction) {
+    vec3 e1, e2, p;
+    vec3_subtract(&e1, &t->vertices[1], &t->vertices[0]);
+    vec3_subtract(&e2, &t->vertices[2], &t->vertices[0]);
+    vec3_cross(&p, direction, &e2);
+
+    double determinant = vec3_dot(&e1, &p);
+    if (fabs(determinant) < DBL_EPSILON) {
+        return false;
+    }
+
+    double inverse_determinant = 1.0 / determinant;
+    vec3 s;
+    vec3_subtract(&s, origin, &t->vertices[0]);
+    double u = vec3_dot(&s, &p) * inverse_determinant;
+    if (u < 0.0 || u > 1.0) {
+        return false;
+    }
+
+    vec3 q;
+    vec3_cross(&q, &s, &e1);
+    double v = vec3_dot(direction, &q) * inverse_determinant;
+    if (v < 0.0 || u + v > 1.0) {
+        return false;
+    }
+
+    return vec3_dot(&e2, &q) * inverse_determinant > 0.0;
+}
+
+static double bound_square_distance(const bound3_t *b, const vec3 *x) {
+    double d = 0.0;
+    for (int i = 0; i < 3; i++) {
+        double e = fmax(fmax(b->lower.v[i] - x->v[i], x->v[i] - b->upper.v[i]), 0.0);
+        d += e * e;
+    }
+    return d;
+}
+
+static bool bound_intersects_ray(const bound3_t *b, const vec3 *origin,
+                                 const vec3 *direction) {
+    double t_near = 0.0;
+    double t_far = DBL_MAX;
+    for (int i = 0; i < 3; i++) {
+        double inverse = 1.0 / direction->v[i];
+        double t0 = (b->lower.v[i] - origin->v[i]) * inverse;
+        double t1 = (b->upper.v[i] - origin->v[i]) * inverse;
+        t_near = fmax(t_near, fmin(t0, t1));
+        t_far = fmin(t_far, fmax(t0, t1));
+    }
+    return t_near <= t_far;
+}
+
+static double mesh_unsigned_distance(mesh_t *self, const vec3 *x) {
+    double best = DBL_MAX;
+
+    uint32_t stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        uint32_t index = stack[--stack_size];
+        bvh_node_t *node = &self->nodes.data[index];
+        if (bound_square_distance(&node->bound, x) >= best) {
+            continue;
+        }
+
+        if (node->count > 0) {
+            for (uint32_t i = node->first; i < node->first + node->count; i++) {
+                vec3 closest;
+                triangle_closest_point(&self->triangles.data[i], x, &closest);
+                best = fmin(best, vec3_distance_squared(&closest, x));
+            }
+            continue;
+        }
+
+        // visit the nearer child first so that the other is more likely pruned
+        uint32_t left = index + 1;
+        uint32_t right = node->first;
+        double left_distance = bound_square_distance(&self->nodes.data[left].bound, x);
+        double right_distance = bound_square_distance(&self->nodes.data[right].bound, x);
+        if (left_distance < right_distance) {
+            stack[stack_size++] = right;
+            stack[stack_size++] = left;
+        } else {
+            stack[stack_size++] = left;
+            stack[stack_size++] = right;
+        }
+    }
+
+    return sqrt(best);
+}
+
+static int mesh_count_crossings(mesh_t *self, const vec3 *x, const vec3 *direction) {
+    int crossings = 0;
+
+    uint32_t stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        uint32_t index = stack[--stack_size];
+        bvh_node_t *node = &self->nodes.data[index];
+        if (!bound_intersects_ray(&node->bound, x, direction)) {
+            continue;
+        }
+
+        if (node->count > 0) {
+            for (uint32_t i = node->first; i < node->first + node->count; i++) {
+                if (triangle_intersects_ray(&self->triangles.data[i], x, direction)) {
+                    crossings++;
+                }
+            }
+            continue;
+        }
+
+        stack[stack_size++] = index + 1;
+        stack[stack_size++] = node->first;
+    }
+
+    return crossings;
+}
+
+// the sign is decided by a majority vote of ray parity tests, which tolerates a
+// ray passing through an edge or a small hole in the mesh
+double mesh_distance(mesh_t *self, const vec3 *x) {
+    double distance = mesh_unsigned_distance(self, x);
+
+    int votes = 0;
+    for (int i = 0; i < 3; i++) {
+        votes += mesh_count_crossings(self, x, &parity_directions[i]) % 2;
+    }
+
+    return votes >= 2 ? -distance : distance;
+}
+
+static char *mesh_sdf_cache_filename(const char *cache_directory, uint64_t hash) {
+    char *filename = (char *)malloc(strlen(cache_directory) + 32);
+    sprintf(filename, "%s/%016" PRIx64 ".sdf", cache_directory, hash);
+    return filename;
+}
+
+static bool mesh_sdf_load_cache(mesh_sdf_t *self, const char *filename) {
+    size_t size;
+    uint8_t *bytes = file_load_binary(filename, &size);
+    if (bytes == NULL) {
+        return false;
+    }
+
+    mesh_cache_header_t header;
+    if (size < sizeof(header)) {
+        free(bytes);
+        return false;
+    }
+    memcpy(&header, bytes, sizeof(header));
+
+    size_t number_of_samples = (size_t)header.size.x * header.size.y * header.size.z;
+    if (header.magic != cache_magic || header.version != cache_version ||
+        size != sizeof(header) + number_of_samples * sizeof(float)) {
+        free(bytes);
+        return false;
+    }
+
+    self->bound = header.bound;
+    self->bounding_sphere = header.bounding_sphere;
+    self->origin = header.origin;
+    self->cell_size = header.cell_size;
+    self->size = header.size;
+    self->phi = (float *)malloc(number_of_samples * sizeof(float));
+    memcpy(self->phi, bytes + sizeof(header), number_of_samples * sizeof(float));
+
+    free(bytes);
+    return true;
+}
+
+static void mesh_sdf_save_cache(mesh_sdf_t *self, const char *cache_directory, const char *filename) {
+    std::error_code error;
+    std::filesystem::create_directories(cache_directory, error);
+
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) {
+        return;
+    }
+
+    mesh_cache_header_t header = {
+        .magic = cache_magic,
+        .version = cache_version,
+        .size = self->size,
+        ._1 = 0,
+        .origin = self->origin,
+        .cell_size = self->cell_size,
+        .bound = self->bound,
+        .bounding_sphere = self->bounding_sphere,
+    };
+
+    size_t number_of_samples = (size_t)self->size.x * self->size.y * self->size.z;
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(self->phi, sizeof(float), number_of_samples, file);
+    fclose(file);
+}
+
+static void mesh_sdf_sample(mesh_sdf_t *self, mesh_t *mesh, uint32_t z_begin, uint32_t z_end) {
+    for (uint32_t z = z_begin; z < z_end; z++) {
+        for (uint32_t y = 0; y < self->size.y; y++) {
+            for (uint32_t x = 0; x < self->size.x; x++) {
+                vec3 p = {{(double)x, (double)y, (double)z}};
+                vec3_multiply_f(&p, &p, self->cell_size);
+                vec3_add(&p, &p, &self->origin);
+
+                size_t index = ((size_t)z * self->size.y + y) * self->size.x + x;
+                self->phi[index] = (float)mesh_distance(mesh, &p);
+            }
+        }
+    }
+}
+
+// samples the mesh onto a grid, failing for meshes without any extent to
+// divide into cells
+static bool mesh_sdf_generate(mesh_sdf_t *self, mesh_t *mesh, uint32_t resolution) {
+    if (resolution < 2 || array_is_empty(&mesh->triangles)) {
+        return false;
+    }
+
+    bound3_t *bound = &mesh->nodes.data[0].bound;
+
+    vec3 extent;
+    vec3_subtract(&extent, &bound->upper, &bound->lower);
+    double longest = fmax(extent.x, fmax(extent.y, extent.z));
+    if (!(longest > 0.0) || !isfinite(longest)) {
+        return false;
+    }
+
+    self->bound = *bound;
+
+    bound3_midpoint(bound, &self->bounding_sphere.c);
+    self->bounding_sphere.r = 0.0;
+    for (size_t i = 0; i < mesh->triangles.size; i++) {
+        for (int j = 0; j < 3; j++) {
+            double r = vec3_distance(&mesh->triangles.data[i].vertices[j],
+                                     &self->bounding_sphere.c);
+            self->bounding_sphere.r = fmax(self->bounding_sphere.r, r);
+        }
+    }
+
+    self->cell_size = longest / (double)(resolution - 1);
+
+    for (int i = 0; i < 3; i++) {
+        uint32_t cells = (uint32_t)ceil(extent.v[i] / self->cell_size);
+        self->size.v[i] = cells + 1 + 2 * SERAPHIM_MESH_PADDING;
+        self->origin.v[i] = bound->lower.v[i] - SERAPHIM_MESH_PADDING * self->cell_size;
+    }
+
+    size_t number_of_samples = (size_t)self->size.x * self->size.y * self->size.z;
+    self->phi = (float *)malloc(number_of_samples * sizeof(float));
+
+    uint32_t number_of_threads = std::thread::hardware_concurrency();
+    if (number_of_threads == 0) {
+        number_of_threads = 1;
+    }
+    number_of_threads = std::min(number_of_threads, self->size.z);
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < number_of_threads; i++) {
+        threads.emplace_back(mesh_sdf_sample, self, mesh, self->size.z * i / number_of_threads,
+                             self->size.z * (i + 1) / number_of_threads);
+    }
+    mesh_sdf_sample(self, mesh, 0, self->size.z / number_of_threads);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    return true;
+}
+
+// the file in the cache directory that the grid of a mesh at a resolution is
+// cached in, or NULL if the mesh can't be read
+static char *mesh_sdf_cache_filename_of(const char *filename, uint32_t resolution, const char *cache_directory) {
+    size_t size;
+    uint8_t *bytes = file_load_binary(filename, &size);
+    if (bytes == NULL) {
+        return NULL;
+    }
+
+    uint64_t hash = hash_bytes(bytes, size, 0xcbf29ce484222325);
+    hash = hash_bytes((const uint8_t *)&resolution, sizeof(resolution), hash);
+    free(bytes);
+
+    return mesh_sdf_cache_filename(cache_directory, hash);
+}
+
+bool mesh_sdf_create(mesh_sdf_t *self, const char *filename, uint32_t resolution, const char *cache_directory) {
+    self->phi = NULL;
+
+    if (resolution < 2) {
+        return false;
+    }
+
+    char *cache_filename = mesh_sdf_cache_filename_of(filename, resolution, cache_directory);
+    if (cache_filename == NULL) {
+        return false;
+    }
+
+    if (mesh_sdf_load_cache(self, cache_filename)) {
+        free(cache_filename);
+        return true;
+    }
+
+    mesh_t mesh;
+    if (!mesh_load(&mesh, filename)) {
+        free(cache_filename);
+        return false;
+    }
+
+    bool is_generated = mesh_sdf_generate(self, &mesh, resolution);
+    mesh_destroy(&mesh);
+
+    if (is_generated) {
+        mesh_sdf_save_cache(self, cache_directory, cache_filename);
+    }
+    free(cache_filename);
+    return is_generated;
+}
+
+// removes the cached grid of a mesh at a resolution, so that it is generated again
+void mesh_sdf_remove_cache(const char *filename, uint32_t resolution, const char *cache_directory) {
+    char *cache_filename = mesh_sdf_cache_filename_of(filename, resolution, cache_directory);
+    if (cache_filename != NULL) {
+        remove(cache_filename);
+        free(cache_filename);
+    }
+}
+
+void mesh_sdf_destroy(mesh_sdf_t *self) {
+    free(self->phi);
+    self->phi = NULL;
+}
+
+static double mesh_sdf_sample_at(mesh_sdf_t *self, uint32_t x, uint32_t y, uint32_t z) {
+    return self->phi[((size_t)z * self->size.y + y) * self->size.x + x];
+}
+
+// trilinearly interpolates the grid. points outside of the grid are moved onto
+// it and the distance they were moved is added.
+double mesh_sdf_distance(void *data, const vec3 *x) {
+    mesh_sdf_t *self = (mesh_sdf_t *)data;
+
+    double outside = 0.0;
+    uint32_t cell[3];
+    double t[3];
+    for (int i = 0; i < 3; i++) {
+        double u = (x->v[i] - self->origin.v[i]) / self->cell_size;
+        double clamped = fmax(0.0, fmin(u, (double)(self->size.v[i] - 1)));
+        outside += (u - clamped) * (u - clamped);
+
+        cell[i] = std::min((uint32_t)clamped, self->size.v[i] - 2);
+        t[i] = clamped - (double)cell[i];
+    }
+
+    double phi = 0.0;
+    for (int o = 0; o < 8; o++) {
+        double weight = 1.0;
+        uint32_t sample[3];
+        for (int i = 0; i < 3; i++) {
+            bool is_upper = (o & (1 << i)) != 0;
+            sample[i] = cell[i] + (is_upper ? 1 : 0);
+            weight *= is_upper ? t[i] : 1.0 - t[i];
+        }
+
+        phi += weight * mesh_sdf_sample_at(self, sample[0], sample[1], sample[2]);
+    }
+
+    return phi + sqrt(outside) * self->cell_size;
+}
+
+void mesh_sdf_bound(void *data, bound3_t *bound, sphere_t *sphere) {
+    mesh_sdf_t *self = (mesh_sdf_t *)data;
+    *bound = self->bound;
+    *sphere = self->bounding_sphere;
+}
@@ -0,0 +1,61 @@
+#ifndef SERAPHIM_MESH_H
+#define SERAPHIM_MESH_H
+
+#include "../common/array.h"
+#include "../common/bound.h"
+#include "../common/maths.h"
+#include "../common/sphere.h"
+
+// number of samples along the longest axis of the mesh
+#define SERAPHIM_MESH_DEFAULT_RESOLUTION 64
+
+// samples added around the mesh on each side of the grid
+#define SERAPHIM_MESH_PADDING 2
+
+// triangles stored in each leaf of the bvh
+#define SERAPHIM_MESH_LEAF_SIZE 4
+
+// directory that generated distance grids are usually cached in
+#define SERAPHIM_MESH_CACHE_DIRECTORY "cache"
+
+typedef struct triangle_t {
+    vec3 vertices[3];
+} triangle_t;
+
+typedef struct bvh_node_t {
+    bound3_t bound;
+
+    // children for internal nodes, or the range of triangles for leaves
+    uint32_t first;
+    uint32_t count;
+} bvh_node_t;
+
+typedef struct mesh_t {
+    array_t(triangle_t) triangles;
+    array_t(bvh_node_t) nodes;
+} mesh_t;
+
+// a signed distance grid sampled from a closed triangle mesh, which can be
+// registered with seraphim_create_sdf using mesh_sdf_distance
+typedef struct mesh_sdf_t {
+    bound3_t bound;
+    sphere_t bounding_sphere;
+
+    vec3 origin;
+    double cell_size;
+    vec3u size;
+    float *phi;
+} mesh_sdf_t;
+
+bool mesh_load(mesh_t *self, const char *filename);
+void mesh_destroy(mesh_t *self);
+double mesh_distance(mesh_t *self, const vec3 *x);
+
+bool mesh_sdf_create(mesh_sdf_t *self, const char *filename, uint32_t resolution, const char *cache_directory);
+void mesh_sdf_destroy(mesh_sdf_t *self);
+void mesh_sdf_remove_cache(const char *filename, uint32_t resolution, const char *cache_directory);
+
+double mesh_sdf_distance(void *data, const vec3 *x);
+void mesh_sdf_bound(void *data, bound3_t *bound, sphere_t *sphere);
+
+#endif
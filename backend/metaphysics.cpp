@@ -100,6 +100,10 @@ void matter_to_local_position(matter_t *m, vec3 *tx, const vec3 *x) {
     transform_to_local_position(&m->transform, tx, x);
 }
 
+void matter_to_local_bound(matter_t *m, bound3_t *tb, const bound3_t *b) {
+    transform_to_local_bound(&m->transform, tb, b);
+}
+
 void matter_transformation_matrix(matter_t *m, float *xs) {
     mat4 dxs;
     transform_matrix(&m->transform, &dxs);
@@ -145,6 +149,7 @@ void substance_create(substance_t *self, form_t *form, matter_t *matter, uint32_
     self->form = *form;
     self->matter = *matter;
     self->id = id;
+    self->version = 0;
     self->is_inertia_tensor_valid = false;
     self->is_com_valid = false;
 }
@@ -244,8 +249,8 @@ void substance_inverse_inertia_tensor(substance_t *self, mat3 *ri) {
 
 mat3 *substance_inertia_tensor(substance_t *self) {
     if (!self->is_inertia_tensor_valid) {
-        if (self->matter.is_uniform && self->matter.sdf->is_inertia_tensor_valid) {
-            self->inertia_tensor = self->matter.sdf->inertia_tensor;
+        if (self->matter.is_uniform) {
+            self->inertia_tensor = *sdf_inertia_tensor(self->matter.sdf);
         } else {
             for (int i = 0; i < 9; i++) {
                 self->inertia_tensor.v[i] = 0.0;
@@ -292,12 +297,6 @@ mat3 *substance_inertia_tensor(substance_t *self) {
 
             mat3_multiply_f(&self->inertia_tensor, &self->inertia_tensor,
                             1.0 / total);
-
-            if (self->matter.is_uniform &&
-                !self->matter.sdf->is_inertia_tensor_valid) {
-                self->matter.sdf->inertia_tensor = self->inertia_tensor;
-                self->matter.sdf->is_inertia_tensor_valid = true;
-            }
         }
 
         mat3_multiply_f(&self->inertia_tensor, &self->inertia_tensor,
@@ -309,8 +308,8 @@ mat3 *substance_inertia_tensor(substance_t *self) {
 }
 
 vec3 *substance_com(substance_t *self) {
-    if (self->matter.is_uniform && self->matter.sdf->is_com_valid) {
-        return &self->matter.sdf->com;
+    if (self->matter.is_uniform) {
+        return sdf_com(self->matter.sdf);
     }
 
     if (!self->is_com_valid) {
@@ -345,11 +344,6 @@ vec3 *substance_com(substance_t *self) {
         vec3_divide_f(&com, &com, total);
         self->com = com;
         self->is_com_valid = true;
-
-        if (self->matter.is_uniform && !self->matter.sdf->is_com_valid) {
-            self->matter.sdf->com = com;
-            self->matter.sdf->is_com_valid = true;
-        }
     }
 
     return &self->com;
@@ -360,17 +354,16 @@ double substance_mass(substance_t *self) {
 }
 
 void substance_calculate_sphere_bound(substance_t *self, double dt) {
-    vec3 midpoint, radius;
-    bound3_midpoint(&self->matter.sdf->bound, &midpoint);
-    bound3_radius(&self->matter.sdf->bound, &radius);
-    matter_to_global_position(&self->matter, &self->bounding_sphere.c, &midpoint);
-    self->bounding_sphere.r =
-        vec3_length(&radius) + vec3_length(&self->matter.velocity) * dt;
+    sphere_t *sphere = sdf_bounding_sphere(self->matter.sdf);
+    matter_to_global_position(&self->matter, &self->bounding_sphere.c, &sphere->c);
+    self->bounding_sphere.r = sphere->r + vec3_length(&self->matter.velocity) * dt;
 }
 
 
 
-void substance_data(substance_t *substance, substance_data_t *data, vec3 *eye_position) {
+// finds the distances from the eye to the nearest and furthest points of the
+// substance's bound, which change whenever either moves
+void substance_data_distances(substance_t *substance, substance_data_t *data, vec3 *eye_position) {
     matter_t * matter = &substance->matter;
     vec3 r;
     bound3_radius(sdf_bound(matter->sdf), &r);
@@ -387,23 +380,38 @@ void substance_data(substance_t *substance, substance_data_t *data, vec3 *eye_po
         x.v[i] = fmax(x.v[i], 0.0);
     }
 
-    float near = (float)vec3_length(&x);
+    data->near = (float)vec3_length(&x);
 
     x = eye;
     vec3_add(&x, &eye, &r);
 
-    float far = (float)vec3_length(&x);
+    data->far = (float)vec3_length(&x);
+}
+
+void substance_data(substance_t *substance, substance_data_t *data, vec3 *eye_position) {
+    matter_t * matter = &substance->matter;
+    vec3 r;
+    bound3_radius(sdf_bound(matter->sdf), &r);
 
     vec3f f32r = {{(float)r.x, (float)r.y, (float)r.z}};
 
     *data = {
-        .near = near,
-        .far = far,
         .sdf_id = matter->sdf->id,
         .material_id = matter->material->id,
         .r = f32r,
         .id = substance->id,
     };
 
+    substance_data_distances(substance, data, eye_position);
     matter_transformation_matrix(matter, data->transform);
+
+    // the inverse is found once here rather than by every ray that uses it
+    mat4 inverse;
+    for (int i = 0; i < MAT4_SIZE; i++) {
+        inverse.v[i] = data->transform[i];
+    }
+    mat4_inverse(&inverse, &inverse);
+    for (int i = 0; i < MAT4_SIZE; i++) {
+        data->inverse_transform[i] = (float) inverse.v[i];
+    }
 }
@@ -1,6 +1,7 @@
 #ifndef SERAPHIM_METAPHYSICS_H
 #define SERAPHIM_METAPHYSICS_H
 
+#include <atomic>
 #include <memory>
 #include "../common/transform.h"
 #include "../common/material.h"
@@ -39,6 +40,7 @@ void matter_destroy(matter_t *m);
 
 void matter_to_global_position(const matter_t *m, vec3 *tx, const vec3 *x);
 void matter_to_local_position(matter_t *m, vec3 *tx, const vec3 *x);
+void matter_to_local_bound(matter_t *m, bound3_t *tb, const bound3_t *b);
 void matter_to_global_direction(const matter_t *m, const vec3 *position, vec3 *td,
                                 const vec3 *d);
 
@@ -58,6 +60,12 @@ double matter_average_density(matter_t *self);
 typedef struct substance_t {
     uint32_t id;
 
+    // changed by physics whenever the substance is moved, so that what is
+    // derived from its transform is only recalculated when it is stale. it is
+    // released once the transform is written, so a reader that acquires it
+    // sees the transform it counts.
+    std::atomic<uint32_t> version;
+
     bool is_com_valid;
     mat3 inertia_tensor;
     vec3 com;
@@ -73,6 +81,7 @@ typedef struct substance_t {
 
 void substance_create(substance_t *self, form_t *form, matter_t *matter, uint32_t id);
 void substance_data(substance_t *substance, substance_data_t *data, vec3 *eye_position);
+void substance_data_distances(substance_t *substance, substance_data_t *data, vec3 *eye_position);
 
 // velocity
 void substance_velocity_at(substance_t *self, const vec3 *x, vec3 *v);
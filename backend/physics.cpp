@@ -67,6 +67,7 @@ void physics_tick(physics_t *p, double dt) {
         if (m->is_static || m->is_at_rest) {
             continue;
         }
+
         // integrate linear velocity
         vec3 dv;
         vec3_multiply_f(&dv, &m->velocity, dt);
@@ -78,6 +79,8 @@ void physics_tick(physics_t *p, double dt) {
         quat q;
         quat_from_euler_angles(&q, &dw);
         transform_rotate(&m->transform, &q);
+
+        p->substances[i].version.fetch_add(1, std::memory_order_release);
     }
 
     // attempt to put substances to sleep
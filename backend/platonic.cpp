@@ -47,3 +47,44 @@ double sdf_octahedron(void *data, const vec3 *x) {
     vec3 r = {{q.x, q.y - s + k, q.z - k}};
     return vec3_length(&r);
 }
+
+void sdf_cuboid_interval(void *data, const bound3_t *x, interval_t *phi) {
+    vec3 *r = (vec3 *)data;
+
+    interval_t q[3];
+    for (int i = 0; i < 3; i++) {
+        interval_from_bound(&q[i], x, i);
+        interval_abs(&q[i], &q[i]);
+        interval_subtract_f(&q[i], &q[i], r->v[i]);
+    }
+
+    interval_t m = q[0];
+    for (int i = 1; i < 3; i++) {
+        interval_max(&m, &m, &q[i]);
+    }
+    interval_min_f(&m, &m, 0.0);
+
+    for (int i = 0; i < 3; i++) {
+        interval_max_f(&q[i], &q[i], 0.0);
+    }
+
+    interval_length(phi, q, 3);
+    interval_add(phi, phi, &m);
+}
+
+void sdf_cuboid_bound(void *data, bound3_t *bound, sphere_t *sphere) {
+    vec3 *r = (vec3 *)data;
+    vec3_negative(&bound->lower, r);
+    bound->upper = *r;
+    sphere->c = vec3_zero;
+    sphere->r = vec3_length(r);
+}
+
+void sdf_octahedron_bound(void *data, bound3_t *bound, sphere_t *sphere) {
+    double e = *((double *)data);
+    double s = e / sqrt(2);
+    bound->lower = {{-s, -s, -s}};
+    bound->upper = {{s, s, s}};
+    sphere->c = vec3_zero;
+    sphere->r = s;
+}
@@ -6,4 +6,9 @@
 double sdf_cuboid(void *data, const vec3 *x);
 double sdf_octahedron(void *data, const vec3 *x);
 
+void sdf_cuboid_interval(void *data, const bound3_t *x, interval_t *phi);
+
+void sdf_cuboid_bound(void *data, bound3_t *bound, sphere_t *sphere);
+void sdf_octahedron_bound(void *data, bound3_t *bound, sphere_t *sphere);
+
 #endif
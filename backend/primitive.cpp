@@ -14,3 +14,48 @@ double sdf_torus(void *data, const vec3 *x) {
     xy.y = x->y;
     return hypot(xy.x, xy.y) - rs[1];
 }
+
+void sdf_sphere_interval(void *data, const bound3_t *x, interval_t *phi) {
+    double r = *((double *)data);
+
+    interval_t xs[3];
+    for (int i = 0; i < 3; i++) {
+        interval_from_bound(&xs[i], x, i);
+    }
+
+    interval_length(phi, xs, 3);
+    interval_subtract_f(phi, phi, r);
+}
+
+void sdf_torus_interval(void *data, const bound3_t *x, interval_t *phi) {
+    double *rs = (double *)data;
+
+    interval_t xz[2];
+    interval_from_bound(&xz[0], x, 0);
+    interval_from_bound(&xz[1], x, 2);
+
+    interval_t xy[2];
+    interval_length(&xy[0], xz, 2);
+    interval_subtract_f(&xy[0], &xy[0], rs[0]);
+    interval_from_bound(&xy[1], x, 1);
+
+    interval_length(phi, xy, 2);
+    interval_subtract_f(phi, phi, rs[1]);
+}
+
+void sdf_sphere_bound(void *data, bound3_t *bound, sphere_t *sphere) {
+    double r = *((double *)data);
+    bound->lower = {{-r, -r, -r}};
+    bound->upper = {{r, r, r}};
+    sphere->c = vec3_zero;
+    sphere->r = r;
+}
+
+void sdf_torus_bound(void *data, bound3_t *bound, sphere_t *sphere) {
+    double *rs = (double *)data;
+    double r = rs[0] + rs[1];
+    bound->lower = {{-r, -rs[1], -r}};
+    bound->upper = {{r, rs[1], r}};
+    sphere->c = vec3_zero;
+    sphere->r = r;
+}
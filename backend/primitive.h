@@ -2,8 +2,16 @@
 #define SERAPHIM_PRIMITIVE_H
 
 #include "../common/maths.h"
+#include "../common/interval.h"
+#include "../common/sphere.h"
 
 double sdf_sphere(void *data, const vec3 *x);
 double sdf_torus(void *data, const vec3 *x);
 
+void sdf_sphere_interval(void *data, const bound3_t *x, interval_t *phi);
+void sdf_torus_interval(void *data, const bound3_t *x, interval_t *phi);
+
+void sdf_sphere_bound(void *data, bound3_t *bound, sphere_t *sphere);
+void sdf_torus_bound(void *data, bound3_t *bound, sphere_t *sphere);
+
 #endif
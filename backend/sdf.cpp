@@ -1,15 +1,87 @@
 #include "sdf.h"
 
 #include "../common/seraphim.h"
+#include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <queue>
 
-#include "../common/random.h"
 #include "../common/sphere.h"
 
 #include "../common/constant.h"
+#include "integrate.h"
+#include "mesh.h"
+#include "platonic.h"
+#include "primitive.h"
+
+typedef struct primitive_t {
+    const char *name;
+    sdf_func_t distance_function;
+    sdf_interval_func_t interval_function;
+    sdf_bound_func_t bound_function;
+
+    // bytes of parameters the data points to, or zero if they can't be copied
+    size_t data_size;
+} primitive_t;
+
+static const primitive_t primitives[] = {
+    {"sphere", sdf_sphere, sdf_sphere_interval, sdf_sphere_bound, sizeof(double)},
+    {"torus", sdf_torus, sdf_torus_interval, sdf_torus_bound, 2 * sizeof(double)},
+    {"cuboid", sdf_cuboid, sdf_cuboid_interval, sdf_cuboid_bound, sizeof(vec3)},
+    {"octahedron", sdf_octahedron, NULL, sdf_octahedron_bound, sizeof(double)},
+    {"mesh", mesh_sdf_distance, NULL, mesh_sdf_bound, 0},
+};
+
+static const primitive_t *primitive_find(sdf_func_t phi) {
+    for (size_t i = 0; i < sizeof(primitives) / sizeof(*primitives); i++) {
+        if (primitives[i].distance_function == phi) {
+            return &primitives[i];
+        }
+    }
+
+    return NULL;
+}
+
+// finds the name and parameters of a primitive sdf, which are enough to create
+// it again elsewhere. returns false for sdfs that are not primitives, or whose
+// parameters can't be copied.
+bool sdf_describe(sdf_t *sdf, sdf_description_t *description) {
+    const primitive_t *primitive = primitive_find(sdf->distance_function);
+    if (primitive == NULL || primitive->data_size == 0) {
+        return false;
+    }
+
+    description->name = primitive->name;
+    description->data = sdf->data;
+    description->data_size = primitive->data_size;
+    return true;
+}
+
+// creates a primitive sdf from its name, returning false if there is none by
+// that name. the data must hold the parameters given by sdf_describe.
+bool sdf_create_described(uint32_t id, sdf_t *sdf, const char *name, void *data) {
+    for (size_t i = 0; i < sizeof(primitives) / sizeof(*primitives); i++) {
+        if (primitives[i].data_size > 0 && strcmp(primitives[i].name, name) == 0) {
+            sdf_create(id, sdf, primitives[i].distance_function, data);
+            return true;
+        }
+    }
+
+    return false;
+}
 
 void sdf_create(uint32_t id, sdf_t *sdf, sdf_func_t phi, void *data) {
     sdf->distance_function = phi;
+    sdf->interval_function = NULL;
+    sdf->bound_function = NULL;
+
+    const primitive_t *primitive = primitive_find(phi);
+    if (primitive != NULL) {
+        sdf->interval_function = primitive->interval_function;
+        sdf->bound_function = primitive->bound_function;
+    }
+
     sdf->data = data;
     sdf->id = id;
 
@@ -18,78 +90,176 @@ void sdf_create(uint32_t id, sdf_t *sdf, sdf_func_t phi, void *data) {
     sdf->is_inertia_tensor_valid = false;
     sdf->volume = -1.0;
     sdf->is_convex = false;
-
-    // TODO: improve CoM calculation and remove this
-    sdf->com = vec3_zero;
-    sdf->is_com_valid = true;
 }
 
 double sdf_distance(sdf_t *sdf, const vec3 *x) {
     return sdf->distance_function(sdf->data, x);
 }
 
+void sdf_distance_interval(sdf_t *sdf, const bound3_t *x, interval_t *phi) {
+    if (sdf->interval_function != NULL) {
+        sdf->interval_function(sdf->data, x, phi);
+        return;
+    }
+
+    // distance functions are 1-lipschitz, so the distance anywhere in the box
+    // is within the radius of the distance at the midpoint
+    vec3 midpoint, radius;
+    bound3_midpoint(x, &midpoint);
+    bound3_radius(x, &radius);
+    double r = vec3_length(&radius);
+    double p = sdf_distance(sdf, &midpoint);
+
+    phi->lower = p - r;
+    phi->upper = p + r;
+}
+
+// estimates the gradient from four samples at the vertices of a tetrahedron
 vec3 sdf_normal(sdf_t *sdf, const vec3 *x) {
-    vec3 n;
-    for (int i = 0; i < 3; i++) {
-        vec3 x1 = *x;
-        x1.v[i] += epsilon;
+    static const vec3 ks[4] = {
+        {{1.0, -1.0, -1.0}},
+        {{-1.0, -1.0, 1.0}},
+        {{-1.0, 1.0, -1.0}},
+        {{1.0, 1.0, 1.0}},
+    };
 
-        vec3 x2 = *x;
-        x2.v[i] -= epsilon;
+    vec3 n = vec3_zero;
+    for (int i = 0; i < 4; i++) {
+        vec3 x1;
+        vec3_multiply_f(&x1, &ks[i], epsilon);
+        vec3_add(&x1, &x1, x);
 
-        n.v[i] = sdf_distance(sdf, &x1) - sdf_distance(sdf, &x2);
+        vec3 k;
+        vec3_multiply_f(&k, &ks[i], sdf_distance(sdf, &x1));
+        vec3_add(&n, &n, &k);
     }
 
-    vec3_multiply_f(&n, &n, 0.5 / epsilon);
+    vec3_multiply_f(&n, &n, 0.25 / epsilon);
 
     return n;
 }
 
 bool sdf_contains(sdf_t *sdf, const vec3 *x) {
-    return bound3_contains(&sdf->bound, x) && sdf_distance(sdf, x) <= 0.0;
+    return bound3_contains(sdf_bound(sdf), x) && sdf_distance(sdf, x) <= 0.0;
+}
+
+typedef struct bound_candidate_t {
+    bound3_t bound;
+    double extent;
+    double volume;
+
+    bool operator<(const bound_candidate_t &other) const {
+        if (extent != other.extent) {
+            return extent < other.extent;
+        }
+
+        // prefer refining the smaller of two equally extreme boxes, which keeps
+        // the search depth first along flat faces
+        return volume > other.volume;
+    }
+} bound_candidate_t;
+
+static void bound_candidate_create(bound_candidate_t *candidate, const bound3_t *bound,
+                                   int axis, double sign) {
+    candidate->bound = *bound;
+    candidate->extent = sign > 0.0 ? bound->upper.v[axis] : -bound->lower.v[axis];
+    candidate->volume = bound3_volume(bound);
 }
 
-double sdf_project(sdf_t *sdf, const vec3 *d) {
-    vec3 x;
-    vec3_normalize(&x, d);
-    vec3_multiply_f(&x, &x, rho);
+// finds the furthest extent of the sdf along the given axis by branch and bound.
+// boxes are refined in order of how far they reach, boxes which the distance
+// interval shows to be outside are discarded, and box midpoints found to be
+// inside give a lower limit on the extent. the returned extent is never less
+// than the true extent.
+static double sdf_extent(sdf_t *sdf, int axis, double sign) {
+    bound3_t root;
+    root.lower = {{-rho, -rho, -rho}};
+    root.upper = {{rho, rho, rho}};
+
+    bound_candidate_t root_candidate;
+    bound_candidate_create(&root_candidate, &root, axis, sign);
+
+    std::priority_queue<bound_candidate_t> candidates;
+    candidates.push(root_candidate);
 
-    while (true) {
-        double p = sdf_distance(sdf, &x);
+    double inside_extent = -rho;
+
+    for (int i = 0; i < SERAPHIM_SDF_BOUND_MAX_ITERATIONS && !candidates.empty(); i++) {
+        bound_candidate_t candidate = candidates.top();
+        candidates.pop();
+
+        if (candidate.extent - inside_extent <= epsilon) {
+            return candidate.extent;
+        }
+
+        interval_t phi;
+        sdf_distance_interval(sdf, &candidate.bound, &phi);
+        if (interval_is_positive(&phi)) {
+            continue;
+        }
 
-        // TODO: better quit criteria
-        if (p > rho) {
-            return vec3_length(&x) - p;
+        if (interval_is_non_positive(&phi)) {
+            return candidate.extent;
         }
 
-        vec3_multiply_f(&x, &x, 2.0);
+        // everything within the distance of an inside point is also inside
+        vec3 midpoint;
+        bound3_midpoint(&candidate.bound, &midpoint);
+        double p = sdf_distance(sdf, &midpoint);
+        if (p <= 0.0) {
+            inside_extent = fmax(inside_extent, sign * midpoint.v[axis] - p);
+        }
+
+        bound3_t sub_bounds[2];
+        bound3_bisect(&candidate.bound, sub_bounds);
+        for (int j = 0; j < 2; j++) {
+            bound_candidate_t sub_candidate;
+            bound_candidate_create(&sub_candidate, &sub_bounds[j], axis, sign);
+            candidates.push(sub_candidate);
+        }
+    }
+
+    if (candidates.empty()) {
+        return inside_extent;
     }
+
+    return candidates.top().extent;
+}
+
+static void sdf_integrate(sdf_t *sdf) {
+    mass_properties_t properties;
+    integrate_mass_properties(sdf, sdf_bound(sdf), SERAPHIM_SDF_INTEGRATION_TOLERANCE,
+                              &properties);
+
+    sdf->volume = properties.volume;
+    sdf->com = properties.com;
+    sdf->inertia_tensor = properties.inertia_tensor;
+    sdf->is_com_valid = true;
+    sdf->is_inertia_tensor_valid = true;
 }
 
 double sdf_volume(sdf_t *sdf) {
     if (sdf->volume < 0.0) {
-        int hits = 0;
+        sdf_integrate(sdf);
+    }
 
-        bound3_t *b = sdf_bound(sdf);
-        random_t rng;
-        srph_random_default_seed(&rng);
+    return sdf->volume;
+}
 
-        while (hits < SERAPHIM_SDF_VOLUME_SAMPLES) {
-            vec3 x;
-            x.x = srph_random_f64_range(&rng, b->lower.x, b->upper.x);
-            x.y = srph_random_f64_range(&rng, b->lower.y, b->upper.y);
-            x.z = srph_random_f64_range(&rng, b->lower.z, b->upper.z);
+vec3 *sdf_com(sdf_t *sdf) {
+    if (!sdf->is_com_valid) {
+        sdf_integrate(sdf);
+    }
 
-            if (sdf_contains(sdf, &x)) {
-                hits++;
-            }
-        }
+    return &sdf->com;
+}
 
-        sdf->volume = bound3_volume(b) * (double)hits /
-                      (double)SERAPHIM_SDF_VOLUME_SAMPLES;
+mat3 *sdf_inertia_tensor(sdf_t *sdf) {
+    if (!sdf->is_inertia_tensor_valid) {
+        sdf_integrate(sdf);
     }
 
-    return sdf->volume;
+    return &sdf->inertia_tensor;
 }
 
 bound3_t *sdf_bound(sdf_t *sdf) {
@@ -98,15 +268,18 @@ bound3_t *sdf_bound(sdf_t *sdf) {
     }
 
     if (!sdf->is_bound_valid) {
-        vec3 a;
-        for (int i = 0; i < 3; i++) {
-            a = vec3_zero;
-
-            a.v[i] = -1.0;
-            sdf->bound.lower.v[i] = -sdf_project(sdf, &a);
+        if (sdf->bound_function != NULL) {
+            sdf->bound_function(sdf->data, &sdf->bound, &sdf->bounding_sphere);
+        } else {
+            for (int i = 0; i < 3; i++) {
+                sdf->bound.lower.v[i] = -sdf_extent(sdf, i, -1.0);
+                sdf->bound.upper.v[i] = sdf_extent(sdf, i, 1.0);
+            }
 
-            a.v[i] = 1.0;
-            sdf->bound.upper.v[i] = sdf_project(sdf, &a);
+            vec3 radius;
+            bound3_midpoint(&sdf->bound, &sdf->bounding_sphere.c);
+            bound3_radius(&sdf->bound, &radius);
+            sdf->bounding_sphere.r = vec3_length(&radius);
         }
 
         sdf->is_bound_valid = true;
@@ -115,6 +288,11 @@ bound3_t *sdf_bound(sdf_t *sdf) {
     return &sdf->bound;
 }
 
+sphere_t *sdf_bounding_sphere(sdf_t *sdf) {
+    sdf_bound(sdf);
+    return &sdf->bounding_sphere;
+}
+
 double sdf_discontinuity(sdf_t *sdf, const vec3 *x) {
     vec3 ns[3];
 
@@ -135,45 +313,105 @@ double sdf_discontinuity(sdf_t *sdf, const vec3 *x) {
 }
 
 void sdf_raycast(sdf_t *self, ray_t *ray, intersection_t *intersection) {
-    ray_t r = *ray;
+    sdf_raycast_packet(self, ray, 1, intersection);
+}
+
+// marches the rays in lockstep using over-relaxed sphere tracing. each ray steps
+// further than the distance to the surface until the unbounding spheres of two
+// consecutive samples stop overlapping, at which point it may have skipped the
+// surface, so it returns to the last safe step and continues unrelaxed.
+void sdf_raycast_packet(sdf_t *self, ray_t *rays, int count, intersection_t *intersections) {
+    assert(count <= SERAPHIM_SDF_PACKET_SIZE);
+
+    double t[SERAPHIM_SDF_PACKET_SIZE];
+    double omega[SERAPHIM_SDF_PACKET_SIZE];
+    double previous_t[SERAPHIM_SDF_PACKET_SIZE];
+    double previous_distance[SERAPHIM_SDF_PACKET_SIZE];
+    double min_distance[SERAPHIM_SDF_PACKET_SIZE];
+    double distance[SERAPHIM_SDF_PACKET_SIZE];
+    bool is_active[SERAPHIM_SDF_PACKET_SIZE];
+
+    for (int i = 0; i < count; i++) {
+        t[i] = 0.0;
+        omega[i] = SERAPHIM_SDF_RAYCAST_RELAXATION;
+        previous_t[i] = 0.0;
+        previous_distance[i] = 0.0;
+        min_distance[i] = rho;
+        is_active[i] = true;
+    }
+
+    for (int step = 0; step < SERAPHIM_SDF_RAYCAST_MAX_STEPS; step++) {
+        bool is_any_active = false;
+
+        for (int i = 0; i < count; i++) {
+            if (is_active[i]) {
+                vec3 x;
+                vec3_multiply_f(&x, &rays[i].direction, t[i]);
+                vec3_add(&x, &x, &rays[i].position);
+                distance[i] = sdf_distance(self, &x);
+            }
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (!is_active[i]) {
+                continue;
+            }
+
+            if (omega[i] > 1.0 &&
+                fabs(distance[i]) + previous_distance[i] < t[i] - previous_t[i]) {
+                t[i] = previous_t[i] + previous_distance[i];
+                omega[i] = 1.0;
+                is_any_active = true;
+                continue;
+            }
+
+            min_distance[i] = fmin(min_distance[i], distance[i]);
+
+            if (distance[i] < epsilon || distance[i] >= rho) {
+                is_active[i] = false;
+                continue;
+            }
 
-    vec3 step;
-    double min_distance = rho;
-    while (true){
-        double distance = sdf_distance(self, &r.position);
-        min_distance = fmin(min_distance, distance);
+            previous_t[i] = t[i];
+            previous_distance[i] = distance[i];
+            t[i] += omega[i] * distance[i];
+            is_any_active = true;
+        }
 
-        if (distance < epsilon || distance >= rho){
+        if (!is_any_active) {
             break;
         }
+    }
 
-        vec3_multiply_f(&step, &r.direction, distance);
-        vec3_add(&r.position, &r.position, &step);
-    }
-
-    vec3f position = {{
-          .x = (float) r.position.x,
-          .y = (float) r.position.y,
-          .z = (float) r.position.z,
-    }};
-
-    vec3f direction = {{
-           .x = (float) r.direction.x,
-           .y = (float) r.direction.y,
-           .z = (float) r.direction.z,
-    }};
-
-    vec3 normal = sdf_normal(self, &r.position);
-    vec3f normal_f = {{
-          .x = (float) normal.x,
-          .y = (float) normal.y,
-          .z = (float) normal.z,
-    }};
-
-    *intersection = {
-            .position = position,
-            .distance = (float) min_distance,
-            .direction = direction,
-            .normal = normal_f,
-    };
+    for (int i = 0; i < count; i++) {
+        vec3 x;
+        vec3_multiply_f(&x, &rays[i].direction, t[i]);
+        vec3_add(&x, &x, &rays[i].position);
+
+        vec3f position = {{
+              .x = (float) x.x,
+              .y = (float) x.y,
+              .z = (float) x.z,
+        }};
+
+        vec3f direction = {{
+               .x = (float) rays[i].direction.x,
+               .y = (float) rays[i].direction.y,
+               .z = (float) rays[i].direction.z,
+        }};
+
+        vec3 normal = sdf_normal(self, &x);
+        vec3f normal_f = {{
+              .x = (float) normal.x,
+              .y = (float) normal.y,
+              .z = (float) normal.z,
+        }};
+
+        intersections[i] = {
+                .position = position,
+                .distance = (float) min_distance[i],
+                .direction = direction,
+                .normal = normal_f,
+        };
+    }
 }
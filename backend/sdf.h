@@ -5,10 +5,24 @@
 
 #include "../common/maths.h"
 #include "../common/bound.h"
+#include "../common/interval.h"
 #include "../common/sphere.h"
 
 #define SERAPHIM_SDF_VOLUME_SAMPLES 10000
 
+// fraction of the volume that may be estimated rather than integrated exactly
+#define SERAPHIM_SDF_INTEGRATION_TOLERANCE 0.001
+
+// over-relaxation factor for sphere tracing and the step limit per ray
+#define SERAPHIM_SDF_RAYCAST_RELAXATION 1.6
+#define SERAPHIM_SDF_RAYCAST_MAX_STEPS 256
+
+// largest number of rays that are marched together
+#define SERAPHIM_SDF_PACKET_SIZE 8
+
+// boxes refined while searching for the bound of an sdf without an analytic one
+#define SERAPHIM_SDF_BOUND_MAX_ITERATIONS 100000
+
 typedef struct ray_t {
     vec3 position;
     vec3 direction;
@@ -27,6 +41,18 @@ typedef struct intersection_t {
 
 typedef double (*sdf_func_t)(void *data, const vec3 *x);
 
+// bounds the distance over every point in an axis aligned box
+typedef void (*sdf_interval_func_t)(void *data, const bound3_t *x, interval_t *phi);
+
+// finds the exact bound and bounding sphere of the region where the sdf is negative
+typedef void (*sdf_bound_func_t)(void *data, bound3_t *bound, sphere_t *sphere);
+
+typedef struct sdf_description_t {
+    const char *name;
+    const void *data;
+    size_t data_size;
+} sdf_description_t;
+
 typedef struct sdf_t {
     uint32_t id;
 
@@ -34,6 +60,7 @@ typedef struct sdf_t {
 
     bool is_bound_valid;
     bound3_t bound;
+    sphere_t bounding_sphere;
 
     double volume;
 
@@ -44,17 +71,25 @@ typedef struct sdf_t {
 
     void *data;
     sdf_func_t distance_function;
+    sdf_interval_func_t interval_function;
+    sdf_bound_func_t bound_function;
 } sdf_t;
 
 void sdf_create(uint32_t id, sdf_t *sdf, sdf_func_t phi, void *data);
+bool sdf_describe(sdf_t *sdf, sdf_description_t *description);
+bool sdf_create_described(uint32_t id, sdf_t *sdf, const char *name, void *data);
 
 double sdf_distance(sdf_t *sdf, const vec3 *x);
+void sdf_distance_interval(sdf_t *sdf, const bound3_t *x, interval_t *phi);
 vec3 sdf_normal(sdf_t *sdf, const vec3 *x);
 double sdf_volume(sdf_t *sdf);
-double sdf_project(sdf_t *sdf, const vec3 *d);
+vec3 *sdf_com(sdf_t *sdf);
+mat3 *sdf_inertia_tensor(sdf_t *sdf);
 bool sdf_contains(sdf_t *sdf, const vec3 *x);
 bound3_t *sdf_bound(sdf_t *sdf);
+sphere_t *sdf_bounding_sphere(sdf_t *sdf);
 double sdf_discontinuity(sdf_t *sdf, const vec3 *x);
 
 void sdf_raycast(sdf_t *self, ray_t * ray, intersection_t * intersection);
+void sdf_raycast_packet(sdf_t *self, ray_t *rays, int count, intersection_t *intersections);
 #endif
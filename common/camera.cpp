@@ -1,8 +1,11 @@
 #include "camera.h"
+#include "file.h"
 
 #include <assert.h>
 #include <math.h>
 
+#include <algorithm>
+
 void camera_transformation_matrix(camera_t *camera, float *xs) {
     assert(camera != NULL && xs != NULL);
     mat4 dxs;
@@ -15,6 +18,7 @@ void camera_transformation_matrix(camera_t *camera, float *xs) {
 
 void camera_update(camera_t *camera, double delta, const keyboard_t &keyboard, const mouse_t &mouse) {
     double scale = 2000.0;
+    vec3 previous_position = camera->transform.position;
 
     quat q;
     quat_from_axis_angle(&q, &vec3_up, delta * mouse.velocity.x / scale);
@@ -56,9 +60,102 @@ void camera_update(camera_t *camera, double delta, const keyboard_t &keyboard, c
         vec3_multiply_f(&d, &move_right, -delta);
         transform_translate(&camera->transform, &d);
     }
+
+    if (delta > 0.0) {
+        vec3_subtract(&camera->velocity, &camera->transform.position, &previous_position);
+        vec3_divide_f(&camera->velocity, &camera->velocity, delta);
+    }
 }
 
 void camera_create(camera_t *camera) {
     camera->transform.position = {{0.0, 0.5, -5.0}};
     camera->transform.rotation = quat_identity;
+    camera->velocity = vec3_zero;
+}
+
+static double camera_json_number(const cJSON *object, const char *name, double value) {
+    const cJSON *number = cJSON_GetObjectItem(object, name);
+    return number != NULL && cJSON_IsNumber(number) ? number->valuedouble : value;
+}
+
+// reads a path from a json array of keyframes, each of the form
+// {"time": 0.0, "position": [0.0, 0.5, -5.0], "yaw": 0.0, "pitch": 0.0}
+bool camera_path_load(camera_path_t *path, const char *filename) {
+    cJSON *path_json = file_load_json(filename);
+    if (path_json == NULL || !cJSON_IsArray(path_json)) {
+        cJSON_Delete(path_json);
+        return false;
+    }
+
+    path->keyframes.clear();
+
+    const cJSON *keyframe_json;
+    cJSON_ArrayForEach(keyframe_json, path_json) {
+        camera_keyframe_t keyframe;
+        keyframe.time = camera_json_number(keyframe_json, "time", 0.0);
+        keyframe.yaw = camera_json_number(keyframe_json, "yaw", 0.0);
+        keyframe.pitch = camera_json_number(keyframe_json, "pitch", 0.0);
+        keyframe.position = vec3_zero;
+
+        const cJSON *position_json = cJSON_GetObjectItem(keyframe_json, "position");
+        if (position_json != NULL && cJSON_GetArraySize(position_json) == 3) {
+            for (int i = 0; i < 3; i++) {
+                keyframe.position.v[i] = cJSON_GetArrayItem(position_json, i)->valuedouble;
+            }
+        }
+
+        path->keyframes.push_back(keyframe);
+    }
+    cJSON_Delete(path_json);
+
+    std::stable_sort(path->keyframes.begin(), path->keyframes.end(),
+                     [](const camera_keyframe_t &a, const camera_keyframe_t &b) { return a.time < b.time; });
+    return true;
+}
+
+// places the camera where the path is at time, holding the first and last
+// keyframes before and after the path. the velocity is taken from where the
+// camera was delta seconds before.
+void camera_path_follow(camera_t *camera, const camera_path_t *path, double time, double delta) {
+    if (path->keyframes.empty()) {
+        camera->velocity = vec3_zero;
+        return;
+    }
+
+    const std::vector<camera_keyframe_t> &keyframes = path->keyframes;
+    size_t next = 0;
+    while (next < keyframes.size() && keyframes[next].time <= time) {
+        next++;
+    }
+
+    const camera_keyframe_t *a = &keyframes[next == 0 ? 0 : next - 1];
+    const camera_keyframe_t *b = &keyframes[std::min(next, keyframes.size() - 1)];
+    double t = b->time > a->time ? (time - a->time) / (b->time - a->time) : 0.0;
+    t = clampf(t, 0.0, 1.0);
+
+    vec3 previous_position = camera->transform.position;
+
+    vec3 d;
+    vec3_subtract(&d, &b->position, &a->position);
+    vec3_multiply_f(&d, &d, t);
+    vec3_add(&camera->transform.position, &a->position, &d);
+
+    double yaw = a->yaw + (b->yaw - a->yaw) * t;
+    double pitch = a->pitch + (b->pitch - a->pitch) * t;
+
+    camera->transform.rotation = quat_identity;
+
+    quat q;
+    quat_from_axis_angle(&q, &vec3_up, to_radians(yaw));
+    transform_rotate(&camera->transform, &q);
+
+    vec3 right;
+    transform_right(&camera->transform, &right);
+    quat_from_axis_angle(&q, &right, to_radians(pitch));
+    transform_rotate(&camera->transform, &q);
+
+    if (delta > 0.0) {
+        vec3_subtract(&camera->velocity, &camera->transform.position, &previous_position);
+        vec3_divide_f(&camera->velocity, &camera->velocity, delta);
+    }
 }
@@ -4,12 +4,32 @@
 #include "transform.h"
 #include "../frontend/ui.h"
 
+#include <vector>
+
 typedef struct camera_t {
     transform_t transform;
+    vec3 velocity;
 } camera_t;
 
+// a place that a scripted camera passes through at a time in seconds, turned
+// by yaw degrees around the up axis and then pitched by pitch degrees
+typedef struct camera_keyframe_t {
+    double time;
+    vec3 position;
+    double yaw;
+    double pitch;
+} camera_keyframe_t;
+
+// keyframes in order of time, which the camera moves between in straight lines
+typedef struct camera_path_t {
+    std::vector<camera_keyframe_t> keyframes;
+} camera_path_t;
+
 void camera_create(camera_t * camera);
 void camera_transformation_matrix(camera_t *camera, float *xs);
 void camera_update(camera_t *camera, double delta, const keyboard_t &keyboard, const mouse_t &mouse);
 
+bool camera_path_load(camera_path_t *path, const char *filename);
+void camera_path_follow(camera_t *camera, const camera_path_t *path, double time, double delta);
+
 #endif
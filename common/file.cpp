@@ -26,9 +26,55 @@ char *file_load_text(const char *filename) {
     return string;
 }
 
+uint8_t *file_load_binary(const char *filename, size_t *size) {
+    FILE *file = fopen(filename, "rb");
+
+    if (file == NULL) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    // terminated so that text formats can be parsed in place
+    uint8_t *bytes = (uint8_t *)malloc(*size + 1);
+    *size = fread(bytes, 1, *size, file);
+    bytes[*size] = '\0';
+
+    fclose(file);
+    return bytes;
+}
+
 cJSON *file_load_json(const char *filename) {
     char *string = file_load_text(filename);
     cJSON *parsed_json = cJSON_Parse(string);
     free(string);
     return parsed_json;
 }
+
+// writes rows of rgba pixels, from the top, as a binary ppm without the alpha
+bool file_save_ppm(const char *filename, uint32_t width, uint32_t height, const uint8_t *rgba) {
+    FILE *file = fopen(filename, "wb");
+
+    if (file == NULL) {
+        return false;
+    }
+
+    fprintf(file, "P6\n%u %u\n255\n", width, height);
+
+    uint8_t *row = (uint8_t *)malloc(3 * (size_t) width);
+    bool is_written = true;
+    for (uint32_t y = 0; y < height && is_written; y++) {
+        const uint8_t *pixels = rgba + 4 * (size_t) width * y;
+        for (uint32_t x = 0; x < width; x++) {
+            row[3 * x] = pixels[4 * x];
+            row[3 * x + 1] = pixels[4 * x + 1];
+            row[3 * x + 2] = pixels[4 * x + 2];
+        }
+        is_written = fwrite(row, 3, width, file) == width;
+    }
+    free(row);
+
+    return fclose(file) == 0 && is_written;
+}
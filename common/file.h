@@ -7,7 +7,12 @@
 
 #include "cJSON.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
 char *file_load_text(const char *filename);
+uint8_t *file_load_binary(const char *filename, size_t *size);
 cJSON *file_load_json(const char *filename);
+bool file_save_ppm(const char *filename, uint32_t width, uint32_t height, const uint8_t *rgba);
 
 #endif // SERAPHIM_FILE_H
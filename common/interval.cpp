@@ -0,0 +1,91 @@
+#include "interval.h"
+
+#include <math.h>
+
+void interval_from_bound(interval_t *result, const bound3_t *b, int axis) {
+    result->lower = b->lower.v[axis];
+    result->upper = b->upper.v[axis];
+}
+
+void interval_add(interval_t *result, const interval_t *a, const interval_t *b) {
+    result->lower = a->lower + b->lower;
+    result->upper = a->upper + b->upper;
+}
+
+void interval_add_f(interval_t *result, const interval_t *a, double f) {
+    result->lower = a->lower + f;
+    result->upper = a->upper + f;
+}
+
+void interval_subtract_f(interval_t *result, const interval_t *a, double f) {
+    interval_add_f(result, a, -f);
+}
+
+void interval_multiply_f(interval_t *result, const interval_t *a, double f) {
+    double lower = a->lower * f;
+    double upper = a->upper * f;
+    result->lower = fmin(lower, upper);
+    result->upper = fmax(lower, upper);
+}
+
+void interval_abs(interval_t *result, const interval_t *a) {
+    double lower = interval_mignitude(a);
+    double upper = interval_magnitude(a);
+    result->lower = lower;
+    result->upper = upper;
+}
+
+void interval_min(interval_t *result, const interval_t *a, const interval_t *b) {
+    result->lower = fmin(a->lower, b->lower);
+    result->upper = fmin(a->upper, b->upper);
+}
+
+void interval_max(interval_t *result, const interval_t *a, const interval_t *b) {
+    result->lower = fmax(a->lower, b->lower);
+    result->upper = fmax(a->upper, b->upper);
+}
+
+void interval_min_f(interval_t *result, const interval_t *a, double f) {
+    result->lower = fmin(a->lower, f);
+    result->upper = fmin(a->upper, f);
+}
+
+void interval_max_f(interval_t *result, const interval_t *a, double f) {
+    result->lower = fmax(a->lower, f);
+    result->upper = fmax(a->upper, f);
+}
+
+// bounds the euclidean length of a vector whose components lie in the given
+// intervals
+void interval_length(interval_t *result, const interval_t *xs, int n) {
+    double lower = 0.0;
+    double upper = 0.0;
+
+    for (int i = 0; i < n; i++) {
+        double mig = interval_mignitude(&xs[i]);
+        double mag = interval_magnitude(&xs[i]);
+        lower += mig * mig;
+        upper += mag * mag;
+    }
+
+    result->lower = sqrt(lower);
+    result->upper = sqrt(upper);
+}
+
+// largest absolute value in the interval
+double interval_magnitude(const interval_t *a) {
+    return fmax(fabs(a->lower), fabs(a->upper));
+}
+
+// smallest absolute value in the interval
+double interval_mignitude(const interval_t *a) {
+    if (a->lower <= 0.0 && a->upper >= 0.0) {
+        return 0.0;
+    }
+
+    return fmin(fabs(a->lower), fabs(a->upper));
+}
+
+bool interval_is_positive(const interval_t *a) { return a->lower > 0.0; }
+
+bool interval_is_non_positive(const interval_t *a) { return a->upper <= 0.0; }
@@ -0,0 +1,29 @@
+#ifndef SERAPHIM_INTERVAL_H
+#define SERAPHIM_INTERVAL_H
+
+#include "bound.h"
+
+typedef struct interval_t {
+    double lower;
+    double upper;
+} interval_t;
+
+void interval_from_bound(interval_t *result, const bound3_t *b, int axis);
+
+void interval_add(interval_t *result, const interval_t *a, const interval_t *b);
+void interval_add_f(interval_t *result, const interval_t *a, double f);
+void interval_subtract_f(interval_t *result, const interval_t *a, double f);
+void interval_multiply_f(interval_t *result, const interval_t *a, double f);
+void interval_abs(interval_t *result, const interval_t *a);
+void interval_min(interval_t *result, const interval_t *a, const interval_t *b);
+void interval_max(interval_t *result, const interval_t *a, const interval_t *b);
+void interval_min_f(interval_t *result, const interval_t *a, double f);
+void interval_max_f(interval_t *result, const interval_t *a, double f);
+void interval_length(interval_t *result, const interval_t *xs, int n);
+
+double interval_magnitude(const interval_t *a);
+double interval_mignitude(const interval_t *a);
+bool interval_is_positive(const interval_t *a);
+bool interval_is_non_positive(const interval_t *a);
+
+#endif
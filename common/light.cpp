@@ -7,3 +7,9 @@ light_t::light_t(uint32_t id, vec3f *x, vec4f *colour) {
     this->colour = *colour;
     this->id = id;
 }
+
+void light_create_scene(light_t *self) {
+    vec3f x = {{ 0, 4, -4}};
+    vec4f colour = {{250, 250, 250, 250}};
+    *self = light_t(0, &x, &colour);
+}
@@ -13,4 +13,7 @@ typedef struct light_t {
     light_t(uint32_t id, vec3f *x, vec4f *colour);
 } light_t;
 
+// the light that scenes are lit by, shared by every renderer
+void light_create_scene(light_t *self);
+
 #endif
@@ -5,9 +5,25 @@
 #include "file.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <cstring>
 
-int main() {
+// with --headless <frames> [camera path] [image prefix], renders that many
+// frames without a window, following the camera path if given and saving each
+// frame's image if given a prefix. --reference takes the same arguments, but
+// renders on the cpu with the reference renderer, without a device.
+int main(int argc, char **argv) {
+    bool is_reference = argc > 2 && strcmp(argv[1], "--reference") == 0;
+    bool is_headless = is_reference || (argc > 2 && strcmp(argv[1], "--headless") == 0);
+    uint32_t number_of_frames = is_headless ? (uint32_t) atoi(argv[2]) : 0;
+    const char *image_prefix = is_headless && argc > 4 ? argv[4] : NULL;
+
+    camera_path_t camera_path;
+    if (is_headless && argc > 3 && !camera_path_load(&camera_path, argv[3])) {
+        printf("Unable to load camera path %s\n", argv[3]);
+        return 1;
+    }
+
     const char *game_filepath = "/home/millie/seraphim_game/";
     const char *json_filename = "game.json";
     char filepath[100] = {0};
@@ -22,7 +38,13 @@ int main() {
     cJSON_Delete(game_json);
 
     seraphim_t seraphim;
-    seraphim_create(&seraphim, title_string);
+    if (is_reference) {
+        seraphim_create_reference(&seraphim);
+    } else if (is_headless) {
+        seraphim_create_headless(&seraphim);
+    } else {
+        seraphim_create(&seraphim, title_string);
+    }
 
     form_t form;
 
@@ -45,7 +67,13 @@ int main() {
     matter_create(&cube_matter, cube_sdf, cube_material, &position, true, false);
     seraphim_create_substance(&seraphim, &form, &cube_matter);
 
-    seraphim_run(&seraphim);
+    if (is_reference) {
+        seraphim_run_reference(&seraphim, &camera_path, number_of_frames, image_prefix);
+    } else if (is_headless) {
+        seraphim_run_headless(&seraphim, &camera_path, number_of_frames, image_prefix);
+    } else {
+        seraphim_run(&seraphim);
+    }
 
     seraphim_destroy(&seraphim);
 
@@ -0,0 +1,35 @@
+#ifndef SERAPHIM_REQUEST_DATA_H
+#define SERAPHIM_REQUEST_DATA_H
+
+#include "maths.h"
+
+static const uint32_t null_status = 0;
+static const uint32_t geometry_request = 1;
+static const uint32_t texture_request = 2;
+static const uint32_t raycast_request = 3;
+
+// number of request statuses, including the null status
+#define SERAPHIM_REQUEST_TYPE_COUNT 4
+
+// the request buffer starts with the number of requests the shader appended,
+// padded to the alignment of request_t. the requests follow, and after them a
+// slot per request that the shader claims to avoid appending duplicates.
+#define SERAPHIM_REQUEST_HEADER_SIZE 16
+
+// requests read back when few or none were made the frame before
+#define SERAPHIM_REQUEST_MIN_READBACK 64
+
+typedef struct request_t {
+    vec3f position;
+    float radius;
+
+    uint32_t hash;
+    uint32_t sdf_id;
+    uint32_t material_id;
+    uint32_t status;
+
+    vec3f direction;
+    uint32_t _1;
+} request_t;
+
+#endif //SERAPHIM_REQUEST_DATA_H
@@ -7,8 +7,10 @@
 #include <string>
 #include <string.h>
 
+#include "../frontend/reference.h"
 #include "../frontend/renderer.h"
 #include <assert.h>
+#include "constant.h"
 #include "file.h"
 
 static bool check_validation_layers();
@@ -26,6 +28,12 @@ void seraphim_destroy(seraphim_t *engine) {
 
     physics_destroy(&engine->physics);
 
+    // the reference renderer has no device or window to destroy
+    if (engine->is_reference) {
+        printf("Seraphim engine exiting gracefully.\n");
+        return;
+    }
+
     vkDeviceWaitIdle(engine->device.device);
 
     engine->fps_cv.notify_all();
@@ -46,13 +54,17 @@ void seraphim_destroy(seraphim_t *engine) {
     }
 #endif
 
-    vkDestroySurfaceKHR(engine->instance, engine->surface, NULL);
+    if (!engine->is_headless) {
+        vkDestroySurfaceKHR(engine->instance, engine->surface, NULL);
+    }
 
     vkDestroyInstance(engine->instance, NULL);
 
-    window_destroy(&engine->window);
+    if (!engine->is_headless) {
+        window_destroy(&engine->window);
 
-    glfwTerminate();
+        glfwTerminate();
+    }
 
     printf("Seraphim engine exiting gracefully.\n");
 }
@@ -110,31 +122,21 @@ material_t *seraphim_create_material(seraphim_t *srph, const vec3 * colour) {
     return new_material;
 }
 
-void seraphim_create(seraphim_t *seraphim, const char *title) {
+static void seraphim_create_instance(seraphim_t *seraphim, bool is_headless) {
 #if SERAPHIM_DEBUG
     printf("Running in debug mode\n");
 #else
     printf("Running in release mode\n");
 #endif
 
+    seraphim->is_headless = is_headless;
+    seraphim->is_reference = false;
     seraphim->num_substances = 0;
     seraphim->num_sdfs = 0;
     seraphim->num_materials = 0;
     seraphim->work_group_count = {{48u, 20u}};
     seraphim->work_group_size = {{32u, 32u}};
 
-    if (!glfwInit()) {
-        PANIC("Error: Failed to initialise GLFW.");
-    }
-
-    vec2u window_size = {{
-         seraphim->work_group_count.x * seraphim->work_group_size.x,
-         seraphim->work_group_count.y * seraphim->work_group_size.y
-    }};
-
-    window_create(&seraphim->window, &window_size);
-    window_set_title(&seraphim->window, title);
-
     uint32_t extension_count = 0;
     vkEnumerateInstanceExtensionProperties(NULL, &extension_count, NULL);
     std::vector<VkExtensionProperties> extensions(extension_count);
@@ -155,11 +157,14 @@ void seraphim_create(seraphim_t *seraphim, const char *title) {
         PANIC("Error: Failed to setup debug callback.");
     }
 #endif
+}
 
-    if (glfwCreateWindowSurface(seraphim->instance, seraphim->window.window, NULL, &seraphim->surface) !=
-        VK_SUCCESS) {
-        PANIC("Error: Failed to create window surface.");
-    }
+// creates the device, the renderer and physics, for the surface if there is one
+static void seraphim_create_renderer(seraphim_t *seraphim) {
+    vec2u window_size = {{
+         seraphim->work_group_count.x * seraphim->work_group_size.x,
+         seraphim->work_group_count.y * seraphim->work_group_size.y
+    }};
 
     device_create(&seraphim->device, seraphim->instance, seraphim->surface, validation_layers, num_validation_layers);
 
@@ -177,13 +182,74 @@ void seraphim_create(seraphim_t *seraphim, const char *title) {
 
     camera_create(&seraphim->test_camera);
 
+    uint32_t number_of_request_workers = SERAPHIM_REQUEST_WORKERS;
+    if (number_of_request_workers == 0) {
+        uint32_t number_of_threads = std::thread::hardware_concurrency();
+        number_of_request_workers = number_of_threads > 2 ? number_of_threads - 2 : 1;
+    }
+
     renderer_create(&seraphim->renderer,
-        &seraphim->device, seraphim->substances, &seraphim->num_substances, seraphim->surface, &seraphim->window,
-        &seraphim->test_camera, &seraphim->work_group_count, &seraphim->work_group_size, max_image_size, seraphim->materials, &seraphim->num_materials, seraphim->sdfs, &seraphim->num_sdfs);
+        &seraphim->device, seraphim->substances, &seraphim->num_substances, seraphim->surface, &window_size,
+        &seraphim->test_camera, &seraphim->work_group_count, &seraphim->work_group_size, max_image_size, seraphim->materials, &seraphim->num_materials, seraphim->sdfs, &seraphim->num_sdfs,
+        number_of_request_workers);
+
+    allocator_report(&seraphim->device.allocator);
+
+    const char * capture_file = SERAPHIM_REQUEST_CAPTURE_FILE;
+    if (capture_file != NULL && !request_handler_capture(&seraphim->renderer.request_handler, capture_file)) {
+        printf("Unable to capture requests to %s\n", capture_file);
+    }
 
     physics_create(&seraphim->physics, seraphim->substances, &seraphim->num_substances);
 }
 
+void seraphim_create(seraphim_t *seraphim, const char *title) {
+    if (!glfwInit()) {
+        PANIC("Error: Failed to initialise GLFW.");
+    }
+
+    seraphim_create_instance(seraphim, false);
+
+    vec2u window_size = {{
+         seraphim->work_group_count.x * seraphim->work_group_size.x,
+         seraphim->work_group_count.y * seraphim->work_group_size.y
+    }};
+
+    window_create(&seraphim->window, &window_size);
+    window_set_title(&seraphim->window, title);
+
+    if (glfwCreateWindowSurface(seraphim->instance, seraphim->window.window, NULL, &seraphim->surface) !=
+        VK_SUCCESS) {
+        PANIC("Error: Failed to create window surface.");
+    }
+
+    seraphim_create_renderer(seraphim);
+}
+
+// creates the engine without a window or a surface, to render images that are
+// only read back
+void seraphim_create_headless(seraphim_t *seraphim) {
+    seraphim_create_instance(seraphim, true);
+    seraphim->surface = VK_NULL_HANDLE;
+
+    seraphim_create_renderer(seraphim);
+}
+
+// creates the engine without a device, to render images on the cpu with the
+// reference renderer
+void seraphim_create_reference(seraphim_t *seraphim) {
+    seraphim->is_headless = true;
+    seraphim->is_reference = true;
+    seraphim->num_substances = 0;
+    seraphim->num_sdfs = 0;
+    seraphim->num_materials = 0;
+    seraphim->work_group_count = {{48u, 20u}};
+    seraphim->work_group_size = {{32u, 32u}};
+
+    camera_create(&seraphim->test_camera);
+    physics_create(&seraphim->physics, seraphim->substances, &seraphim->num_substances);
+}
+
 void monitor_fps(seraphim_t * seraphim) {
     int interval = 1; // seconds
     seraphim->fps_monitor_quit = false;
@@ -197,18 +263,65 @@ void monitor_fps(seraphim_t * seraphim) {
         double render_fps =
                 (double) (seraphim->renderer.get_frame_count()) / interval;
 
+        request_statistics_t request_statistics;
+        request_handler_statistics(&seraphim->renderer.request_handler, &request_statistics);
+
+        frame_statistics_t frame_statistics;
+        seraphim->renderer.get_frame_statistics(&frame_statistics);
+        double frames = frame_statistics.frames > 0 ? (double) frame_statistics.frames : 1.0;
+
+        substance_list_statistics_t substance_statistics;
+        substance_list_statistics(&seraphim->renderer.substance_list, &substance_statistics);
+
+        substance_bvh_statistics_t bvh_statistics;
+        substance_bvh_statistics(&seraphim->renderer.substance_bvh, &bvh_statistics);
+
         printf("Render: %f FPS; Physics: %f FPS\n", render_fps, physics_fps);
+        printf("Frame: %.3f ms CPU (%.3f ms waiting for the GPU); %.3f ms GPU; %.3f ms GPU idle\n",
+               frame_statistics.cpu_time * 1000.0 / frames, frame_statistics.wait_time * 1000.0 / frames,
+               frame_statistics.gpu_time * 1000.0 / frames, frame_statistics.gpu_idle_time * 1000.0 / frames);
+        printf("Substances: %lu recalculated; %lu entries written\n",
+               (unsigned long) substance_statistics.recalculated, (unsigned long) substance_statistics.written);
+        printf("BVH: %lu rebuilds; %lu refits\n",
+               (unsigned long) bvh_statistics.rebuilds, (unsigned long) bvh_statistics.refits);
+        printf("Requests: %lu dispatched; %lu duplicates dropped; %lu responses not staged\n",
+               (unsigned long) request_statistics.dispatched, (unsigned long) request_statistics.dropped,
+               (unsigned long) request_statistics.unstaged);
+        printf("Response updates: %lu regions written; %lu regions copied; %lu textures waiting\n",
+               (unsigned long) request_statistics.updates.regions_written,
+               (unsigned long) request_statistics.updates.regions_copied,
+               (unsigned long) request_statistics.waiting_textures);
+        printf("Patch cache: %lu hits; %lu misses; %lu evictions\n",
+               (unsigned long) request_statistics.patches.hits, (unsigned long) request_statistics.patches.misses,
+               (unsigned long) request_statistics.patches.evictions);
+        printf("Texture cache: %lu hits; %lu misses; %lu evictions\n",
+               (unsigned long) request_statistics.textures.hits, (unsigned long) request_statistics.textures.misses,
+               (unsigned long) request_statistics.textures.evictions);
+        printf("Corner cache: %lu hits; %lu misses\n",
+               (unsigned long) request_statistics.corners.hits, (unsigned long) request_statistics.corners.misses);
+        printf("Stored patches: %lu loaded; %lu generated; stored textures: %lu loaded; %lu generated\n",
+               (unsigned long) request_statistics.patch_store.hits,
+               (unsigned long) request_statistics.patch_store.writes,
+               (unsigned long) request_statistics.texture_store.hits,
+               (unsigned long) request_statistics.texture_store.writes);
+
+        prefetch_statistics_t *prefetches = &request_statistics.prefetches;
+        printf("Prefetch: %lu requests; %.1f%% of visible cells predicted\n", (unsigned long) prefetches->issued,
+               prefetches->sampled > 0 ? 100.0 * prefetches->hits / prefetches->sampled : 0.0);
         seraphim->fps_cv.wait_for(lock, std::chrono::seconds(interval));
     }
 }
 
-static std::vector<const char *> get_required_extensions() {
-    uint32_t extension_count = 0;
-    const char **glfw_extensions =
-        glfwGetRequiredInstanceExtensions(&extension_count);
+static std::vector<const char *> get_required_extensions(bool is_headless) {
+    // surfaces are only needed to present to a window
+    std::vector<const char *> required_extensions;
+    if (!is_headless) {
+        uint32_t extension_count = 0;
+        const char **glfw_extensions =
+            glfwGetRequiredInstanceExtensions(&extension_count);
 
-    std::vector<const char *> required_extensions(glfw_extensions,
-                                                  glfw_extensions + extension_count);
+        required_extensions.assign(glfw_extensions, glfw_extensions + extension_count);
+    }
 
 #if SERAPHIM_DEBUG
     required_extensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
@@ -252,7 +365,7 @@ void create_instance(seraphim_t * seraphim) {
     app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
     app_info.apiVersion = VK_MAKE_VERSION(1, 0, 0);
 
-    auto required_extensions = get_required_extensions();
+    auto required_extensions = get_required_extensions(seraphim->is_headless);
     VkInstanceCreateInfo create_info = {};
     create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     create_info.pApplicationInfo = &app_info;
@@ -342,3 +455,116 @@ void seraphim_run(seraphim_t *seraphim) {
         current_frame++;
     }
 }
+
+// renders frames without presenting them, with the camera following the path
+// and physics stepped by the same time each frame, so that runs of the same
+// scene and path render the same frames
+void seraphim_run_headless(seraphim_t *seraphim, const camera_path_t *path, uint32_t number_of_frames,
+                           const char *image_prefix) {
+    if (image_prefix != NULL) {
+        renderer_save_images(&seraphim->renderer, image_prefix);
+    }
+
+    seraphim->fps_monitor_thread = std::thread(monitor_fps, seraphim);
+
+    double delta = 1.0 / SERAPHIM_HEADLESS_FRAME_RATE;
+    double physics_time = 0.0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < number_of_frames; i++) {
+        double time = i * delta;
+        camera_path_follow(&seraphim->test_camera, path, time, delta);
+
+        while (physics_time + sigma <= time) {
+            physics_tick(&seraphim->physics, sigma);
+            physics_time += sigma;
+        }
+
+        seraphim->renderer.render();
+    }
+
+    renderer_finish(&seraphim->renderer);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("Rendered %u frames in %.3f seconds; %.1f FPS\n", number_of_frames, elapsed.count(),
+           elapsed.count() > 0.0 ? number_of_frames / elapsed.count() : 0.0);
+}
+
+// renders frames as seraphim_run_headless does, but with the reference renderer,
+// so that its images can be compared against the renderer's frame by frame
+void seraphim_run_reference(seraphim_t *seraphim, const camera_path_t *path, uint32_t number_of_frames,
+                            const char *image_prefix) {
+    uint32_t number_of_threads = SERAPHIM_REFERENCE_THREADS;
+    if (number_of_threads == 0) {
+        number_of_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    generator_t generator;
+    generator_create(&generator, seraphim->sdfs, &seraphim->num_sdfs, seraphim->materials, &seraphim->num_materials);
+
+    reference_renderer_t reference;
+    reference_renderer_create(&reference, &generator, seraphim->work_group_count, number_of_threads,
+                              geometry_pool_size, texture_pool_size);
+
+    substance_list_t substance_list;
+    substance_list_create(&substance_list, seraphim->work_group_size.x * seraphim->work_group_size.y);
+    std::vector<substance_range_t> substance_ranges;
+
+    // the same light the renderer writes
+    light_t light;
+    light_create_scene(&light);
+
+    reference_view_t view = {};
+    view.focal_depth = 1.0f;
+    view.render_distance = (float) rho;
+    view.epsilon = (float) epsilon;
+    view.lights = &light;
+    view.number_of_lights = 1;
+
+    double delta = 1.0 / SERAPHIM_HEADLESS_FRAME_RATE;
+    double physics_time = 0.0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < number_of_frames; i++) {
+        double time = i * delta;
+        camera_path_follow(&seraphim->test_camera, path, time, delta);
+
+        while (physics_time + sigma <= time) {
+            physics_tick(&seraphim->physics, sigma);
+            physics_time += sigma;
+        }
+
+        substance_ranges.clear();
+        substance_list_update(&substance_list, seraphim->substances, seraphim->num_substances,
+                              &seraphim->test_camera.transform.position, &substance_ranges);
+        camera_transformation_matrix(&seraphim->test_camera, view.eye_transform);
+        view.substances = substance_list.sorted.data();
+        view.number_of_substances = substance_list.number_sorted;
+
+        reference_renderer_render(&reference, &view);
+
+        if (image_prefix != NULL) {
+            char filename[256];
+            snprintf(filename, sizeof(filename), "%s%06lu.ppm", image_prefix, (unsigned long) i);
+
+            if (!file_save_ppm(filename, reference.image_size.x, reference.image_size.y, reference.image)) {
+                printf("Unable to save %s\n", filename);
+            }
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("Rendered %u frames in %.3f seconds; %.1f FPS\n", number_of_frames, elapsed.count(),
+           elapsed.count() > 0.0 ? number_of_frames / elapsed.count() : 0.0);
+
+    reference_statistics_t statistics;
+    reference_renderer_statistics(&reference, &statistics);
+    printf("Patch lookups: %lu shared hits; %lu pool hits; %lu misses\n",
+           (unsigned long) statistics.patch_shared_hits, (unsigned long) statistics.patch_pool_hits,
+           (unsigned long) statistics.patch_misses);
+    printf("Texture lookups: %lu hits; %lu misses\n",
+           (unsigned long) statistics.texture_hits, (unsigned long) statistics.texture_misses);
+
+    reference_renderer_destroy(&reference);
+    generator_destroy(&generator);
+}
@@ -16,6 +16,24 @@
 #define SERAPHIM_MAX_SDFS 100
 #define SERAPHIM_MAX_MATERIALS 100
 
+// number of threads handling requests from the renderer, or zero to use every
+// hardware thread not needed by the renderer and physics
+#define SERAPHIM_REQUEST_WORKERS 0
+
+// number of threads the reference renderer draws with, or zero to use every
+// hardware thread
+#define SERAPHIM_REFERENCE_THREADS 0
+
+// frames each second of scripted time when rendering without a window, which
+// the camera path and physics are stepped by
+#define SERAPHIM_HEADLESS_FRAME_RATE 60
+
+// file that the requests read back from the renderer are captured to, so that
+// request handling can be replayed and measured without a device
+#ifndef SERAPHIM_REQUEST_CAPTURE_FILE
+#define SERAPHIM_REQUEST_CAPTURE_FILE NULL
+#endif
+
 typedef struct seraphim_t {
 #if SERAPHIM_DEBUG
     VkDebugReportCallbackEXT callback;
@@ -33,6 +51,8 @@ typedef struct seraphim_t {
     uint32_t num_materials;
     material_t materials[SERAPHIM_MAX_MATERIALS];
     bool fps_monitor_quit;
+    bool is_headless;
+    bool is_reference;
     camera_t test_camera;
     window_t window;
 
@@ -46,7 +66,13 @@ sdf_t *seraphim_create_sdf(seraphim_t *srph, sdf_func_t phi, void *data);
 material_t *seraphim_create_material(seraphim_t *srph, const vec3 * colour);
 
 void seraphim_create(seraphim_t *seraphim, const char *title);
+void seraphim_create_headless(seraphim_t *seraphim);
+void seraphim_create_reference(seraphim_t *seraphim);
 void seraphim_destroy(seraphim_t *engine);
 void seraphim_run(seraphim_t *seraphim);
+void seraphim_run_headless(seraphim_t *seraphim, const camera_path_t *path, uint32_t number_of_frames,
+                           const char *image_prefix);
+void seraphim_run_reference(seraphim_t *seraphim, const camera_path_t *path, uint32_t number_of_frames,
+                            const char *image_prefix);
 
 #endif
@@ -15,6 +15,7 @@ typedef struct substance_data_t {
     uint32_t id;
 
     float transform[MAT4_SIZE];
+    float inverse_transform[MAT4_SIZE];
 
     struct comparator_t {
         bool operator()(const substance_data_t &a, const substance_data_t &b) const;
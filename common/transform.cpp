@@ -11,6 +11,29 @@ void transform_to_local_position(transform_t *tf, vec3 *tx, const vec3 *x) {
     vec3_multiply_quat(tx, tx, &qi);
 }
 
+// finds an axis aligned bound in local space that contains the global bound
+void transform_to_local_bound(transform_t *tf, bound3_t *tb, const bound3_t *b) {
+    vec3 midpoint, radius;
+    bound3_midpoint(b, &midpoint);
+    bound3_radius(b, &radius);
+    transform_to_local_position(tf, &midpoint, &midpoint);
+
+    quat qi;
+    quat_inverse(&qi, &tf->rotation);
+
+    vec3 local_radius = vec3_zero;
+    for (int i = 0; i < 3; i++) {
+        vec3 axis = vec3_zero;
+        axis.v[i] = radius.v[i];
+        vec3_multiply_quat(&axis, &axis, &qi);
+        vec3_abs(&axis, &axis);
+        vec3_add(&local_radius, &local_radius, &axis);
+    }
+
+    vec3_subtract(&tb->lower, &midpoint, &local_radius);
+    vec3_add(&tb->upper, &midpoint, &local_radius);
+}
+
 void transform_to_global_position(const transform_t *tf, vec3 *tx, const vec3 *x) {
     vec3_multiply_quat(tx, x, &tf->rotation);
     assert(isfinite(tx->x) && isfinite(tx->y) && isfinite(tx->z));
@@ -1,6 +1,7 @@
 #ifndef SERAPHIM_TRANSFORM_H
 #define SERAPHIM_TRANSFORM_H
 
+#include "bound.h"
 #include "maths.h"
 
 typedef struct transform_t {
@@ -9,6 +10,7 @@ typedef struct transform_t {
 } transform_t;
 
 void transform_to_local_position(transform_t *tf, vec3 *tx, const vec3 *x);
+void transform_to_local_bound(transform_t *tf, bound3_t *tb, const bound3_t *b);
 void transform_to_global_position(const transform_t *tf, vec3 *tx, const vec3 *x);
 void transform_to_global_direction(const transform_t *tf, vec3 *tx, const vec3 *x);
 
@@ -0,0 +1,197 @@
+#include "allocator.h"
+
+#include "../common/debug.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+static const char * usage_names[ALLOCATOR_USAGE_MAXIMUM] = { "buffers", "images" };
+
+void allocator_create(allocator_t *self, VkPhysicalDevice physical_device, VkDevice device) {
+    self->device = device;
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &self->properties);
+    self->pools.clear();
+}
+
+static void allocator_destroy_block(allocator_t *self, allocator_block_t *block) {
+    if (block->mapped != NULL) {
+        vkUnmapMemory(self->device, block->memory);
+    }
+    vkFreeMemory(self->device, block->memory, NULL);
+    delete block;
+}
+
+void allocator_destroy(allocator_t *self) {
+    for (allocator_pool_t * pool : self->pools) {
+        for (allocator_block_t * block : pool->blocks) {
+            allocator_destroy_block(self, block);
+        }
+        delete pool;
+    }
+    self->pools.clear();
+}
+
+static allocator_pool_t *allocator_find_pool(allocator_t *self, uint32_t memory_type, allocator_usage_t usage) {
+    for (allocator_pool_t * pool : self->pools) {
+        if (pool->memory_type == memory_type && pool->usage == usage) {
+            return pool;
+        }
+    }
+
+    allocator_pool_t * pool = new allocator_pool_t;
+    pool->memory_type = memory_type;
+    pool->usage = usage;
+    self->pools.push_back(pool);
+    return pool;
+}
+
+static allocator_block_t *allocator_create_block(allocator_t *self, uint32_t memory_type, VkDeviceSize size) {
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = memory_type;
+
+    allocator_block_t * block = new allocator_block_t;
+    if (vkAllocateMemory(self->device, &alloc_info, NULL, &block->memory) != VK_SUCCESS) {
+        PANIC("Error: Failed to allocate device memory.");
+    }
+
+    block->size = size;
+    block->used = 0;
+    block->number_of_allocations = 0;
+    block->free_ranges[0] = size;
+    block->mapped = NULL;
+
+    if (self->properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        void * mapped;
+        if (vkMapMemory(self->device, block->memory, 0, size, 0, &mapped) != VK_SUCCESS) {
+            PANIC("Error: Failed to map device memory.");
+        }
+        block->mapped = (char *) mapped;
+    }
+
+    return block;
+}
+
+// carves an aligned range from the first free range of the block it fits in
+static bool allocator_block_allocate(allocator_block_t *block, const VkMemoryRequirements *requirements,
+                                     VkDeviceSize *offset) {
+    for (auto range = block->free_ranges.begin(); range != block->free_ranges.end(); range++) {
+        VkDeviceSize start = range->first;
+        VkDeviceSize end = range->first + range->second;
+        VkDeviceSize aligned = (start + requirements->alignment - 1) / requirements->alignment *
+                               requirements->alignment;
+
+        if (aligned + requirements->size > end) {
+            continue;
+        }
+
+        block->free_ranges.erase(range);
+        if (aligned > start) {
+            block->free_ranges[start] = aligned - start;
+        }
+        if (aligned + requirements->size < end) {
+            block->free_ranges[aligned + requirements->size] = end - aligned - requirements->size;
+        }
+
+        block->used += requirements->size;
+        block->number_of_allocations++;
+        *offset = aligned;
+        return true;
+    }
+
+    return false;
+}
+
+void allocator_allocate(allocator_t *self, const VkMemoryRequirements *requirements, uint32_t memory_type,
+                        allocator_usage_t usage, allocation_t *allocation) {
+    allocator_pool_t * pool = allocator_find_pool(self, memory_type, usage);
+
+    VkDeviceSize offset = 0;
+    allocator_block_t * chosen = NULL;
+    for (allocator_block_t * block : pool->blocks) {
+        if (allocator_block_allocate(block, requirements, &offset)) {
+            chosen = block;
+            break;
+        }
+    }
+
+    if (chosen == NULL) {
+        VkDeviceSize size = std::max(requirements->size, (VkDeviceSize) SERAPHIM_ALLOCATOR_BLOCK_SIZE);
+        chosen = allocator_create_block(self, memory_type, size);
+        pool->blocks.push_back(chosen);
+        allocator_block_allocate(chosen, requirements, &offset);
+    }
+
+    *allocation = {
+        .pool = pool,
+        .block = chosen,
+        .memory = chosen->memory,
+        .offset = offset,
+        .size = requirements->size,
+        .mapped = chosen->mapped != NULL ? chosen->mapped + offset : NULL,
+    };
+}
+
+// returns the range to its block, joining it to the free ranges either side.
+// blocks left empty are released.
+void allocator_free(allocator_t *self, allocation_t *allocation) {
+    allocator_block_t * block = allocation->block;
+    VkDeviceSize start = allocation->offset;
+    VkDeviceSize end = allocation->offset + allocation->size;
+
+    auto next = block->free_ranges.lower_bound(start);
+    if (next != block->free_ranges.end() && next->first == end) {
+        end += next->second;
+        next = block->free_ranges.erase(next);
+    }
+
+    if (next != block->free_ranges.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == start) {
+            start = previous->first;
+            block->free_ranges.erase(previous);
+        }
+    }
+
+    block->free_ranges[start] = end - start;
+    block->used -= allocation->size;
+    block->number_of_allocations--;
+
+    if (block->number_of_allocations == 0) {
+        std::vector<allocator_block_t *> * blocks = &allocation->pool->blocks;
+        blocks->erase(std::find(blocks->begin(), blocks->end(), block));
+        allocator_destroy_block(self, block);
+    }
+
+    allocation->block = NULL;
+}
+
+void allocator_report(allocator_t *self) {
+    VkDeviceSize total_reserved = 0;
+    VkDeviceSize total_used = 0;
+
+    printf("Device memory:\n");
+    for (allocator_pool_t * pool : self->pools) {
+        VkDeviceSize reserved = 0;
+        VkDeviceSize used = 0;
+        uint32_t number_of_allocations = 0;
+        for (allocator_block_t * block : pool->blocks) {
+            reserved += block->size;
+            used += block->used;
+            number_of_allocations += block->number_of_allocations;
+        }
+
+        VkMemoryPropertyFlags flags = self->properties.memoryTypes[pool->memory_type].propertyFlags;
+        const char * kind = flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ? "host visible" : "device local";
+        printf("\tType %u, %s %s: %zu blocks; %.1f MiB reserved; %.1f MiB used by %u allocations\n",
+               pool->memory_type, kind, usage_names[pool->usage], pool->blocks.size(), reserved / 1048576.0, used / 1048576.0,
+               number_of_allocations);
+
+        total_reserved += reserved;
+        total_used += used;
+    }
+
+    printf("\tTotal: %.1f MiB reserved; %.1f MiB used\n", total_reserved / 1048576.0, total_used / 1048576.0);
+}
@@ -0,0 +1,67 @@
+#ifndef SERAPHIM_ALLOCATOR_H
+#define SERAPHIM_ALLOCATOR_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <map>
+#include <vector>
+
+// bytes of device memory allocated at a time, which allocations are carved
+// from. larger allocations are given a block of their own.
+#define SERAPHIM_ALLOCATOR_BLOCK_SIZE (64 * 1024 * 1024)
+
+// buffers and images are kept in separate pools, so that neither needs to be
+// padded to the buffer image granularity
+typedef enum allocator_usage_t {
+    ALLOCATOR_USAGE_BUFFER = 0,
+    ALLOCATOR_USAGE_IMAGE,
+    ALLOCATOR_USAGE_MAXIMUM
+} allocator_usage_t;
+
+typedef struct allocator_block_t {
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    VkDeviceSize used;
+    uint32_t number_of_allocations;
+
+    // host visible blocks are mapped for as long as they exist
+    char * mapped;
+
+    // offsets and sizes of the ranges not allocated
+    std::map<VkDeviceSize, VkDeviceSize> free_ranges;
+} allocator_block_t;
+
+typedef struct allocator_pool_t {
+    uint32_t memory_type;
+    allocator_usage_t usage;
+    std::vector<allocator_block_t *> blocks;
+} allocator_pool_t;
+
+typedef struct allocation_t {
+    allocator_pool_t * pool;
+    allocator_block_t * block;
+    VkDeviceMemory memory;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+
+    // the allocation's host memory, or NULL if it isn't host visible
+    char * mapped;
+} allocation_t;
+
+// hands out ranges of a few large blocks of device memory, rather than making
+// an allocation for every buffer and image
+typedef struct allocator_t {
+    VkDevice device;
+    VkPhysicalDeviceMemoryProperties properties;
+    std::vector<allocator_pool_t *> pools;
+} allocator_t;
+
+void allocator_create(allocator_t *self, VkPhysicalDevice physical_device, VkDevice device);
+void allocator_destroy(allocator_t *self);
+void allocator_allocate(allocator_t *self, const VkMemoryRequirements *requirements, uint32_t memory_type,
+                        allocator_usage_t usage, allocation_t *allocation);
+void allocator_free(allocator_t *self, allocation_t *allocation);
+void allocator_report(allocator_t *self);
+
+#endif
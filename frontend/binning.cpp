@@ -0,0 +1,192 @@
+#include "binning.h"
+
+#include <math.h>
+
+void substance_bins_create(substance_bins_t *self, vec2u work_group_count) {
+    self->work_group_count = work_group_count;
+    self->number_of_tiles = work_group_count.x * work_group_count.y;
+    self->data.assign(self->number_of_tiles + 1, self->number_of_tiles + 1);
+    self->rectangles.clear();
+    self->counts.assign(self->number_of_tiles, 0);
+    self->cursors.assign(self->number_of_tiles, 0);
+
+    self->substances = NULL;
+    self->number_of_substances = 0;
+    self->focal_depth = 1.0f;
+    self->render_distance = 0.0f;
+}
+
+// the size of the bin buffer, in elements, when every tile sees every substance
+uint32_t substance_bins_capacity(vec2u work_group_count, uint32_t max_substances) {
+    uint32_t number_of_tiles = work_group_count.x * work_group_count.y;
+    return number_of_tiles + 1 + number_of_tiles * max_substances;
+}
+
+// finds the tiles covered by the projection of the corners of a substance's
+// bound. the rays of comp.glsl pass through the view at the same points as
+// the corners are projected to, so a tile can only see the substance if it is
+// in this rectangle. bounds straddling the plane of the eye may cover any
+// tile, and bounds wholly behind it none.
+static void substance_bins_rectangle(substance_bins_t *self, const substance_data_t *substance, vec4i *rectangle) {
+    const float * eye = self->eye_inverse;
+    const float * m = substance->transform;
+    vec2u count = self->work_group_count;
+    float width = (float) (count.x * SERAPHIM_BINNING_TILE_SIZE);
+    float height = (float) (count.y * SERAPHIM_BINNING_TILE_SIZE);
+    float aspect_ratio = (float) count.y / count.x;
+
+    *rectangle = {{ 0, 0, -1, -1 }};
+    if (substance->id == (uint32_t) ~0 || substance->near >= self->render_distance) {
+        return;
+    }
+
+    float lower[2] = { INFINITY, INFINITY };
+    float upper[2] = { -INFINITY, -INFINITY };
+    int behind = 0;
+    for (int o = 0; o < 8; o++) {
+        float c[3] = {
+            (o & 1) ? substance->r.x : -substance->r.x,
+            (o & 2) ? substance->r.y : -substance->r.y,
+            (o & 4) ? substance->r.z : -substance->r.z,
+        };
+
+        float p[3];
+        for (int a = 0; a < 3; a++) {
+            p[a] = m[a] * c[0] + m[4 + a] * c[1] + m[8 + a] * c[2] + m[12 + a];
+        }
+
+        float q[3];
+        for (int a = 0; a < 3; a++) {
+            q[a] = eye[a] * p[0] + eye[4 + a] * p[1] + eye[8 + a] * p[2] + eye[12 + a];
+        }
+
+        if (q[2] <= 0.0f) {
+            behind++;
+            continue;
+        }
+
+        // inverts uv and get_ray_direction in comp.glsl
+        float u = q[0] * self->focal_depth / q[2];
+        float v = q[1] * self->focal_depth / q[2] / -aspect_ratio;
+        float x = (u + 1.0f) * 0.5f * width;
+        float y = (v + 1.0f) * 0.5f * height;
+
+        lower[0] = fminf(lower[0], x);
+        lower[1] = fminf(lower[1], y);
+        upper[0] = fmaxf(upper[0], x);
+        upper[1] = fmaxf(upper[1], y);
+    }
+
+    // a bound only partly in front of the eye doesn't project to a rectangle
+    if (behind == 8) {
+        return;
+    } else if (behind > 0) {
+        *rectangle = {{ 0, 0, (mint_t) count.x - 1, (mint_t) count.y - 1 }};
+        return;
+    }
+
+    // a pixel's leeway covers the difference between this and the shader's arithmetic
+    float sizes[2] = { width, height };
+    mint_t bounds[4];
+    for (int a = 0; a < 2; a++) {
+        float first = lower[a] - 1.0f;
+        float last = upper[a] + 1.0f;
+        if (last < 0.0f || first >= sizes[a]) {
+            return;
+        }
+
+        bounds[a] = (mint_t) (fmaxf(first, 0.0f) / SERAPHIM_BINNING_TILE_SIZE);
+        bounds[2 + a] = (mint_t) (fminf(last, sizes[a] - 1.0f) / SERAPHIM_BINNING_TILE_SIZE);
+    }
+
+    *rectangle = {{ bounds[0], bounds[1], bounds[2], bounds[3] }};
+}
+
+static void substance_bins_project(void *self_, uint32_t job) {
+    substance_bins_t * self = (substance_bins_t *) self_;
+    uint32_t first = job * SERAPHIM_BINNING_SUBSTANCES_PER_JOB;
+    uint32_t last = first + SERAPHIM_BINNING_SUBSTANCES_PER_JOB;
+    if (last > self->number_of_substances) {
+        last = self->number_of_substances;
+    }
+
+    for (uint32_t s = first; s < last; s++) {
+        substance_bins_rectangle(self, &self->substances[s], &self->rectangles[s]);
+    }
+}
+
+static void substance_bins_count(void *self_, uint32_t row) {
+    substance_bins_t * self = (substance_bins_t *) self_;
+    uint32_t * counts = &self->counts[row * self->work_group_count.x];
+
+    for (uint32_t x = 0; x < self->work_group_count.x; x++) {
+        counts[x] = 0;
+    }
+
+    for (uint32_t s = 0; s < self->number_of_substances; s++) {
+        vec4i * rectangle = &self->rectangles[s];
+        if (rectangle->y <= (mint_t) row && (mint_t) row <= rectangle->w) {
+            for (mint_t x = rectangle->x; x <= rectangle->z; x++) {
+                counts[x]++;
+            }
+        }
+    }
+}
+
+static void substance_bins_fill(void *self_, uint32_t row) {
+    substance_bins_t * self = (substance_bins_t *) self_;
+    uint32_t first_tile = row * self->work_group_count.x;
+    uint32_t * cursors = &self->cursors[first_tile];
+    for (uint32_t x = 0; x < self->work_group_count.x; x++) {
+        cursors[x] = self->data[first_tile + x];
+    }
+
+    for (uint32_t s = 0; s < self->number_of_substances; s++) {
+        vec4i * rectangle = &self->rectangles[s];
+        if (rectangle->y <= (mint_t) row && (mint_t) row <= rectangle->w) {
+            for (mint_t x = rectangle->x; x <= rectangle->z; x++) {
+                self->data[cursors[x]++] = s;
+            }
+        }
+    }
+}
+
+// bins the substances as written to the substance buffer by the tiles of the
+// view from the eye. the substances are projected, then the lists of each row
+// of tiles are counted and filled, sharing the work between the pool's threads.
+void substance_bins_update(substance_bins_t *self, job_pool_t *pool, const substance_data_t *substances,
+                           uint32_t number_of_substances, const float *eye_transform, float focal_depth,
+                           float render_distance) {
+    self->substances = substances;
+    self->number_of_substances = number_of_substances;
+    self->focal_depth = focal_depth;
+    self->render_distance = render_distance;
+
+    mat4 eye;
+    for (int i = 0; i < MAT4_SIZE; i++) {
+        eye.v[i] = eye_transform[i];
+    }
+    mat4_inverse(&eye, &eye);
+    for (int i = 0; i < MAT4_SIZE; i++) {
+        self->eye_inverse[i] = (float) eye.v[i];
+    }
+
+    self->rectangles.resize(number_of_substances);
+    uint32_t number_of_jobs =
+        (number_of_substances + SERAPHIM_BINNING_SUBSTANCES_PER_JOB - 1) / SERAPHIM_BINNING_SUBSTANCES_PER_JOB;
+    job_pool_run(pool, substance_bins_project, self, number_of_jobs);
+    job_pool_run(pool, substance_bins_count, self, self->work_group_count.y);
+
+    uint32_t offset = self->number_of_tiles + 1;
+    self->data.resize(offset);
+    for (uint32_t t = 0; t < self->number_of_tiles; t++) {
+        self->data[t] = offset;
+        offset += self->counts[t];
+    }
+    self->data[self->number_of_tiles] = offset;
+    self->data.resize(offset);
+
+    job_pool_run(pool, substance_bins_fill, self, self->work_group_count.y);
+
+    self->substances = NULL;
+}
@@ -0,0 +1,51 @@
+#ifndef SERAPHIM_BINNING_H
+#define SERAPHIM_BINNING_H
+
+#include "../common/maths.h"
+#include "../common/substance_data.h"
+#include "jobs.h"
+
+#include <vector>
+
+// pixels along each side of a tile, which must match the work group size of comp.glsl
+#define SERAPHIM_BINNING_TILE_SIZE 32
+
+// threads that help the render thread bin substances
+#define SERAPHIM_BINNING_THREADS 2
+
+// substances projected onto the tiles by each job
+#define SERAPHIM_BINNING_SUBSTANCES_PER_JOB 64
+
+// the substances that each tile of the view may see, which the shader marches
+// rays through instead of testing every substance in every work group. tiles
+// list the substances whose bounds project onto them, in the order of the
+// substance buffer, so that they stay sorted by far distance. lists are laid
+// out as in the bin buffer: the offset of each tile's list, and of the end of
+// the last list, then the lists.
+typedef struct substance_bins_t {
+    vec2u work_group_count;
+    uint32_t number_of_tiles;
+    std::vector<uint32_t> data;
+
+    // the tiles each substance covers, as its first column and row then its
+    // last column and row, which are before the first if it covers none, and
+    // the number of substances each tile sees and where the next goes in its list
+    std::vector<vec4i> rectangles;
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> cursors;
+
+    // what the jobs of an update are binning
+    const substance_data_t * substances;
+    uint32_t number_of_substances;
+    float eye_inverse[MAT4_SIZE];
+    float focal_depth;
+    float render_distance;
+} substance_bins_t;
+
+void substance_bins_create(substance_bins_t *self, vec2u work_group_count);
+void substance_bins_update(substance_bins_t *self, job_pool_t *pool, const substance_data_t *substances,
+                           uint32_t number_of_substances, const float *eye_transform, float focal_depth,
+                           float render_distance);
+uint32_t substance_bins_capacity(vec2u work_group_count, uint32_t max_substances);
+
+#endif
@@ -2,17 +2,32 @@
 // Created by millie on 02/05/2021.
 //
 
+#include <algorithm>
 #include <cstring>
 #include "buffer.h"
 
+#include <stddef.h>
+
+static_assert(frames_in_flight <= SERAPHIM_STAGING_MAX_FRAMES,
+              "the staging must be able to hold the writes of every frame in flight");
+
+static_assert(sizeof(buffer_region_t) == sizeof(VkBufferCopy) &&
+              offsetof(buffer_region_t, source) == offsetof(VkBufferCopy, srcOffset) &&
+              offsetof(buffer_region_t, destination) == offsetof(VkBufferCopy, dstOffset) &&
+              offsetof(buffer_region_t, size) == offsetof(VkBufferCopy, size),
+              "buffer regions must be laid out like VkBufferCopy");
+
 void buffer_create(buffer_t *self, uint32_t binding, device_t *device, uint64_t size,
-                   bool is_device_local, size_t element_size) {
-    self->is_device_local = is_device_local;
+                   buffer_usage_t usage, size_t element_size) {
+    self->is_device_local = usage != BUFFER_USAGE_HOST;
     self->device = device;
     self->element_size = element_size;
     self->size = element_size * size;
     self->binding = binding;
+    self->regions_written = 0;
+    self->regions_copied = 0;
     array_create(&self->updates);
+    self->regions.clear();
 
     VkBufferCreateInfo buffer_info = {};
     buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -21,12 +36,13 @@ void buffer_create(buffer_t *self, uint32_t binding, device_t *device, uint64_t
 
     VkMemoryPropertyFlagBits memory_property;
 
-    if (is_device_local) {
+    if (self->is_device_local) {
         buffer_info.usage =
-            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         memory_property = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
     } else {
-        buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        // host buffers are also copied into when device local buffers are read back
+        buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         memory_property = (VkMemoryPropertyFlagBits)(
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
@@ -41,19 +57,11 @@ void buffer_create(buffer_t *self, uint32_t binding, device_t *device, uint64_t
     VkMemoryRequirements mem_req;
     vkGetBufferMemoryRequirements(device->device, self->buffer, &mem_req);
 
-    VkMemoryAllocateInfo alloc_info = {};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_req.size;
-    alloc_info.memoryTypeIndex =
-        device_memory_type(device, mem_req.memoryTypeBits, memory_property);
-
-    if (vkAllocateMemory(device->device, &alloc_info, NULL, &self->memory) !=
-        VK_SUCCESS) {
-        printf("Error: Failed to allocate buffer memory.");
-        exit(1);
-    }
+    uint32_t memory_type = device_memory_type(device, mem_req.memoryTypeBits, memory_property);
+    allocator_allocate(&device->allocator, &mem_req, memory_type, ALLOCATOR_USAGE_BUFFER, &self->allocation);
+    self->mapped = self->allocation.mapped;
 
-    if (vkBindBufferMemory(device->device, self->buffer, self->memory, 0) !=
+    if (vkBindBufferMemory(device->device, self->buffer, self->allocation.memory, self->allocation.offset) !=
         VK_SUCCESS) {
         printf("Error: Failed to bind buffer memory.");
         exit(1);
@@ -64,23 +72,29 @@ void buffer_create(buffer_t *self, uint32_t binding, device_t *device, uint64_t
     self->desc_buffer_info.offset = 0;
     self->desc_buffer_info.range = self->size;
 
-    if (is_device_local) {
-        self->staging_buffer = (buffer_t *)malloc(sizeof(*self->staging_buffer));
-        buffer_create(self->staging_buffer, ~0, device, size, false, element_size);
+    if (usage == BUFFER_USAGE_READBACK) {
+        self->readbacks = new buffer_t[frames_in_flight];
+        for (uint32_t i = 0; i < frames_in_flight; i++) {
+            buffer_create(&self->readbacks[i], ~0, device, size, BUFFER_USAGE_HOST, element_size);
+        }
     } else {
-        self->staging_buffer = NULL;
+        self->readbacks = NULL;
     }
 }
 
 void buffer_destroy(buffer_t *self) {
     array_clear(&self->updates);
+    self->regions.clear();
 
     vkDestroyBuffer(self->device->device, self->buffer, NULL);
-    vkFreeMemory(self->device->device, self->memory, NULL);
+    allocator_free(&self->device->allocator, &self->allocation);
 
-    if (self->staging_buffer != NULL) {
-        buffer_destroy(self->staging_buffer);
-        self->staging_buffer = NULL;
+    if (self->readbacks != NULL) {
+        for (uint32_t i = 0; i < frames_in_flight; i++) {
+            buffer_destroy(&self->readbacks[i]);
+        }
+        delete[] self->readbacks;
+        self->readbacks = NULL;
     }
 }
 
@@ -102,67 +116,105 @@ void buffer_memory_barrier(buffer_t *self, VkBufferMemoryBarrier *buffer_barrier
     };
 }
 
-void *buffer_map(buffer_t *buffer, uint64_t offset, uint64_t map_size) {
-    if (buffer->is_device_local) {
-        return buffer_map(buffer->staging_buffer, offset, map_size);
-    } else {
-        void *memory_map;
-        vkMapMemory(buffer->device->device, buffer->memory, buffer->element_size * offset,
-                    buffer->element_size * map_size, 0, &memory_map);
-        return memory_map;
-    }
+// finds the host memory of the element at offset in a host visible buffer
+void *buffer_memory(buffer_t *buffer, uint64_t offset) {
+    return buffer->mapped + buffer->element_size * offset;
 }
 
-void buffer_unmap(buffer_t *buffer) {
-    if (buffer->is_device_local) {
-        buffer_unmap(buffer->staging_buffer);
-    } else {
-        vkUnmapMemory(buffer->device->device, buffer->memory);
-    }
+// finds the element at offset as it was read back by the given frame, which
+// must only be called once that frame's fence has been signalled
+void *buffer_readback_memory(buffer_t *buffer, uint32_t frame, uint64_t offset) {
+    return buffer_memory(&buffer->readbacks[frame], offset);
 }
 
-void buffer_write(buffer_t *buffer, const void *source, size_t number, uint64_t offset) {
+// copies number elements into the buffer at offset. host visible buffers are
+// written directly, and writes to device local buffers are staged to be copied
+// by the next buffer_record_write. returns false if the write is out of range
+// or there is no staging memory left this frame.
+bool buffer_write(buffer_t *buffer, const void *source, size_t number, uint64_t offset) {
     if (number == 0) {
-        return;
+        return true;
     }
 
-    if (buffer->element_size * (offset + number) > buffer->size + 1) {
-        printf("Error: Invalid buffer write.");
-        exit(1);
+    if (buffer->element_size * (offset + number) > buffer->size) {
+        return false;
     }
 
-    void *mem_map = buffer_map(buffer, offset, number);
-    memcpy(mem_map, source, buffer->element_size * number);
-    buffer_unmap(buffer);
-
-    if (buffer->is_device_local) {
-        VkBufferCopy buffer_copy = {};
-        buffer_copy.srcOffset = buffer->element_size * offset;
-        buffer_copy.dstOffset = buffer->element_size * offset;
-        buffer_copy.size = buffer->element_size * number;
+    uint64_t bytes = buffer->element_size * number;
+    if (!buffer->is_device_local) {
+        memcpy(buffer->mapped + buffer->element_size * offset, source, bytes);
+        return true;
+    }
 
-        array_push_back(&buffer->updates);
-        *(buffer->updates.last) = buffer_copy;
+    staging_t * staging = buffer->device->staging;
+    uint64_t staging_offset;
+    if (!staging_claim(staging, bytes, &staging_offset)) {
+        return false;
     }
+
+    memcpy(staging->buffer.mapped + staging_offset, source, bytes);
+
+    VkBufferCopy buffer_copy = {};
+    buffer_copy.srcOffset = staging_offset;
+    buffer_copy.dstOffset = buffer->element_size * offset;
+    buffer_copy.size = bytes;
+
+    array_push_back(&buffer->updates);
+    *(buffer->updates.last) = buffer_copy;
+    return true;
 }
 
+// records the copies of the writes staged since the last frame. writes to the
+// same place are only copied once, and neighbouring writes are copied together.
 void buffer_record_write(buffer_t *buffer, VkCommandBuffer command_buffer) {
     if (array_is_empty(&buffer->updates)){
         return;
     }
 
-    vkCmdCopyBuffer(command_buffer, buffer->staging_buffer->buffer, buffer->buffer,
-                    buffer->updates.size, buffer->updates.data);
+    buffer_regions_coalesce((buffer_region_t *) buffer->updates.data, buffer->updates.size, &buffer->regions);
+
+    vkCmdCopyBuffer(command_buffer, buffer->device->staging->buffer.buffer, buffer->buffer,
+                    buffer->regions.size(), (VkBufferCopy *) buffer->regions.data());
+
+    buffer->regions_written += buffer->updates.size;
+    buffer->regions_copied += buffer->regions.size();
     array_clear(&buffer->updates);
 }
 
-void buffer_record_read(buffer_t *buffer, VkCommandBuffer command_buffer) {
+void buffer_statistics(buffer_t *buffer, buffer_statistics_t *statistics) {
+    statistics->regions_written = buffer->regions_written.exchange(0);
+    statistics->regions_copied = buffer->regions_copied.exchange(0);
+}
+
+void buffer_record_read(buffer_t *buffer, VkCommandBuffer command_buffer, uint32_t frame) {
+    buffer_record_read_range(buffer, command_buffer, frame, 0, buffer_size(buffer));
+    buffer_record_fill(buffer, command_buffer, 0, buffer_size(buffer), 0);
+}
+
+// copies number elements from offset into the frame's mirror
+void buffer_record_read_range(buffer_t *buffer, VkCommandBuffer command_buffer, uint32_t frame, uint64_t offset,
+                              uint64_t number) {
+    if (number == 0) {
+        return;
+    }
+
     VkBufferCopy region;
-    region.srcOffset = 0;
-    region.dstOffset = 0;
-    region.size = buffer->size;
-    vkCmdCopyBuffer(command_buffer, buffer->buffer, buffer->staging_buffer->buffer, 1, &region);
-    vkCmdFillBuffer(command_buffer, buffer->buffer, 0, buffer->size, 0);
+    region.srcOffset = buffer->element_size * offset;
+    region.dstOffset = buffer->element_size * offset;
+    region.size = buffer->element_size * number;
+    vkCmdCopyBuffer(command_buffer, buffer->buffer, buffer->readbacks[frame].buffer, 1, &region);
+}
+
+// fills number elements from offset with a repeated 32 bit value. the range
+// must be a multiple of four bytes.
+void buffer_record_fill(buffer_t *buffer, VkCommandBuffer command_buffer, uint64_t offset, uint64_t number,
+                        uint32_t value) {
+    if (number == 0) {
+        return;
+    }
+
+    vkCmdFillBuffer(command_buffer, buffer->buffer, buffer->element_size * offset, buffer->element_size * number,
+                    value);
 }
 
 VkWriteDescriptorSet buffer_write_descriptor_set(buffer_t *buffer, VkDescriptorSet descriptor_set) {
@@ -188,4 +240,57 @@ VkDescriptorSetLayoutBinding buffer_descriptor_set_layout_binding(buffer_t *buff
     layout_binding.pImmutableSamplers = NULL;
     layout_binding.binding = buffer->binding;
     return layout_binding;
-}
\ No newline at end of file
+}
+void staging_create(staging_t *self, device_t *device, uint64_t size) {
+    buffer_create(&self->buffer, ~0, device, size, BUFFER_USAGE_HOST, 1);
+    self->head = 0;
+    self->tail = 0;
+    self->first_frame = 0;
+    self->number_of_frames = 0;
+}
+
+void staging_destroy(staging_t *self) {
+    buffer_destroy(&self->buffer);
+}
+
+// claims bytes at the head of the ring, returning false if the ring is too
+// full. a claim that would pass the end of the ring starts again at the
+// beginning instead.
+bool staging_claim(staging_t *self, uint64_t bytes, uint64_t *offset) {
+    uint64_t capacity = self->buffer.size;
+    uint64_t head = self->head;
+    if (head % capacity + bytes > capacity) {
+        head += capacity - head % capacity;
+    }
+
+    if (head + bytes - self->tail > capacity) {
+        return false;
+    }
+
+    *offset = head % capacity;
+    self->head = head + bytes;
+    return true;
+}
+
+// ends the frame whose writes have just been recorded
+void staging_end_frame(staging_t *self) {
+    // if too many frames are waiting then this frame's writes are reclaimed
+    // along with a later frame's, which is later than they need to be
+    if (self->number_of_frames < SERAPHIM_STAGING_MAX_FRAMES) {
+        uint32_t frame = (self->first_frame + self->number_of_frames) % SERAPHIM_STAGING_MAX_FRAMES;
+        self->frame_heads[frame] = self->head;
+        self->number_of_frames++;
+    }
+}
+
+// reclaims the memory of the oldest frame ended, which must only be called
+// once that frame's fence has been signalled
+void staging_release_frame(staging_t *self) {
+    if (self->number_of_frames == 0) {
+        return;
+    }
+
+    self->tail = self->frame_heads[self->first_frame];
+    self->first_frame = (self->first_frame + 1) % SERAPHIM_STAGING_MAX_FRAMES;
+    self->number_of_frames--;
+}
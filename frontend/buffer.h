@@ -3,32 +3,101 @@
 
 #include "command.h"
 #include "device.h"
+#include "region.h"
 #include "../common/array.h"
 
+#include <atomic>
+#include <vector>
+
+// bytes of host memory that writes to device local buffers are staged in,
+// shared between every buffer, which must hold the writes of the frames in flight
+#define SERAPHIM_STAGING_SIZE (32 * 1024 * 1024)
+
+// frames whose writes may be waiting to be copied at once
+#define SERAPHIM_STAGING_MAX_FRAMES 8
+
+// frames that may be recorded while earlier frames are still on the device.
+// a frame's resources are only reused once the fence of the frame this many
+// before it is signalled.
+static const uint8_t frames_in_flight = 2;
+
+typedef enum buffer_usage_t {
+    // device local, and written through the device's staging
+    BUFFER_USAGE_DEVICE = 0,
+    // device local, with a host visible mirror for each frame in flight that
+    // it can be read back into
+    BUFFER_USAGE_READBACK,
+    // host visible, and written directly
+    BUFFER_USAGE_HOST,
+} buffer_usage_t;
+
+typedef struct buffer_statistics_t {
+    uint64_t regions_written;
+    uint64_t regions_copied;
+} buffer_statistics_t;
+
 struct buffer_t {
     bool is_device_local;
     device_t *device;
     VkBuffer buffer;
-    VkDeviceMemory memory;
+    allocation_t allocation;
     uint64_t size;
     uint32_t binding;
     size_t element_size;
     VkDescriptorBufferInfo desc_buffer_info;
-    buffer_t *staging_buffer;
+
+    // the mirrors that a buffer is read back into, one for each frame in
+    // flight, if it is read back
+    buffer_t *readbacks;
+
+    // host visible memory is mapped for as long as its block exists
+    char *mapped;
+
     array_t(VkBufferCopy) updates;
+
+    // the coalesced updates, kept between frames so recording them does not
+    // allocate
+    std::vector<buffer_region_t> regions;
+
+    // regions written, and the regions copied once they were coalesced
+    std::atomic<uint64_t> regions_written;
+    std::atomic<uint64_t> regions_copied;
 };
 
+// a ring over a host visible buffer that writes to every device local buffer
+// are staged in. the head and tail count bytes since the ring was created, and
+// the writes of each frame are reclaimed once the frame's fence is signalled.
+typedef struct staging_t {
+    buffer_t buffer;
+    uint64_t head;
+    uint64_t tail;
+    uint64_t frame_heads[SERAPHIM_STAGING_MAX_FRAMES];
+    uint32_t first_frame;
+    uint32_t number_of_frames;
+} staging_t;
+
 void buffer_create(buffer_t *self, uint32_t binding, device_t *device, uint64_t size,
-                   bool is_device_local, size_t element_size);
+                   buffer_usage_t usage, size_t element_size);
 void buffer_destroy(buffer_t *self);
 size_t buffer_size(buffer_t *self);
 void buffer_memory_barrier(buffer_t *self, VkBufferMemoryBarrier *barrier);
-void *buffer_map(buffer_t *buffer, uint64_t offset, uint64_t map_size);
-void buffer_unmap(buffer_t *buffer);
-void buffer_write(buffer_t *buffer, const void *source, size_t number, uint64_t offset);
+void *buffer_memory(buffer_t *buffer, uint64_t offset);
+void *buffer_readback_memory(buffer_t *buffer, uint32_t frame, uint64_t offset);
+bool buffer_write(buffer_t *buffer, const void *source, size_t number, uint64_t offset);
 void buffer_record_write(buffer_t *buffer, VkCommandBuffer command_buffer);
-void buffer_record_read(buffer_t *buffer, VkCommandBuffer command_buffer);
+void buffer_statistics(buffer_t *buffer, buffer_statistics_t *statistics);
+void buffer_record_read(buffer_t *buffer, VkCommandBuffer command_buffer, uint32_t frame);
+void buffer_record_read_range(buffer_t *buffer, VkCommandBuffer command_buffer, uint32_t frame, uint64_t offset,
+                              uint64_t number);
+void buffer_record_fill(buffer_t *buffer, VkCommandBuffer command_buffer, uint64_t offset, uint64_t number,
+                        uint32_t value);
 VkWriteDescriptorSet buffer_write_descriptor_set(buffer_t *buffer, VkDescriptorSet descriptor_set);
 VkDescriptorSetLayoutBinding buffer_descriptor_set_layout_binding(buffer_t *buffer);
 
+void staging_create(staging_t *self, device_t *device, uint64_t size);
+void staging_destroy(staging_t *self);
+bool staging_claim(staging_t *self, uint64_t bytes, uint64_t *offset);
+void staging_end_frame(staging_t *self);
+void staging_release_frame(staging_t *self);
+
 #endif
@@ -0,0 +1,234 @@
+#include "bvh.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+void substance_bvh_create(substance_bvh_t *self) {
+    self->nodes.clear();
+    self->ids.clear();
+    self->indices.clear();
+    self->built_area = 0.0f;
+    self->rebuilds = 0;
+    self->refits = 0;
+}
+
+// the number of nodes in the hierarchy over this many substances
+uint32_t substance_bvh_capacity(uint32_t max_substances) {
+    return max_substances > 0 ? 2 * max_substances - 1 : 1;
+}
+
+// finds the world bound of a substance, which contains its bound at any rotation
+static void substance_bvh_bound(const substance_data_t *substance, vec3f *lower, vec3f *upper) {
+    const float * m = substance->transform;
+    for (int a = 0; a < 3; a++) {
+        float extent = fabsf(m[a]) * substance->r.x + fabsf(m[4 + a]) * substance->r.y +
+                       fabsf(m[8 + a]) * substance->r.z;
+        lower->v[a] = m[12 + a] - extent;
+        upper->v[a] = m[12 + a] + extent;
+    }
+}
+
+static void substance_bvh_join(substance_bvh_node_t *node, const vec3f *lower, const vec3f *upper) {
+    for (int a = 0; a < 3; a++) {
+        node->lower.v[a] = fminf(node->lower.v[a], lower->v[a]);
+        node->upper.v[a] = fmaxf(node->upper.v[a], upper->v[a]);
+    }
+}
+
+static float substance_bvh_area(const substance_bvh_node_t *node) {
+    float x = node->upper.x - node->lower.x;
+    float y = node->upper.y - node->lower.y;
+    float z = node->upper.z - node->lower.z;
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+// appends the nodes over order[first, last), splitting the substances at the
+// median of their centres along the axis the centres are most spread over
+static void substance_bvh_build(substance_bvh_t *self, uint32_t first, uint32_t last) {
+    uint32_t index = (uint32_t) self->nodes.size();
+    self->nodes.emplace_back();
+
+    substance_bvh_node_t node;
+    node.lower = {{ INFINITY, INFINITY, INFINITY }};
+    node.upper = {{ -INFINITY, -INFINITY, -INFINITY }};
+
+    substance_bvh_node_t centres = node;
+    for (uint32_t i = first; i < last; i++) {
+        uint32_t s = self->order[i];
+        substance_bvh_join(&node, &self->lower[s], &self->upper[s]);
+
+        vec3f centre;
+        for (int a = 0; a < 3; a++) {
+            centre.v[a] = (self->lower[s].v[a] + self->upper[s].v[a]) * 0.5f;
+        }
+        substance_bvh_join(&centres, &centre, &centre);
+    }
+
+    if (last - first == 1) {
+        node.substance = self->order[first];
+        node.escape = index + 1;
+        self->nodes[index] = node;
+        return;
+    }
+
+    int axis = 0;
+    for (int a = 1; a < 3; a++) {
+        if (centres.upper.v[a] - centres.lower.v[a] > centres.upper.v[axis] - centres.lower.v[axis]) {
+            axis = a;
+        }
+    }
+
+    uint32_t middle = first + (last - first) / 2;
+    std::nth_element(self->order.begin() + first, self->order.begin() + middle, self->order.begin() + last,
+                     [self, axis](uint32_t a, uint32_t b) {
+                         return self->lower[a].v[axis] + self->upper[a].v[axis] <
+                                self->lower[b].v[axis] + self->upper[b].v[axis];
+                     });
+
+    substance_bvh_build(self, first, middle);
+    substance_bvh_build(self, middle, last);
+
+    node.substance = ~0;
+    node.escape = (uint32_t) self->nodes.size();
+    self->nodes[index] = node;
+}
+
+// moves the leaves to the substances' new indices, if the substances are the
+// same as at the last update, returning whether they are. indices holds each
+// id's index while the leaves are moved, and is left empty of them after.
+static bool substance_bvh_follow(substance_bvh_t *self, const substance_data_t *substances,
+                                 uint32_t number_of_substances, bool *is_changed) {
+    if (number_of_substances != self->ids.size() || self->nodes.empty()) {
+        return false;
+    }
+
+    bool is_reordered = false;
+    for (uint32_t i = 0; i < number_of_substances && !is_reordered; i++) {
+        is_reordered = substances[i].id != self->ids[i];
+    }
+
+    if (!is_reordered) {
+        return true;
+    }
+
+    std::vector<uint32_t> * indices = &self->indices;
+    bool is_same = true;
+    uint32_t number = 0;
+    for (; number < number_of_substances && is_same; number++) {
+        uint32_t id = substances[number].id;
+        if (id >= indices->size()) {
+            indices->resize(id + 1, ~0u);
+        }
+
+        is_same = (*indices)[id] == ~0u;
+        (*indices)[id] = number;
+    }
+
+    for (size_t i = 0; i < self->ids.size() && is_same; i++) {
+        is_same = self->ids[i] < indices->size() && (*indices)[self->ids[i]] != ~0u;
+    }
+
+    if (is_same) {
+        for (substance_bvh_node_t &node : self->nodes) {
+            if (node.substance != (uint32_t) ~0) {
+                node.substance = (*indices)[self->ids[node.substance]];
+            }
+        }
+
+        for (uint32_t i = 0; i < number_of_substances; i++) {
+            self->ids[i] = substances[i].id;
+        }
+        *is_changed = true;
+    }
+
+    for (uint32_t i = 0; i < number; i++) {
+        (*indices)[substances[i].id] = ~0u;
+    }
+
+    return is_same;
+}
+
+static bool substance_bvh_is_equal(const vec3f *a, const vec3f *b) {
+    return a->x == b->x && a->y == b->y && a->z == b->z;
+}
+
+// fits the nodes to the bounds of their substances from the leaves up, which
+// as children follow their parents is backwards through the nodes, returning
+// the surface area of the nodes and noting whether any of them moved
+static float substance_bvh_refit(substance_bvh_t *self, bool *is_changed) {
+    float area = 0.0f;
+
+    for (size_t i = self->nodes.size(); i-- > 0;) {
+        substance_bvh_node_t * node = &self->nodes[i];
+        substance_bvh_node_t fitted = *node;
+        if (node->substance != (uint32_t) ~0) {
+            fitted.lower = self->lower[node->substance];
+            fitted.upper = self->upper[node->substance];
+        } else {
+            substance_bvh_node_t * left = &self->nodes[i + 1];
+            substance_bvh_node_t * right = &self->nodes[left->escape];
+            fitted.lower = left->lower;
+            fitted.upper = left->upper;
+            substance_bvh_join(&fitted, &right->lower, &right->upper);
+        }
+
+        if (!substance_bvh_is_equal(&fitted.lower, &node->lower) ||
+            !substance_bvh_is_equal(&fitted.upper, &node->upper)) {
+            *node = fitted;
+            *is_changed = true;
+        }
+
+        area += substance_bvh_area(node);
+    }
+
+    return area;
+}
+
+// brings the hierarchy up to date with the substances as written to the
+// substance buffer, returning whether any of its nodes changed
+bool substance_bvh_update(substance_bvh_t *self, const substance_data_t *substances, uint32_t number_of_substances) {
+    self->lower.resize(number_of_substances);
+    self->upper.resize(number_of_substances);
+    for (uint32_t i = 0; i < number_of_substances; i++) {
+        substance_bvh_bound(&substances[i], &self->lower[i], &self->upper[i]);
+    }
+
+    if (number_of_substances == 0 && self->nodes.empty()) {
+        return false;
+    }
+
+    bool is_changed = false;
+    if (substance_bvh_follow(self, substances, number_of_substances, &is_changed)) {
+        float area = substance_bvh_refit(self, &is_changed);
+        self->refits++;
+
+        if (area <= self->built_area * SERAPHIM_BVH_REBUILD_RATIO) {
+            return is_changed;
+        }
+    }
+
+    self->nodes.clear();
+    self->ids.resize(number_of_substances);
+    self->order.resize(number_of_substances);
+    for (uint32_t i = 0; i < number_of_substances; i++) {
+        self->ids[i] = substances[i].id;
+        self->order[i] = i;
+    }
+
+    self->built_area = 0.0f;
+    if (number_of_substances > 0) {
+        substance_bvh_build(self, 0, number_of_substances);
+        for (substance_bvh_node_t &node : self->nodes) {
+            self->built_area += substance_bvh_area(&node);
+        }
+    }
+
+    self->rebuilds++;
+    return true;
+}
+
+void substance_bvh_statistics(substance_bvh_t *self, substance_bvh_statistics_t *statistics) {
+    statistics->rebuilds = self->rebuilds.exchange(0);
+    statistics->refits = self->refits.exchange(0);
+}
@@ -0,0 +1,63 @@
+#ifndef SERAPHIM_BVH_H
+#define SERAPHIM_BVH_H
+
+#include "../common/maths.h"
+#include "../common/substance_data.h"
+
+#include <atomic>
+#include <vector>
+
+// how much the bounds of a refitted hierarchy may grow, in total surface area,
+// from when it was built before it is built again
+#define SERAPHIM_BVH_REBUILD_RATIO 2.0f
+
+// a node of the hierarchy as the shader sees it. nodes are laid out depth
+// first, so that the first child of a branch follows it and a ray that misses a
+// node skips to its escape, the node after its last descendant. leaves hold a
+// single substance, by its index in the substance buffer, and branches ~0.
+typedef struct substance_bvh_node_t {
+    vec3f lower;
+    uint32_t escape;
+    vec3f upper;
+    uint32_t substance;
+} substance_bvh_node_t;
+
+static_assert(sizeof(substance_bvh_node_t) == 32, "nodes must match bvh_node_t in comp.glsl");
+
+typedef struct substance_bvh_statistics_t {
+    uint64_t rebuilds;
+    uint64_t refits;
+} substance_bvh_statistics_t;
+
+// a bounding volume hierarchy over the substances of the substance buffer,
+// which rays traverse to find the substances they may reach instead of testing
+// every substance at every step. the hierarchy is refitted to the bounds of
+// moving substances each frame, following them as their entries are reordered,
+// and only built again when substances come or go or its bounds grow too loose.
+typedef struct substance_bvh_t {
+    std::vector<substance_bvh_node_t> nodes;
+
+    // the ids of the substances, by their index when last updated, and the
+    // surface area of the nodes when last built
+    std::vector<uint32_t> ids;
+
+    // the index of each id while the leaves follow reordered substances, and
+    // ~0 otherwise
+    std::vector<uint32_t> indices;
+    float built_area;
+
+    // the world bound of each substance, and the substances being built over
+    std::vector<vec3f> lower;
+    std::vector<vec3f> upper;
+    std::vector<uint32_t> order;
+
+    std::atomic<uint64_t> rebuilds;
+    std::atomic<uint64_t> refits;
+} substance_bvh_t;
+
+void substance_bvh_create(substance_bvh_t *self);
+bool substance_bvh_update(substance_bvh_t *self, const substance_data_t *substances, uint32_t number_of_substances);
+uint32_t substance_bvh_capacity(uint32_t max_substances);
+void substance_bvh_statistics(substance_bvh_t *self, substance_bvh_statistics_t *statistics);
+
+#endif
@@ -0,0 +1,79 @@
+#include "cache.h"
+
+#include <stdlib.h>
+
+static const uint8_t cache_valid = 1;
+static const uint8_t cache_referenced = 2;
+
+void cache_create(cache_t *self, uint32_t size) {
+    self->number_of_sets = size / SERAPHIM_CACHE_WAYS;
+    self->hashes = (uint32_t *) calloc(size, sizeof(uint32_t));
+    self->flags = (uint8_t *) calloc(size, sizeof(uint8_t));
+    self->hands = (uint8_t *) calloc(self->number_of_sets, sizeof(uint8_t));
+
+    self->hits = 0;
+    self->misses = 0;
+    self->evictions = 0;
+}
+
+void cache_destroy(cache_t *self) {
+    free(self->hashes);
+    free(self->flags);
+    free(self->hands);
+}
+
+// finds the slot for a hash, choosing one in its set if it is not already
+// stored. returns true if the hash was already stored.
+bool cache_insert(cache_t *self, uint32_t hash, uint32_t *slot) {
+    uint32_t first = (hash % self->number_of_sets) * SERAPHIM_CACHE_WAYS;
+    int empty = -1;
+
+    for (int i = 0; i < SERAPHIM_CACHE_WAYS; i++) {
+        uint32_t way = first + i;
+        if ((self->flags[way] & cache_valid) == 0) {
+            if (empty < 0) {
+                empty = i;
+            }
+        } else if (self->hashes[way] == hash) {
+            self->flags[way] |= cache_referenced;
+            self->hits++;
+            *slot = way;
+            return true;
+        }
+    }
+
+    self->misses++;
+
+    uint32_t set = first / SERAPHIM_CACHE_WAYS;
+    if (empty < 0) {
+        // the hand clears references as it passes, so this finds a victim
+        // within one turn of the set
+        while (self->flags[first + self->hands[set]] & cache_referenced) {
+            self->flags[first + self->hands[set]] &= ~cache_referenced;
+            self->hands[set] = (self->hands[set] + 1) % SERAPHIM_CACHE_WAYS;
+        }
+
+        empty = self->hands[set];
+        self->hands[set] = (self->hands[set] + 1) % SERAPHIM_CACHE_WAYS;
+        self->evictions++;
+    }
+
+    // new slots are only referenced once they are hit, so that a set filled
+    // by hashes requested once evicts them before hashes requested again
+    *slot = first + empty;
+    self->hashes[*slot] = hash;
+    self->flags[*slot] = cache_valid;
+    return false;
+}
+
+// finds a hash that maps to another set than the slot's, which the shader can't
+// find in the slot, for a slot whose contents are being replaced
+uint32_t cache_invalid_hash(cache_t *self, uint32_t slot) {
+    return (slot / SERAPHIM_CACHE_WAYS + 1) % self->number_of_sets;
+}
+
+void cache_statistics(cache_t *self, cache_statistics_t *statistics) {
+    statistics->hits = self->hits.exchange(0);
+    statistics->misses = self->misses.exchange(0);
+    statistics->evictions = self->evictions.exchange(0);
+}
@@ -0,0 +1,39 @@
+#ifndef SERAPHIM_CACHE_H
+#define SERAPHIM_CACHE_H
+
+#include <stdint.h>
+
+#include <atomic>
+
+// slots in each set of a cache, which must match cache_ways in comp.glsl
+#define SERAPHIM_CACHE_WAYS 4
+
+typedef struct cache_statistics_t {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} cache_statistics_t;
+
+// the cpu side directory of a set associative pool on the device. a hash may
+// be stored in any way of the set it maps to, and the shader probes each way,
+// so that hashes mapping to the same set no longer overwrite each other. full
+// sets evict by clock, giving a second chance to slots referenced since the
+// hand last passed them.
+typedef struct cache_t {
+    uint32_t number_of_sets;
+    uint32_t *hashes;
+    uint8_t *flags;
+    uint8_t *hands;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> evictions;
+} cache_t;
+
+void cache_create(cache_t *self, uint32_t size);
+void cache_destroy(cache_t *self);
+bool cache_insert(cache_t *self, uint32_t hash, uint32_t *slot);
+uint32_t cache_invalid_hash(cache_t *self, uint32_t slot);
+void cache_statistics(cache_t *self, cache_statistics_t *statistics);
+
+#endif
@@ -0,0 +1,122 @@
+#include "capture.h"
+
+#include <string.h>
+
+static bool capture_open(capture_t *self, const char *filename, bool is_writing) {
+    self->file = fopen(filename, is_writing ? "wb" : "rb");
+    if (self->file == NULL) {
+        return false;
+    }
+
+    self->is_writing = is_writing;
+    self->num_sdfs = 0;
+    self->num_materials = 0;
+    self->start = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool capture_open_write(capture_t *self, const char *filename) {
+    if (!capture_open(self, filename, true)) {
+        return false;
+    }
+
+    uint32_t header[2] = { SERAPHIM_CAPTURE_MAGIC, SERAPHIM_CAPTURE_VERSION };
+    fwrite(header, sizeof(header), 1, self->file);
+    return true;
+}
+
+// returns false if the file can't be opened or isn't a capture of this version
+bool capture_open_read(capture_t *self, const char *filename) {
+    if (!capture_open(self, filename, false)) {
+        return false;
+    }
+
+    uint32_t header[2];
+    if (fread(header, sizeof(header), 1, self->file) != 1 ||
+        header[0] != SERAPHIM_CAPTURE_MAGIC || header[1] != SERAPHIM_CAPTURE_VERSION) {
+        capture_close(self);
+        return false;
+    }
+
+    return true;
+}
+
+void capture_close(capture_t *self) {
+    if (self->file != NULL) {
+        fclose(self->file);
+        self->file = NULL;
+    }
+}
+
+static void capture_write_sdf(capture_t *self, sdf_t *sdf) {
+    capture_sdf_t record = {};
+    record.id = sdf->id;
+
+    sdf_description_t description;
+    if (sdf_describe(sdf, &description) && description.data_size <= SERAPHIM_CAPTURE_DATA_SIZE &&
+        strlen(description.name) < SERAPHIM_CAPTURE_NAME_SIZE) {
+        record.is_described = 1;
+        strcpy(record.name, description.name);
+        record.data_size = (uint32_t) description.data_size;
+        memcpy(record.data, description.data, description.data_size);
+    }
+
+    uint32_t type = CAPTURE_RECORD_SDF;
+    fwrite(&type, sizeof(type), 1, self->file);
+    fwrite(&record, sizeof(record), 1, self->file);
+}
+
+// writes a batch of requests, after any sdfs and materials registered since the
+// last batch
+void capture_write_batch(capture_t *self, sdf_t *sdfs, uint32_t num_sdfs, material_t *materials,
+                         uint32_t num_materials, const request_t *requests, uint32_t count) {
+    for (; self->num_sdfs < num_sdfs; self->num_sdfs++) {
+        capture_write_sdf(self, &sdfs[self->num_sdfs]);
+    }
+
+    for (; self->num_materials < num_materials; self->num_materials++) {
+        uint32_t type = CAPTURE_RECORD_MATERIAL;
+        fwrite(&type, sizeof(type), 1, self->file);
+        fwrite(&materials[self->num_materials], sizeof(material_t), 1, self->file);
+    }
+
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - self->start;
+    double seconds = time.count();
+
+    uint32_t type = CAPTURE_RECORD_BATCH;
+    fwrite(&type, sizeof(type), 1, self->file);
+    fwrite(&seconds, sizeof(seconds), 1, self->file);
+    fwrite(&count, sizeof(count), 1, self->file);
+    fwrite(requests, sizeof(request_t), count, self->file);
+}
+
+// reads the next record, returning false at the end of the file
+bool capture_read(capture_t *self, capture_record_t *record) {
+    uint32_t type;
+    if (fread(&type, sizeof(type), 1, self->file) != 1) {
+        return false;
+    }
+
+    record->type = (capture_record_type_t) type;
+
+    if (type == CAPTURE_RECORD_SDF) {
+        return fread(&record->sdf, sizeof(record->sdf), 1, self->file) == 1;
+    }
+
+    if (type == CAPTURE_RECORD_MATERIAL) {
+        return fread(&record->material, sizeof(record->material), 1, self->file) == 1;
+    }
+
+    if (type == CAPTURE_RECORD_BATCH) {
+        uint32_t count;
+        if (fread(&record->time, sizeof(record->time), 1, self->file) != 1 ||
+            fread(&count, sizeof(count), 1, self->file) != 1) {
+            return false;
+        }
+
+        record->requests.resize(count);
+        return fread(record->requests.data(), sizeof(request_t), count, self->file) == count;
+    }
+
+    return false;
+}
@@ -0,0 +1,68 @@
+#ifndef SERAPHIM_CAPTURE_H
+#define SERAPHIM_CAPTURE_H
+
+#include "../backend/sdf.h"
+#include "../common/material.h"
+#include "../common/request_data.h"
+
+#include <stdio.h>
+
+#include <chrono>
+#include <vector>
+
+// identifies capture files, and the version of their layout
+#define SERAPHIM_CAPTURE_MAGIC 0x50414353
+#define SERAPHIM_CAPTURE_VERSION 1
+
+// longest name of a primitive sdf, and most bytes of parameters, in a capture
+#define SERAPHIM_CAPTURE_NAME_SIZE 16
+#define SERAPHIM_CAPTURE_DATA_SIZE 64
+
+typedef enum capture_record_type_t {
+    CAPTURE_RECORD_SDF = 1,
+    CAPTURE_RECORD_MATERIAL,
+    CAPTURE_RECORD_BATCH,
+} capture_record_type_t;
+
+// an sdf registration. sdfs that aren't primitives can't be created again from
+// a capture, so only their id is recorded.
+typedef struct capture_sdf_t {
+    uint32_t id;
+    uint32_t is_described;
+    char name[SERAPHIM_CAPTURE_NAME_SIZE];
+    uint32_t data_size;
+    uint8_t data[SERAPHIM_CAPTURE_DATA_SIZE];
+} capture_sdf_t;
+
+typedef struct capture_record_t {
+    capture_record_type_t type;
+
+    capture_sdf_t sdf;
+    material_t material;
+
+    // seconds since the capture started, and the live requests read back
+    double time;
+    std::vector<request_t> requests;
+} capture_record_t;
+
+// a file of the request batches read back each frame, preceded by the sdfs and
+// materials they refer to as each is first seen, which can be replayed without
+// a device
+typedef struct capture_t {
+    FILE *file;
+    bool is_writing;
+
+    uint32_t num_sdfs;
+    uint32_t num_materials;
+    std::chrono::steady_clock::time_point start;
+} capture_t;
+
+bool capture_open_write(capture_t *self, const char *filename);
+bool capture_open_read(capture_t *self, const char *filename);
+void capture_close(capture_t *self);
+
+void capture_write_batch(capture_t *self, sdf_t *sdfs, uint32_t num_sdfs, material_t *materials,
+                         uint32_t num_materials, const request_t *requests, uint32_t count);
+bool capture_read(capture_t *self, capture_record_t *record);
+
+#endif
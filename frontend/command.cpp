@@ -3,15 +3,25 @@
 
 void command_buffer_submit(command_buffer_t  * command_buffer, VkSemaphore wait_sema, VkSemaphore signal_sema,
                               VkFence fence, VkPipelineStageFlags stage) {
+    command_buffer_submit_semaphores(command_buffer, &wait_sema, &stage, wait_sema == VK_NULL_HANDLE ? 0 : 1,
+                                     &signal_sema, signal_sema == VK_NULL_HANDLE ? 0 : 1, fence);
+}
+
+// submits the command buffer once each of the wait semaphores is signalled, at
+// the matching stage, then signals each of the signal semaphores
+void command_buffer_submit_semaphores(command_buffer_t *command_buffer, const VkSemaphore *wait_semas,
+                                      const VkPipelineStageFlags *stages, uint32_t number_of_waits,
+                                      const VkSemaphore *signal_semas, uint32_t number_of_signals, VkFence fence) {
     VkSubmitInfo submit_info = {};
-    submit_info.pWaitDstStageMask = &stage;
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pWaitDstStageMask = stages;
     submit_info.commandBufferCount = 1;
     submit_info.pCommandBuffers = &command_buffer->command_buffer;
 
-    submit_info.waitSemaphoreCount = wait_sema == VK_NULL_HANDLE ? 0 : 1;
-    submit_info.pWaitSemaphores = &wait_sema;
-    submit_info.signalSemaphoreCount = signal_sema == VK_NULL_HANDLE ? 0 : 1;
-    submit_info.pSignalSemaphores = &signal_sema;
+    submit_info.waitSemaphoreCount = number_of_waits;
+    submit_info.pWaitSemaphores = wait_semas;
+    submit_info.signalSemaphoreCount = number_of_signals;
+    submit_info.pSignalSemaphores = signal_semas;
 
     if (vkQueueSubmit(command_buffer->pool->queue, 1, &submit_info, fence) != VK_SUCCESS) {
         printf("Error: Failed to submit command buffer to queue.");
@@ -56,6 +66,19 @@ void command_buffer_end(command_buffer_t *buffer) {
     }
 }
 
+// makes the given accesses recorded or submitted before the barrier available to
+// those recorded after it, for every buffer and image
+void command_buffer_record_barrier(VkCommandBuffer command_buffer, VkPipelineStageFlags source_stage,
+                                   VkAccessFlags source_access, VkPipelineStageFlags destination_stage,
+                                   VkAccessFlags destination_access) {
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = source_access;
+    barrier.dstAccessMask = destination_access;
+
+    vkCmdPipelineBarrier(command_buffer, source_stage, destination_stage, 0, 1, &barrier, 0, NULL, 0, NULL);
+}
+
 void command_buffer_destroy(command_buffer_t *command_buffer) {
     vkFreeCommandBuffers(command_buffer->pool->device, command_buffer->pool->command_pool, 1, &command_buffer->command_buffer);
 }
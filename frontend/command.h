@@ -26,9 +26,15 @@ void command_buffer_destroy(command_buffer_t * command_buffer);
 void
 command_buffer_submit(command_buffer_t *command_buffer, VkSemaphore wait_sema, VkSemaphore signal_sema, VkFence fence,
                       VkPipelineStageFlags stage);
+void command_buffer_submit_semaphores(command_buffer_t *command_buffer, const VkSemaphore *wait_semas,
+                                      const VkPipelineStageFlags *stages, uint32_t number_of_waits,
+                                      const VkSemaphore *signal_semas, uint32_t number_of_signals, VkFence fence);
 
 void command_buffer_begin_buffer(command_pool_t * pool, command_buffer_t *buffer, bool is_one_time);
 void command_buffer_end(command_buffer_t *buffer);
+void command_buffer_record_barrier(VkCommandBuffer command_buffer, VkPipelineStageFlags source_stage,
+                                   VkAccessFlags source_access, VkPipelineStageFlags destination_stage,
+                                   VkAccessFlags destination_access);
 
 void command_pool_create(command_pool_t * pool, VkDevice device, uint32_t queue_family);
 void command_pool_destroy(command_pool_t * pool);
@@ -15,6 +15,7 @@ struct substance_t {
     uint id;
 
     mat4 transform;
+    mat4 inverse_transform;
 };
 
 struct intersection_t {
@@ -64,6 +65,13 @@ struct patch_t {
     uint normal;
 };
 
+struct bvh_node_t {
+    vec3 lower;
+    uint escape;
+    vec3 upper;
+    uint substance;
+};
+
 struct work_group_persistent_t {
     float near_plane;
     float far_plane;
@@ -85,6 +93,12 @@ const uint geometry_request = 1;
 const uint texture_request = 2;
 const uint raycast_request = 3;
 
+// must match number_of_requests in request.h
+const uint max_requests = 2048;
+
+// must match SERAPHIM_CACHE_WAYS in cache.h
+const uint cache_ways = 4;
+
 const ivec4 p1 = ivec4(
     904601,
     12582917,
@@ -134,21 +148,37 @@ layout(push_constant) uniform push_constants {
     float epsilon;
 
     uint number_of_raycasts;
-    uvec3 _unused;
+    uint number_of_bvh_nodes;
+    uvec2 _unused;
 } pc;
 
 layout (binding = 1) buffer patch_buffer        { patch_t     data[]; } patches;
-layout (binding = 2) buffer request_buffer      { request_t   data[]; } requests;
+layout (binding = 2) buffer request_buffer {
+    uint count;
+    uint _1;
+    uint _2;
+    uint _3;
+    request_t data[max_requests];
+    uint claims[];
+} requests;
 layout (binding = 3) buffer lights_buffer       { light_t     data[]; } lights_global;
 layout (binding = 4) buffer substance_buffer    { substance_t data[]; } substance;
 layout (binding = 5) buffer pointer_buffer      { uint        data[]; } pointers;
 layout (binding = 6) buffer work_group_persistent_buffer { work_group_persistent_t  data[]; } work_group_persistent;
+layout (binding = 7) buffer bin_buffer          { uint        data[]; } bins;
 layout (binding = 8) buffer texture_hash_buffer { uint        data[]; } texture_hash;
 layout (binding = 9) buffer raycast_buffer      { ray_intersection_t   data[]; } raycasts;
+layout (binding = 14) buffer bvh_buffer         { bvh_node_t  data[]; } bvh;
 
 shared substance_t substances[gl_WorkGroupSize.x];
 shared uint substances_size;
 
+// the work group's substances, binned on the cpu, start at bin_first in the bin
+// buffer. the first of them are kept in shared memory, and raycast only steps
+// through them one by one when all of them are.
+uint bin_first;
+uint bin_size;
+
 shared light_t lights[gl_WorkGroupSize.x];
 shared uint lights_size;
 
@@ -181,6 +211,21 @@ request_t build_request(substance_t substance, vec3 x, int order, uint hash, uin
     return result;
 }
 
+// appends a request to the compact list read back by the cpu. each request
+// claims a slot by its hash first so that the many invocations making the same
+// request only append it once.
+void push_request(request_t request){
+    uint key = (request.hash << 2) | request.status;
+    if (atomicExchange(requests.claims[request.hash % pc.number_of_calls], key) == key){
+        return;
+    }
+
+    uint index = atomicAdd(requests.count, 1);
+    if (index < max_requests){
+        requests.data[index] = request;
+    }
+}
+
 vec2 uv(vec2 xy){
     vec2 uv = xy / (gl_NumWorkGroups.xy * gl_WorkGroupSize.xy);
     uv = uv * 2.0 - 1.0;
@@ -225,14 +270,22 @@ patch_t get_patch(
 
     // calculate some useful variables for doing lookups
     uint index = hash % work_group_size;
-    uint geometry_index = hash % pc.geometry_pool_size;
+    uint geometry_index = (hash % (pc.geometry_pool_size / cache_ways)) * cache_ways;
 
     uvec4 udata = floatBitsToUint(workspace[index]);
     patch_t patch_ = patch_t(udata.x, udata.y, workspace[index].z, udata.w);
 
     if (patch_.hash != hash) {
-        pointers.data[index + work_group_offset()] = geometry_index;
-        patch_ = patches.data[geometry_index];
+        // the patch may be in any way of its set
+        uint way = 0;
+        for (; way < cache_ways; way++){
+            patch_ = patches.data[geometry_index + way];
+            if (patch_.hash == hash){
+                break;
+            }
+        }
+
+        pointers.data[index + work_group_offset()] = geometry_index + min(way, cache_ways - 1);
         if (patch_.hash != hash){
             request = build_request(substance, x, order, hash, geometry_request);
             is_patch_found = false;
@@ -243,7 +296,7 @@ patch_t get_patch(
 }
 
 float phi(ray_t global_r, substance_t sub, inout intersection_t intersection, inout request_t request){
-    mat4 inv = inverse(sub.transform);
+    mat4 inv = sub.inverse_transform;
     ray_t r = ray_t(
         (inv * vec4(global_r.x, 1)).xyz,
         mat3(inv) * global_r.d
@@ -251,6 +304,11 @@ float phi(ray_t global_r, substance_t sub, inout intersection_t intersection, in
 
     vec3 faces = -sign(r.d) * sub.radius;
     vec3 phis = (faces - r.x) / r.d;
+
+    // rays parallel to a pair of faces only reach the aabb between them
+    vec3 phis_parallel = mix(vec3(-pc.render_distance), vec3(pc.render_distance),
+                             greaterThanEqual(abs(r.x), sub.radius));
+    phis = mix(phis, phis_parallel, equal(r.d, vec3(0)));
     float phi_aabb = max(phis.x, max(phis.y, phis.z));
 
     // check against outside bounds of aabb
@@ -288,6 +346,25 @@ float phi(ray_t global_r, substance_t sub, inout intersection_t intersection, in
     return mix(phi_aabb, phi, inside_aabb);
 }
 
+// the distance along the ray to where it enters the node's bound, which is zero
+// if it is inside, or the render distance if it misses
+float bvh_distance(ray_t r, bvh_node_t node){
+    vec3 a = (node.lower - r.x) / r.d;
+    vec3 b = (node.upper - r.x) / r.d;
+    vec3 near = min(a, b);
+    vec3 far = max(a, b);
+
+    // rays parallel to a pair of faces are only within the bound between them
+    bvec3 is_parallel = equal(r.d, vec3(0));
+    vec3 between = step(node.lower, r.x) * step(r.x, node.upper);
+    near = mix(near, mix(vec3(pc.render_distance), vec3(-pc.render_distance), between), is_parallel);
+    far = mix(far, mix(vec3(-pc.render_distance), vec3(pc.render_distance), between), is_parallel);
+
+    float t_near = max(max(near.x, near.y), max(near.z, 0));
+    float t_far = min(far.x, min(far.y, far.z));
+    return mix(pc.render_distance, t_near, t_near <= t_far);
+}
+
 intersection_t raycast(ray_t r, inout request_t request){
     uint steps;
     intersection_t intersection;
@@ -299,11 +376,32 @@ intersection_t raycast(ray_t r, inout request_t request){
 
     for (steps = 0; !intersection.hit && steps < max_steps && intersection.distance < pc.render_distance; steps++){
         float p = pc.render_distance;
-        min_substanceID += int(intersection.distance > substances[min_substanceID].far);
 
-        for (uint substanceID = min_substanceID; !intersection.hit && substanceID < substances_size; substanceID++){
-            p = min(p, phi(r, substances[substanceID], intersection, request));
-            intersection.hit = p < pc.epsilon;
+        if (bin_size <= gl_WorkGroupSize.x){
+            // all of the work group's substances fit in shared memory here
+            min_substanceID += int(min_substanceID < bin_size && intersection.distance > substances[min_substanceID].far);
+
+            for (uint substanceID = min_substanceID; !intersection.hit && substanceID < bin_size; substanceID++){
+                p = min(p, phi(r, substances[substanceID], intersection, request));
+                intersection.hit = p < pc.epsilon;
+            }
+        } else {
+            // too many substances to step through each one, so only those whose
+            // bounds the ray enters before its step ends are found from the bvh
+            for (uint nodeID = 0; !intersection.hit && nodeID < pc.number_of_bvh_nodes;){
+                bvh_node_t node = bvh.data[nodeID];
+                bool is_near = bvh_distance(r, node) < p;
+
+                if (is_near && node.substance != ~0){
+                    substance_t sub = substance.data[node.substance];
+                    if (intersection.distance <= sub.far){
+                        p = min(p, phi(r, sub, intersection, request));
+                        intersection.hit = p < pc.epsilon;
+                    }
+                }
+
+                nodeID = is_near ? nodeID + 1 : node.escape;
+            }
         }
         r.x += r.d * p;
         intersection.distance += p;
@@ -314,7 +412,7 @@ intersection_t raycast(ray_t r, inout request_t request){
 }
 
 float shadow_cast(vec3 light_position, vec3 geometry_position, substance_t sub, inout request_t request){
-    mat4 inv = inverse(sub.transform);
+    mat4 inv = sub.inverse_transform;
     light_position = (inv * vec4(light_position, 1)).xyz;
     geometry_position = (inv * vec4(geometry_position, 1)).xyz;
 
@@ -542,14 +640,23 @@ void render(uint i, uint j, substance_t s, uint shadow_index, uint shadow_size){
     }
 
     // find texture coordinate
-    mat4 inv = inverse(intersection.substance.transform);
+    mat4 inv = intersection.substance.inverse_transform;
     vec3 x =  (inv * vec4(intersection.x, 1)).xyz;
     int order = expected_order(x) * 2;
     float size = expected_size(order);
     vec3 x_scaled = x / size;
     vec3 alpha = x_scaled - floor(x_scaled);
     uint texture_hash_ = get_hash(x, order, int(intersection.substance.material_id));
-    uint texture_index = texture_hash_ % pc.texture_pool_size;
+    uint texture_set = (texture_hash_ % (pc.texture_pool_size / cache_ways)) * cache_ways;
+    uint texture_index = texture_set;
+    bool texture_data_present = false;
+    for (uint way = 0; way < cache_ways; way++){
+        if (texture_hash.data[texture_set + way] == texture_hash_){
+            texture_index = texture_set + way;
+            texture_data_present = true;
+            break;
+        }
+    }
     vec3 t = alpha * 0.5 + 0.25;
 
     t += vec3(
@@ -582,8 +689,6 @@ void render(uint i, uint j, substance_t s, uint shadow_index, uint shadow_size){
     //    barrier();
     //    image_colour = mix(image_colour, vec3(0, 1, 0), test);
     //    barrier();
-    bool texture_data_present = texture_hash.data[texture_index] == texture_hash_;
-
     if (!intersection.hit || texture_data_present){
         imageStore(render_texture, ivec2(gl_GlobalInvocationID.xy), vec4(image_colour, 1));
     }
@@ -592,83 +697,49 @@ void render(uint i, uint j, substance_t s, uint shadow_index, uint shadow_size){
 
     if (intersection.hit && !texture_data_present){
         request_t texture_request = build_request(intersection.substance, x, order, texture_hash_, texture_request);
-        requests.data[texture_hash_ % pc.number_of_calls] = texture_request;
+        push_request(texture_request);
     }
 
     barrier();
     if (geometry_request.status != null_request){
-        requests.data[geometry_request.hash % pc.number_of_calls] = geometry_request;
+        push_request(geometry_request);
     }
 }
 
-bool is_light_visible(light_t l, float near, float far, mat4x3 normals){
+bool is_light_visible(light_t l, float near, float far){
     return l.id != ~0;
 }
 
-bool is_substance_visible(substance_t sub, mat4x3 normals_global){
-    mat4 inv = inverse(sub.transform);
-    mat4x3 normals = mat3(inv) * normals_global;
-    vec3 eye = (inv * pc.eye_transform[3]).xyz;
-    vec4 ds = transpose(normals) * eye;
-
-    vec4 phis = vec4(
-        dot(abs(normals[0]), vec3(sub.radius)),
-        dot(abs(normals[1]), vec3(sub.radius)),
-        dot(abs(normals[2]), vec3(sub.radius)),
-        dot(abs(normals[3]), vec3(sub.radius))
-    );
-
-    vec3 f = mat3(sub.transform) * get_ray_direction(gl_WorkGroupID.xy * gl_WorkGroupSize.xy + gl_WorkGroupSize.xy / 2);
-
-    // TODO: fix this line
-    bool is_behind  = false;//all(greaterThan(sub.radius + eye * sign(f), vec3(0)));
-    bool is_eye_inside = false;//all(lessThanEqual(eye, sub.radius));
-
-    bool is_visible =
-    sub.id != ~0 && sub.near < pc.render_distance &&
-    (all(greaterThan(phis, ds)) || is_eye_inside) && !is_behind;
-
-    return is_visible;
-}
-
 bool is_shadow_visible(substance_t s, vec2 view_frustum, vec3 light_position){
     return s.id != ~0;
 }
 
 void prerender(uint i, uint j, substance_t s, out uint shadow_index, out uint shadow_size){
-    mat4x3 rays = mat4x3(
-        get_ray_direction( gl_WorkGroupID.xy                * gl_WorkGroupSize.xy),
-        get_ray_direction((gl_WorkGroupID.xy + uvec2(1, 0)) * gl_WorkGroupSize.xy),
-        get_ray_direction((gl_WorkGroupID.xy + uvec2(1, 1)) * gl_WorkGroupSize.xy),
-        get_ray_direction((gl_WorkGroupID.xy + uvec2(0, 1)) * gl_WorkGroupSize.xy)
-    );
-
-    mat4x3 normals = mat4x3(
-        cross(rays[1], rays[0]), cross(rays[2], rays[1]),
-        cross(rays[3], rays[2]), cross(rays[0], rays[3])
-    );
-
     // load shit
     light_t l = lights_global.data[i];
     work_group_persistent_t persistent = work_group_persistent.data[j];
     vec2 view_frustum = vec2(persistent.near_plane, persistent.far_plane);
 
-    // visibility check on substances and load into shared memory
+    // the substances that may be seen were binned by the cpu, so only the
+    // nearest need loading into shared memory
+    bin_first = bins.data[j];
+    bin_size = bins.data[j + 1] - bin_first;
+    substances_size = min(bin_size, gl_WorkGroupSize.x);
+    if (i < substances_size){
+        substances[i] = substance.data[bins.data[bin_first + i]];
+    }
+
+    // visibility check on lights and load into shared memory
     barrier();
     bvec4 hits = bvec4(
-        is_substance_visible(s, normals),
-        is_light_visible(l, view_frustum.x, view_frustum.y, normals),
+        false,
+        is_light_visible(l, view_frustum.x, view_frustum.y),
         is_shadow_visible(s, view_frustum, vec3(0)),
         false
     );
     uvec4 totals;
     uvec4 indices = reduce_to_fit(i, hits, totals);
 
-    substances_size = totals.x;
-    if (indices.x != ~0){
-        substances[indices.x] = s;
-    }
-
     lights_size = totals.y;
     if (indices.y != ~0){
         lights[indices.y] = l;
@@ -678,7 +749,7 @@ void prerender(uint i, uint j, substance_t s, out uint shadow_index, out uint sh
     shadow_size = totals.z;
 
     // load patches from global memory into shared memory
-    patch_t data = patches.data[pointers.data[i]];
+    patch_t data = patches.data[pointers.data[i + work_group_offset()]];
     vec3 udata = uintBitsToFloat(uvec3(data.contents, data.hash, data.normal));
     workspace[i] = vec4(udata.x, udata.y, data.phi, udata.z);
 }
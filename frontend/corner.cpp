@@ -0,0 +1,90 @@
+#include "corner.h"
+
+#include <stdlib.h>
+
+static_assert((SERAPHIM_CORNER_CACHE_SIZE & (SERAPHIM_CORNER_CACHE_SIZE - 1)) == 0,
+              "corner cache size must be a power of two");
+
+void corner_cache_create(corner_cache_t *self) {
+    for (int i = 0; i < SERAPHIM_CORNER_CACHE_STRIPES; i++) {
+        mtx_init(&self->stripes[i], mtx_plain);
+    }
+
+    self->keys = (corner_key_t *) calloc(SERAPHIM_CORNER_CACHE_SIZE, sizeof(corner_key_t));
+    self->samples = (corner_sample_t *) calloc(SERAPHIM_CORNER_CACHE_SIZE, sizeof(corner_sample_t));
+    self->is_valid = (bool *) calloc(SERAPHIM_CORNER_CACHE_SIZE, sizeof(bool));
+
+    self->hits = 0;
+    self->misses = 0;
+}
+
+void corner_cache_destroy(corner_cache_t *self) {
+    for (int i = 0; i < SERAPHIM_CORNER_CACHE_STRIPES; i++) {
+        mtx_destroy(&self->stripes[i]);
+    }
+
+    free(self->keys);
+    free(self->samples);
+    free(self->is_valid);
+}
+
+static uint32_t corner_key_hash(const corner_key_t *key) {
+    uint32_t hash = key->sdf_id * 0x9E3779B1u;
+    hash = (hash ^ (uint32_t) key->corner.x) * 0xC2B2AE3Du;
+    hash = (hash ^ (uint32_t) key->corner.y) * 0x27D4EB2Fu;
+    hash = (hash ^ (uint32_t) key->corner.z) * 0x165667B1u;
+    return hash ^ (hash >> 15);
+}
+
+static bool corner_key_is_equal(const corner_key_t *a, const corner_key_t *b) {
+    return a->sdf_id == b->sdf_id &&
+           a->corner.x == b->corner.x && a->corner.y == b->corner.y && a->corner.z == b->corner.z;
+}
+
+// finds the sample of the sdf at x, the corner identified by key, evaluating
+// the sdf only for the parts of the sample that are not already cached
+void corner_cache_sample(corner_cache_t *self, sdf_t *sdf, const corner_key_t *key, const vec3 *x,
+                         bool needs_normal, corner_sample_t *sample) {
+    uint32_t index = corner_key_hash(key) & (SERAPHIM_CORNER_CACHE_SIZE - 1);
+    mtx_t * stripe = &self->stripes[index % SERAPHIM_CORNER_CACHE_STRIPES];
+
+    bool is_found = false;
+    mtx_lock(stripe);
+    {
+        if (self->is_valid[index] && corner_key_is_equal(&self->keys[index], key)) {
+            *sample = self->samples[index];
+            is_found = true;
+        }
+    }
+    mtx_unlock(stripe);
+
+    if (is_found && (sample->has_normal || !needs_normal)) {
+        self->hits++;
+        return;
+    }
+
+    self->misses++;
+
+    if (!is_found) {
+        sample->phi = sdf_distance(sdf, x);
+        sample->has_normal = false;
+    }
+
+    if (needs_normal) {
+        sample->normal = sdf_normal(sdf, x);
+        sample->has_normal = true;
+    }
+
+    mtx_lock(stripe);
+    {
+        self->keys[index] = *key;
+        self->samples[index] = *sample;
+        self->is_valid[index] = true;
+    }
+    mtx_unlock(stripe);
+}
+
+void corner_cache_statistics(corner_cache_t *self, corner_cache_statistics_t *statistics) {
+    statistics->hits = self->hits.exchange(0);
+    statistics->misses = self->misses.exchange(0);
+}
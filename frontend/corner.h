@@ -0,0 +1,55 @@
+#ifndef SERAPHIM_CORNER_H
+#define SERAPHIM_CORNER_H
+
+#include "../backend/sdf.h"
+
+#include <threads.h>
+
+#include <atomic>
+
+// corner samples remembered at once, which must be a power of two
+#define SERAPHIM_CORNER_CACHE_SIZE 65536
+
+// locks shared between the entries of the cache
+#define SERAPHIM_CORNER_CACHE_STRIPES 64
+
+// a corner of request cells, on a grid that the corners of cells of every size
+// lie on
+typedef struct corner_key_t {
+    uint32_t sdf_id;
+    vec3i corner;
+} corner_key_t;
+
+typedef struct corner_sample_t {
+    double phi;
+    vec3 normal;
+    bool has_normal;
+} corner_sample_t;
+
+typedef struct corner_cache_statistics_t {
+    uint64_t hits;
+    uint64_t misses;
+} corner_cache_statistics_t;
+
+// samples of an sdf at the corners of request cells, shared between workers
+// and between geometry and texture requests. neighbouring cells share corners,
+// and a texture cell's corners are also corners of the smaller geometry cells
+// it covers, so most corners are evaluated once. entries are replaced when
+// another corner maps to the same place.
+typedef struct corner_cache_t {
+    mtx_t stripes[SERAPHIM_CORNER_CACHE_STRIPES];
+    corner_key_t * keys;
+    corner_sample_t * samples;
+    bool * is_valid;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+} corner_cache_t;
+
+void corner_cache_create(corner_cache_t *self);
+void corner_cache_destroy(corner_cache_t *self);
+void corner_cache_sample(corner_cache_t *self, sdf_t *sdf, const corner_key_t *key, const vec3 *x,
+                         bool needs_normal, corner_sample_t *sample);
+void corner_cache_statistics(corner_cache_t *self, corner_cache_statistics_t *statistics);
+
+#endif
@@ -46,9 +46,12 @@ static bool has_adequate_queue_families(VkPhysicalDevice physical_device,
                                              queue_families);
 
     for (uint32_t i = 0; i < queue_family_count; i++) {
-        VkBool32 present_support = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface,
-                                             &present_support);
+        // without a surface nothing is presented
+        VkBool32 present_support = surface == VK_NULL_HANDLE;
+        if (surface != VK_NULL_HANDLE) {
+            vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface,
+                                                 &present_support);
+        }
 
         if (queue_families[i].queueCount > 0) {
             queue_families_found[0] |= present_support;
@@ -65,10 +68,11 @@ static bool has_adequate_queue_families(VkPhysicalDevice physical_device,
 
 static bool is_suitable_device(VkPhysicalDevice physical_device,
                                   VkSurfaceKHR surface) {
-    // check that gpu isnt integrated
+    // check that gpu isnt integrated, unless rendering without a surface, which
+    // is also done with software drivers on machines without a gpu
     VkPhysicalDeviceProperties properties;
     vkGetPhysicalDeviceProperties(physical_device, &properties);
-    if (properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
+    if (surface != VK_NULL_HANDLE && properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
         return false;
     }
 
@@ -81,6 +85,10 @@ static bool is_suitable_device(VkPhysicalDevice physical_device,
         return false;
     }
 
+    if (surface == VK_NULL_HANDLE) {
+        return true;
+    }
+
     size_t num_extensions = sizeof(device_extensions) / sizeof(*device_extensions);
     for (uint32_t i = 0; i < num_extensions; i++) {
         if (!device_has_extension(physical_device, device_extensions[i])) {
@@ -130,8 +138,10 @@ static void select_queue_families(device_t * device, VkSurfaceKHR surface) {
 
     for (uint32_t i = 0; i < queue_family_count; i++) {
         VkBool32 present_support = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device->physical_device, i, surface,
-                                             &present_support);
+        if (surface != VK_NULL_HANDLE) {
+            vkGetPhysicalDeviceSurfaceSupportKHR(device->physical_device, i, surface,
+                                                 &present_support);
+        }
 
         if (queue_family_properties[i].queueCount > 0) {
             if (present_support) {
@@ -147,6 +157,11 @@ static void select_queue_families(device_t * device, VkSurfaceKHR surface) {
             }
         }
     }
+
+    // without a surface nothing is presented, so no other family is needed
+    if (surface == VK_NULL_HANDLE) {
+        device->present_family = device->graphics_family;
+    }
 }
 
 uint32_t device_memory_type(device_t *device, uint32_t type_filter,
@@ -194,7 +209,9 @@ void device_create(device_t *device, VkInstance instance, VkSurfaceKHR surface,
     create_info.pQueueCreateInfos = queue_create_infos;
     create_info.queueCreateInfoCount = num_queue_create_infos;
     create_info.pEnabledFeatures = &device_features;
-    create_info.enabledExtensionCount = sizeof(device_extensions) / sizeof(*device_extensions);
+    // the swapchain is only needed to present to a surface
+    create_info.enabledExtensionCount =
+        surface == VK_NULL_HANDLE ? 0 : sizeof(device_extensions) / sizeof(*device_extensions);
     create_info.ppEnabledExtensionNames = device_extensions;
     create_info.enabledLayerCount = num_validation_layers;
     create_info.ppEnabledLayerNames = enabled_validation_layers;
@@ -203,8 +220,12 @@ void device_create(device_t *device, VkInstance instance, VkSurfaceKHR surface,
         VK_SUCCESS) {
         PANIC("Error: failed to create device");
     }
+
+    allocator_create(&device->allocator, device->physical_device, device->device);
+    device->staging = NULL;
 }
 
 void device_destroy(device_t *device) {
+    allocator_destroy(&device->allocator);
     vkDestroyDevice(device->device, NULL);
 }
@@ -4,6 +4,8 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include "allocator.h"
+
 #include <vector>
 
 typedef struct device_t {
@@ -12,6 +14,11 @@ typedef struct device_t {
     uint32_t graphics_family;
     uint32_t present_family;
     uint32_t compute_family;
+
+    // every buffer and image takes its memory from the allocator, and every
+    // write to a device local buffer is staged through the renderer's staging
+    allocator_t allocator;
+    struct staging_t * staging;
 } device_t;
 
 
@@ -0,0 +1,288 @@
+#include "generator.h"
+
+#include "../common/constant.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const vec3 vertices[8] = {
+    {{0.0, 0.0, 0.0}}, {{2.0, 0.0, 0.0}},
+    {{0.0, 2.0, 0.0}}, {{2.0, 2.0, 0.0}},
+    {{0.0, 0.0, 2.0}}, {{2.0, 0.0, 2.0}},
+    {{0.0, 2.0, 2.0}}, {{2.0, 2.0, 2.0}}
+};
+
+static uint32_t pack_vector(vec4 *x) {
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (uint8_t)(fmax(0.0, fmin(x->v[i] * 255.0, 255.0)));
+    }
+    return *(uint32_t *) bytes;
+}
+
+// identifies corner o of the cell of a request. cells are 2 * epsilon * order
+// wide, so the corners of cells of every size lie on a grid 2 * epsilon apart,
+// which lets a texture cell share corners with the smaller geometry cells
+static void generator_corner_key(const request_t *request, int o, corner_key_t *key) {
+    float size = 2.0f * request->radius;
+    float spacing = (float) (2.0 * epsilon);
+    key->sdf_id = request->sdf_id;
+    key->corner = {{
+        (mint_t) lroundf((request->position.x + size * (o & 1)) / spacing),
+        (mint_t) lroundf((request->position.y + size * ((o >> 1) & 1)) / spacing),
+        (mint_t) lroundf((request->position.z + size * ((o >> 2) & 1)) / spacing)
+    }};
+}
+
+void generator_create(generator_t *self, sdf_t *sdfs, uint32_t *num_sdfs, material_t *materials,
+                      uint32_t *num_materials) {
+    self->sdfs = sdfs;
+    self->num_sdfs = num_sdfs;
+    self->materials = materials;
+    self->num_materials = num_materials;
+    corner_cache_create(&self->corner_cache);
+    self->has_stores = false;
+}
+
+void generator_destroy(generator_t *self) {
+    corner_cache_destroy(&self->corner_cache);
+
+    if (self->has_stores) {
+        store_close(&self->patch_store);
+        store_close(&self->texture_store);
+    }
+}
+
+// opens the stores of generated patches and textures. this must happen before
+// any requests are handled. returns false if either can't be opened.
+bool generator_open_stores(generator_t *self, const char *patch_filename, const char *texture_filename) {
+    if (!store_open(&self->patch_store, patch_filename, sizeof(patch_t), SERAPHIM_GENERATOR_STORED_PATCHES)) {
+        return false;
+    }
+
+    if (!store_open(&self->texture_store, texture_filename, sizeof(texture_response_t),
+                    SERAPHIM_GENERATOR_STORED_TEXTURES)) {
+        store_close(&self->patch_store);
+        return false;
+    }
+
+    self->has_stores = true;
+    return true;
+}
+
+void generator_store_statistics(generator_t *self, store_statistics_t *patches, store_statistics_t *textures) {
+    if (!self->has_stores) {
+        *patches = {};
+        *textures = {};
+        return;
+    }
+
+    store_statistics(&self->patch_store, patches);
+    store_statistics(&self->texture_store, textures);
+}
+
+// hashes the definition of an sdf, returning false if it can't be described,
+// in which case what is generated from it isn't stored
+static bool generator_sdf_content(generator_t *self, uint32_t sdf_id, uint32_t *content) {
+    sdf_description_t description;
+    if (!sdf_describe(&self->sdfs[sdf_id], &description)) {
+        return false;
+    }
+
+    uint32_t hash = store_hash(2166136261u, description.name, strlen(description.name));
+    *content = store_hash(hash, description.data, description.data_size);
+    return true;
+}
+
+// hashes the definition of a material, field by field so that padding is left out
+static uint32_t generator_material_content(const material_t *material, uint32_t hash) {
+    hash = store_hash(hash, &material->colour, sizeof(material->colour));
+    hash = store_hash(hash, &material->density, sizeof(material->density));
+    hash = store_hash(hash, &material->restitution, sizeof(material->restitution));
+    hash = store_hash(hash, &material->static_friction, sizeof(material->static_friction));
+    hash = store_hash(hash, &material->dynamic_friction, sizeof(material->dynamic_friction));
+    hash = store_hash(hash, &material->metallic, sizeof(material->metallic));
+    hash = store_hash(hash, &material->roughness, sizeof(material->roughness));
+    return store_hash(hash, &material->reflectance, sizeof(material->reflectance));
+}
+
+// returns false if the request is for an sdf that doesn't exist
+bool generator_geometry(generator_t *self, const request_t *request, patch_t *patch) {
+    uint32_t sdf_id = request->sdf_id;
+    if (sdf_id >= *self->num_sdfs) {
+        return false;
+    }
+
+    // patches are stored by the definition of their sdf and the hash of their cell
+    uint32_t content = 0;
+    bool is_stored = self->has_stores && generator_sdf_content(self, sdf_id, &content);
+    uint64_t key = ((uint64_t) content << 32) | request->hash;
+    if (is_stored && store_load(&self->patch_store, key, patch)) {
+        return true;
+    }
+
+    bound3_t *bound = sdf_bound(&self->sdfs[sdf_id]);
+    vec3 midpoint;
+    bound3_midpoint(bound, &midpoint);
+    vec3 position = {{request->position.x, request->position.y, request->position.z}};
+    vec3_subtract(&position, &position, &midpoint);
+
+    bound3_t cell;
+    cell.lower = position;
+    vec3_add_f(&cell.upper, &position, 2.0 * request->radius);
+
+    interval_t cell_phi;
+    sdf_distance_interval(&self->sdfs[sdf_id], &cell, &cell_phi);
+
+    uint32_t containsMask = 0;
+
+    if (interval_is_positive(&cell_phi)) {
+        containsMask = 0xFF;
+    } else if (!interval_is_non_positive(&cell_phi) ||
+               !bound3_contains(bound, &cell.lower) ||
+               !bound3_contains(bound, &cell.upper)) {
+        for (int o = 0; o < 8; o++) {
+            vec3 d;
+            vec3_multiply_f(&d, (vec3 *) &vertices[o], request->radius);
+            vec3_add(&d, &d, &position);
+
+            corner_key_t key;
+            corner_sample_t sample;
+            generator_corner_key(request, o, &key);
+            corner_cache_sample(&self->corner_cache, &self->sdfs[sdf_id], &key, &d, false, &sample);
+
+            if (!bound3_contains(bound, &d) || sample.phi > 0.0) {
+                containsMask |= 1 << o;
+            }
+        }
+    }
+
+    vec3 c;
+    vec3_multiply_f(&c, &position, request->radius);
+    float phi = (float) sdf_distance(&self->sdfs[sdf_id], &c);
+
+    vec4 normal = vec4_zero;
+    normal.xyz = sdf_normal(&self->sdfs[sdf_id], &c);
+    vec4_divide_f(&normal, &normal, 2);
+    vec4_add_f(&normal, &normal, 0.5);
+    uint32_t packed_normal = pack_vector(&normal);
+
+    *patch = {
+        .contents = containsMask << 16,
+        .hash = request->hash,
+        .phi = phi,
+        .normal = packed_normal,
+    };
+
+    if (is_stored) {
+        store_save(&self->patch_store, key, patch);
+    }
+
+    return true;
+}
+
+// returns false if the request is for an sdf or material that doesn't exist
+bool generator_texture(generator_t *self, const request_t *request, texture_response_t *response) {
+    uint32_t material_id = request->material_id;
+    uint32_t sdf_id = request->sdf_id;
+    if (material_id >= *self->num_materials || sdf_id >= *self->num_sdfs) {
+        return false;
+    }
+
+    // textures depend on both the normals of the sdf and the material
+    uint32_t content = 0;
+    bool is_stored = self->has_stores && generator_sdf_content(self, sdf_id, &content);
+    content = generator_material_content(&self->materials[material_id], content);
+    uint64_t key = ((uint64_t) content << 32) | request->hash;
+    if (is_stored && store_load(&self->texture_store, key, response)) {
+        return true;
+    }
+
+    uint32_t * normals = response->samples[TEXTURE_TYPE_NORMAL];
+    uint32_t * colours = response->samples[TEXTURE_TYPE_COLOUR];
+    uint32_t * physicals = response->samples[TEXTURE_TYPE_PHYSICAL];
+    bound3_t *bound = sdf_bound(&self->sdfs[sdf_id]);
+    vec3 midpoint;
+    bound3_midpoint(bound, &midpoint);
+    vec3 position = {{request->position.x, request->position.y, request->position.z}};
+    vec3_subtract(&position, &position, &midpoint);
+
+    // materials are uniform, so their samples are the same at every corner
+    vec4 colour = vec4_zero;
+    material_colour(&self->materials[material_id], NULL, &colour.xyz);
+    uint32_t packed_colour = pack_vector(&colour);
+
+    vec4 physical;
+    material_physical(&self->materials[material_id], NULL, &physical);
+    uint32_t packed_physical = pack_vector(&physical);
+
+    for (int o = 0; o < 8; o++) {
+        vec3 d;
+        vec3_multiply_f(&d, (vec3 *) &vertices[o], request->radius);
+        vec3_add(&d, &d, &position);
+
+        corner_key_t key;
+        corner_sample_t sample;
+        generator_corner_key(request, o, &key);
+        corner_cache_sample(&self->corner_cache, &self->sdfs[sdf_id], &key, &d, true, &sample);
+
+        vec4 normal = vec4_zero;
+        normal.xyz = sample.normal;
+        vec4_divide_f(&normal, &normal, 2);
+        vec4_add_f(&normal, &normal, 0.5);
+        normals[o] = pack_vector(&normal);
+
+        colours[o] = packed_colour;
+        physicals[o] = packed_physical;
+    }
+
+    response->hash = request->hash;
+
+    if (is_stored) {
+        store_save(&self->texture_store, key, response);
+    }
+
+    return true;
+}
+
+static int raycast_request_comparator(const void *a, const void *b) {
+    uint32_t sdf_a = (*(request_t **)a)->sdf_id;
+    uint32_t sdf_b = (*(request_t **)b)->sdf_id;
+    return (sdf_a > sdf_b) - (sdf_a < sdf_b);
+}
+
+// marches raycast requests in packets of rays against the same sdf. requests
+// for sdfs that don't exist are skipped, and the rest are written to handled
+// alongside their intersections. returns the number handled.
+size_t generator_raycasts(generator_t *self, request_t **requests, size_t count, request_t **handled,
+                          intersection_t *intersections) {
+    qsort(requests, count, sizeof(request_t *), raycast_request_comparator);
+
+    size_t number_handled = 0;
+    size_t i = 0;
+    while (i < count) {
+        uint32_t sdf_id = requests[i]->sdf_id;
+        if (sdf_id >= *self->num_sdfs) {
+            i++;
+            continue;
+        }
+
+        ray_t rays[SERAPHIM_SDF_PACKET_SIZE];
+        int packet_size = 0;
+        for (; i < count && packet_size < SERAPHIM_SDF_PACKET_SIZE && requests[i]->sdf_id == sdf_id; i++) {
+            request_t * request = requests[i];
+            handled[number_handled + packet_size] = request;
+            rays[packet_size] = {
+                .position = {{.x = request->position.x, .y = request->position.y, .z = request->position.z }},
+                .direction = {{.x = request->direction.x, .y = request->direction.y, .z = request->direction.z }}
+            };
+            packet_size++;
+        }
+
+        sdf_raycast_packet(&self->sdfs[sdf_id], rays, packet_size, &intersections[number_handled]);
+        number_handled += packet_size;
+    }
+
+    return number_handled;
+}
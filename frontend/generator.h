@@ -0,0 +1,63 @@
+#ifndef SERAPHIM_GENERATOR_H
+#define SERAPHIM_GENERATOR_H
+
+#include "../backend/sdf.h"
+#include "../common/material.h"
+#include "../common/request_data.h"
+#include "corner.h"
+#include "store.h"
+
+// entries kept in the stores of generated patches and textures
+#define SERAPHIM_GENERATOR_STORED_PATCHES 1048576
+#define SERAPHIM_GENERATOR_STORED_TEXTURES 262144
+
+typedef enum texture_type_t {
+    TEXTURE_TYPE_NORMAL = 0,
+    TEXTURE_TYPE_COLOUR,
+    TEXTURE_TYPE_PHYSICAL,
+    TEXTURE_TYPE_MAXIMUM
+} texture_type_t;
+
+typedef struct patch_t {
+    uint32_t contents;
+    uint32_t hash;
+    float phi;
+    uint32_t normal;
+} patch_t;
+
+typedef struct texture_response_t {
+    uint32_t hash;
+    uint32_t samples[TEXTURE_TYPE_MAXIMUM][8];
+} texture_response_t;
+
+// evaluates the sdfs and materials for requests made by the shader. this is
+// the part of request handling that doesn't touch the device, so it can be
+// shared by the request handler and tools that replay captured requests.
+typedef struct generator_t {
+    sdf_t * sdfs;
+    uint32_t * num_sdfs;
+
+    material_t * materials;
+    uint32_t * num_materials;
+
+    corner_cache_t corner_cache;
+
+    // patches and textures generated by earlier runs, looked up before
+    // evaluating anything, if the stores are open
+    bool has_stores;
+    store_t patch_store;
+    store_t texture_store;
+} generator_t;
+
+void generator_create(generator_t *self, sdf_t *sdfs, uint32_t *num_sdfs, material_t *materials,
+                      uint32_t *num_materials);
+void generator_destroy(generator_t *self);
+bool generator_open_stores(generator_t *self, const char *patch_filename, const char *texture_filename);
+void generator_store_statistics(generator_t *self, store_statistics_t *patches, store_statistics_t *textures);
+
+bool generator_geometry(generator_t *self, const request_t *request, patch_t *patch);
+bool generator_texture(generator_t *self, const request_t *request, texture_response_t *response);
+size_t generator_raycasts(generator_t *self, request_t **requests, size_t count, request_t **handled,
+                          intersection_t *intersections);
+
+#endif
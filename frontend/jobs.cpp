@@ -0,0 +1,116 @@
+#include "jobs.h"
+
+static void job_pool_run_jobs(job_pool_t *self) {
+    while (true) {
+        uint32_t index = self->next_job++;
+        if (index >= self->number_of_jobs) {
+            break;
+        }
+
+        self->function(self->context, index);
+    }
+}
+
+static int job_pool_thread(void *self_) {
+    job_pool_t * self = (job_pool_t *) self_;
+    uint64_t generation = 0;
+
+    while (true) {
+        mtx_lock(&self->mutex);
+        {
+            while (!self->is_closed && self->generation == generation) {
+                cnd_wait(&self->start, &self->mutex);
+            }
+
+            if (self->is_closed) {
+                mtx_unlock(&self->mutex);
+                return 0;
+            }
+
+            generation = self->generation;
+        }
+        mtx_unlock(&self->mutex);
+
+        job_pool_run_jobs(self);
+
+        mtx_lock(&self->mutex);
+        {
+            self->busy--;
+            if (self->busy == 0) {
+                cnd_signal(&self->finished);
+            }
+        }
+        mtx_unlock(&self->mutex);
+    }
+}
+
+void job_pool_create(job_pool_t *self, uint32_t number_of_threads) {
+    mtx_init(&self->mutex, mtx_plain);
+    cnd_init(&self->start);
+    cnd_init(&self->finished);
+    self->is_closed = false;
+    self->generation = 0;
+    self->busy = 0;
+
+    self->function = NULL;
+    self->context = NULL;
+    self->number_of_jobs = 0;
+    self->next_job = 0;
+
+    if (number_of_threads > SERAPHIM_JOBS_MAX_THREADS) {
+        number_of_threads = SERAPHIM_JOBS_MAX_THREADS;
+    }
+
+    self->number_of_threads = number_of_threads;
+    for (uint32_t i = 0; i < number_of_threads; i++) {
+        thrd_create(&self->threads[i], job_pool_thread, self);
+    }
+}
+
+void job_pool_destroy(job_pool_t *self) {
+    mtx_lock(&self->mutex);
+    {
+        self->is_closed = true;
+        cnd_broadcast(&self->start);
+    }
+    mtx_unlock(&self->mutex);
+
+    for (uint32_t i = 0; i < self->number_of_threads; i++) {
+        thrd_join(self->threads[i], NULL);
+    }
+
+    mtx_destroy(&self->mutex);
+    cnd_destroy(&self->start);
+    cnd_destroy(&self->finished);
+}
+
+// calls function with each index below number_of_jobs, sharing the calls
+// between the pool's threads and this one, and returns once they have all
+// returned
+void job_pool_run(job_pool_t *self, job_function_t function, void *context, uint32_t number_of_jobs) {
+    if (number_of_jobs == 0) {
+        return;
+    }
+
+    mtx_lock(&self->mutex);
+    {
+        self->function = function;
+        self->context = context;
+        self->number_of_jobs = number_of_jobs;
+        self->next_job = 0;
+        self->busy = self->number_of_threads;
+        self->generation++;
+        cnd_broadcast(&self->start);
+    }
+    mtx_unlock(&self->mutex);
+
+    job_pool_run_jobs(self);
+
+    mtx_lock(&self->mutex);
+    {
+        while (self->busy > 0) {
+            cnd_wait(&self->finished, &self->mutex);
+        }
+    }
+    mtx_unlock(&self->mutex);
+}
@@ -0,0 +1,38 @@
+#ifndef SERAPHIM_JOBS_H
+#define SERAPHIM_JOBS_H
+
+#include <stdint.h>
+#include <threads.h>
+
+#include <atomic>
+
+// threads a pool may have, besides the thread that runs its jobs
+#define SERAPHIM_JOBS_MAX_THREADS 32
+
+typedef void (*job_function_t)(void *context, uint32_t index);
+
+// threads that share a number of jobs between themselves and the thread that
+// runs them, which waits until they are all done. jobs are taken in order of
+// their index, one at a time, so that uneven jobs balance out.
+typedef struct job_pool_t {
+    uint32_t number_of_threads;
+    thrd_t threads[SERAPHIM_JOBS_MAX_THREADS];
+
+    mtx_t mutex;
+    cnd_t start;
+    cnd_t finished;
+    bool is_closed;
+    uint64_t generation;
+    uint32_t busy;
+
+    job_function_t function;
+    void * context;
+    uint32_t number_of_jobs;
+    std::atomic<uint32_t> next_job;
+} job_pool_t;
+
+void job_pool_create(job_pool_t *self, uint32_t number_of_threads);
+void job_pool_destroy(job_pool_t *self);
+void job_pool_run(job_pool_t *self, job_function_t function, void *context, uint32_t number_of_jobs);
+
+#endif
@@ -0,0 +1,233 @@
+#include "prefetch.h"
+
+#include "../common/constant.h"
+#include "tracker.h"
+
+#include <math.h>
+
+// the primes that comp.glsl hashes cells with
+static const uint32_t p1[4] = { 904601, 12582917, 6291469, 3145739 };
+static const uint32_t p2[4] = { 25165843, 100663319, 1025929, 904573 };
+
+typedef struct prefetch_hit_t {
+    bool is_hit;
+    double distance;
+    uint32_t substance;
+    vec3 x;
+    vec2 uv;
+} prefetch_hit_t;
+
+// matches get_hash in comp.glsl, including its single precision arithmetic
+uint32_t request_prefetcher_hash(const vec3 *x, int order, uint32_t id) {
+    float size = (float) epsilon * order * 2;
+    int32_t grid[4] = {
+        (int32_t) floorf((float) x->x / size),
+        (int32_t) floorf((float) x->y / size),
+        (int32_t) floorf((float) x->z / size),
+        order
+    };
+
+    uint32_t hash[4];
+    for (int i = 0; i < 4; i++) {
+        hash[i] = (uint32_t) grid[i] * p1[i] + p2[i];
+    }
+
+    return hash[3] ^ hash[0] ^ hash[1] ^ hash[2] ^ id;
+}
+
+// matches expected_order in comp.glsl, which measures the distance from the
+// eye to the position in the substance's local space
+static int prefetch_expected_order(const vec3 *eye, const vec3 *x, const vec2 *uv) {
+    vec3 d;
+    vec3_subtract(&d, (vec3 *) eye, (vec3 *) x);
+    double centre = sqrt(uv->x * uv->x + uv->y * uv->y);
+    return 10 + (int) (vec3_length(&d) + 2.0 * centre);
+}
+
+// matches build_request in comp.glsl
+static void prefetch_build_request(request_t *request, const vec3 *x, int order, uint32_t hash, uint32_t sdf_id,
+                                   uint32_t material_id, uint32_t status) {
+    float size = (float) epsilon * order * 2;
+    float radius = size / 2;
+
+    *request = {
+        .position = {{
+            floorf((float) x->x / size) * size,
+            floorf((float) x->y / size) * size,
+            floorf((float) x->z / size) * size,
+        }},
+        .radius = radius,
+        .hash = hash,
+        .sdf_id = sdf_id,
+        .material_id = material_id,
+        .status = status,
+        .direction = {{ 0.0f, 0.0f, 0.0f }},
+        ._1 = 0,
+    };
+}
+
+// casts a grid of rays across the view from the camera and finds the nearest
+// surface of the substances along each
+static void prefetch_cast(const prefetch_view_t *view, const transform_t *camera, prefetch_hit_t *hits) {
+    const int number_of_rays = SERAPHIM_PREFETCH_RAYS * SERAPHIM_PREFETCH_RAYS;
+    vec3 directions[number_of_rays];
+
+    for (int i = 0; i < number_of_rays; i++) {
+        vec2 uv = {{
+            ((i % SERAPHIM_PREFETCH_RAYS) + 0.5) / SERAPHIM_PREFETCH_RAYS * 2.0 - 1.0,
+            ((i / SERAPHIM_PREFETCH_RAYS) + 0.5) / SERAPHIM_PREFETCH_RAYS * 2.0 - 1.0
+        }};
+        uv.y *= -view->aspect_ratio;
+
+        vec3 d = {{ uv.x, uv.y, view->focal_depth }};
+        transform_to_global_direction(camera, &directions[i], &d);
+        vec3_normalize(&directions[i], &directions[i]);
+
+        hits[i].is_hit = false;
+        hits[i].distance = rho;
+        hits[i].uv = uv;
+    }
+
+    for (uint32_t s = 0; s < view->number_of_substances; s++) {
+        const prefetch_substance_t * substance = &view->substances[s];
+        transform_t transform = substance->transform;
+
+        // requests are positioned relative to the middle of the sdf's bound
+        vec3 midpoint;
+        bound3_midpoint(sdf_bound(substance->sdf), &midpoint);
+
+        vec3 origin;
+        transform_to_local_position(&transform, &origin, &camera->position);
+
+        for (int first = 0; first < number_of_rays; first += SERAPHIM_SDF_PACKET_SIZE) {
+            ray_t rays[SERAPHIM_SDF_PACKET_SIZE];
+            for (int i = 0; i < SERAPHIM_SDF_PACKET_SIZE; i++) {
+                vec3 end;
+                vec3_add(&end, (vec3 *) &camera->position, &directions[first + i]);
+                transform_to_local_position(&transform, &end, &end);
+
+                vec3_subtract(&rays[i].direction, &end, &origin);
+                vec3_subtract(&rays[i].position, &origin, &midpoint);
+            }
+
+            intersection_t intersections[SERAPHIM_SDF_PACKET_SIZE];
+            sdf_raycast_packet(substance->sdf, rays, SERAPHIM_SDF_PACKET_SIZE, intersections);
+
+            for (int i = 0; i < SERAPHIM_SDF_PACKET_SIZE; i++) {
+                if (intersections[i].distance >= epsilon) {
+                    continue;
+                }
+
+                vec3 x = {{ intersections[i].position.x, intersections[i].position.y, intersections[i].position.z }};
+                vec3_add(&x, &x, &midpoint);
+
+                vec3 d;
+                vec3_subtract(&d, &x, &origin);
+                double distance = vec3_length(&d);
+
+                prefetch_hit_t * hit = &hits[first + i];
+                if (distance < hit->distance) {
+                    hit->is_hit = true;
+                    hit->distance = distance;
+                    hit->substance = s;
+                    hit->x = x;
+                }
+            }
+        }
+    }
+}
+
+// finds the geometry and texture requests the shader would make for the cells
+// visible from the camera
+static size_t prefetch_find_cells(const prefetch_view_t *view, const transform_t *camera, request_t *requests,
+                                  size_t maximum) {
+    prefetch_hit_t hits[SERAPHIM_PREFETCH_RAYS * SERAPHIM_PREFETCH_RAYS];
+    prefetch_cast(view, camera, hits);
+
+    size_t count = 0;
+    for (int i = 0; i < SERAPHIM_PREFETCH_RAYS * SERAPHIM_PREFETCH_RAYS && count + 2 <= maximum; i++) {
+        prefetch_hit_t * hit = &hits[i];
+        if (!hit->is_hit) {
+            continue;
+        }
+
+        const prefetch_substance_t * substance = &view->substances[hit->substance];
+        int order = prefetch_expected_order(&camera->position, &hit->x, &hit->uv);
+
+        uint32_t hash = request_prefetcher_hash(&hit->x, order, substance->sdf_id);
+        prefetch_build_request(&requests[count++], &hit->x, order, hash, substance->sdf_id, substance->material_id,
+                               geometry_request);
+
+        uint32_t texture_hash = request_prefetcher_hash(&hit->x, order * 2, substance->material_id);
+        prefetch_build_request(&requests[count++], &hit->x, order * 2, texture_hash, substance->sdf_id,
+                               substance->material_id, texture_request);
+    }
+
+    return count;
+}
+
+void request_prefetcher_create(request_prefetcher_t *self) {
+    self->frame = 0;
+    self->predicted.clear();
+    for (int i = 0; i <= SERAPHIM_PREFETCH_FRAMES; i++) {
+        self->predicted_frames[i].clear();
+    }
+
+    self->issued = 0;
+    self->sampled = 0;
+    self->hits = 0;
+}
+
+// finds the requests for the cells that will be visible from where the camera
+// is expected to be, and measures how well earlier predictions covered the
+// cells visible now. nothing is predicted while the camera is still.
+size_t request_prefetcher_predict(request_prefetcher_t *self, const prefetch_view_t *view, request_t *requests,
+                                  size_t maximum) {
+    self->frame++;
+
+    std::vector<uint64_t> * expired = &self->predicted_frames[self->frame % (SERAPHIM_PREFETCH_FRAMES + 1)];
+    for (uint64_t key : *expired) {
+        auto prediction = self->predicted.find(key);
+        if (prediction != self->predicted.end() &&
+            prediction->second + SERAPHIM_PREFETCH_FRAMES + 1 <= self->frame) {
+            self->predicted.erase(prediction);
+        }
+    }
+    expired->clear();
+
+    vec3 movement;
+    vec3_multiply_f(&movement, (vec3 *) &view->velocity, view->lookahead);
+    if (vec3_length(&movement) < SERAPHIM_PREFETCH_MIN_DISTANCE) {
+        return 0;
+    }
+
+    size_t count = prefetch_find_cells(view, &view->camera, requests, maximum);
+    uint64_t hits = 0;
+    for (size_t i = 0; i < count; i++) {
+        hits += self->predicted.count(request_tracker_key(requests[i].status, requests[i].hash));
+    }
+    self->sampled += count;
+    self->hits += hits;
+
+    transform_t camera = view->camera;
+    vec3_add(&camera.position, &camera.position, &movement);
+
+    count = prefetch_find_cells(view, &camera, requests, maximum);
+    for (size_t i = 0; i < count; i++) {
+        uint64_t key = request_tracker_key(requests[i].status, requests[i].hash);
+        self->predicted[key] = self->frame;
+        expired->push_back(key);
+    }
+
+    return count;
+}
+
+void request_prefetcher_issue(request_prefetcher_t *self, size_t count) {
+    self->issued += count;
+}
+
+void request_prefetcher_statistics(request_prefetcher_t *self, prefetch_statistics_t *statistics) {
+    statistics->issued = self->issued.exchange(0);
+    statistics->sampled = self->sampled.exchange(0);
+    statistics->hits = self->hits.exchange(0);
+}
@@ -0,0 +1,77 @@
+#ifndef SERAPHIM_PREFETCH_H
+#define SERAPHIM_PREFETCH_H
+
+#include "../backend/sdf.h"
+#include "../common/request_data.h"
+#include "../common/transform.h"
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+// frames ahead that the camera is predicted, which is also how long a
+// prediction is remembered when measuring the hit rate
+#define SERAPHIM_PREFETCH_FRAMES 4
+
+// rays cast along each side of the view when finding visible cells
+#define SERAPHIM_PREFETCH_RAYS 16
+
+// substances nearest to the camera that cells are prefetched for
+#define SERAPHIM_PREFETCH_MAX_SUBSTANCES 4
+
+// requests that may be prefetched each frame
+#define SERAPHIM_PREFETCH_MAX_REQUESTS (2 * SERAPHIM_PREFETCH_RAYS * SERAPHIM_PREFETCH_RAYS)
+
+// the camera must be predicted to move at least this far to prefetch
+#define SERAPHIM_PREFETCH_MIN_DISTANCE 0.01
+
+typedef struct prefetch_substance_t {
+    sdf_t * sdf;
+    uint32_t sdf_id;
+    uint32_t material_id;
+    transform_t transform;
+} prefetch_substance_t;
+
+// a copy of what the renderer draws this frame, taken on the render thread
+typedef struct prefetch_view_t {
+    transform_t camera;
+    vec3 velocity;
+    double lookahead;
+    float focal_depth;
+    float aspect_ratio;
+
+    uint32_t number_of_substances;
+    prefetch_substance_t substances[SERAPHIM_PREFETCH_MAX_SUBSTANCES];
+} prefetch_view_t;
+
+typedef struct prefetch_statistics_t {
+    uint64_t issued;
+    uint64_t sampled;
+    uint64_t hits;
+} prefetch_statistics_t;
+
+// predicts where the camera will be a few frames ahead and finds the cells
+// that the shader will request there, so that they can be generated before
+// they are missed. each frame that the camera moves, the cells visible from
+// where it actually is are compared against earlier predictions to measure the
+// share of visible cells that were predicted.
+typedef struct request_prefetcher_t {
+    uint64_t frame;
+
+    std::unordered_map<uint64_t, uint64_t> predicted;
+    std::vector<uint64_t> predicted_frames[SERAPHIM_PREFETCH_FRAMES + 1];
+
+    std::atomic<uint64_t> issued;
+    std::atomic<uint64_t> sampled;
+    std::atomic<uint64_t> hits;
+} request_prefetcher_t;
+
+uint32_t request_prefetcher_hash(const vec3 *x, int order, uint32_t id);
+
+void request_prefetcher_create(request_prefetcher_t *self);
+size_t request_prefetcher_predict(request_prefetcher_t *self, const prefetch_view_t *view, request_t *requests,
+                                  size_t maximum);
+void request_prefetcher_issue(request_prefetcher_t *self, size_t count);
+void request_prefetcher_statistics(request_prefetcher_t *self, prefetch_statistics_t *statistics);
+
+#endif
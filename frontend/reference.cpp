@@ -0,0 +1,747 @@
+#include "reference.h"
+
+#include "prefetch.h"
+#include "tracker.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unordered_set>
+
+// these match the constants of comp.glsl
+static const int max_steps = 128;
+static const int max_hash_retries = 5;
+static const float geometry_epsilon = 1.0f / 300.0f;
+static const float pi_f = 3.14159265358979323f;
+static const vec3f sky = {{ 0.5f, 0.7f, 0.9f }};
+static const vec3f ambient = {{ 0.25f, 0.25f, 0.25f }};
+
+static const uint32_t tile_pixels = SERAPHIM_REFERENCE_TILE_SIZE * SERAPHIM_REFERENCE_TILE_SIZE;
+
+typedef struct reference_tile_t {
+    vec2u id;
+    uint32_t * pointers;
+    patch_t workspace[tile_pixels];
+
+    // the indices of the substances binned to the tile
+    const uint32_t * substances;
+    uint32_t number_of_substances;
+    const light_t * lights[SERAPHIM_REFERENCE_MAX_LIGHTS];
+    uint32_t number_of_lights;
+
+    std::vector<request_t> * requests;
+
+    uint64_t patch_shared_hits;
+    uint64_t patch_pool_hits;
+    uint64_t patch_misses;
+    uint64_t texture_hits;
+    uint64_t texture_misses;
+} reference_tile_t;
+
+// the state of each ray of a packet, as the locals of raycast in comp.glsl
+typedef struct reference_packet_t {
+    float x[3][SERAPHIM_REFERENCE_PACKET_SIZE];
+    float d[3][SERAPHIM_REFERENCE_PACKET_SIZE];
+    float centre[SERAPHIM_REFERENCE_PACKET_SIZE];
+    float distance[SERAPHIM_REFERENCE_PACKET_SIZE];
+    bool is_hit[SERAPHIM_REFERENCE_PACKET_SIZE];
+    uint32_t min_substance[SERAPHIM_REFERENCE_PACKET_SIZE];
+    uint32_t substance[SERAPHIM_REFERENCE_PACKET_SIZE];
+    bool has_request[SERAPHIM_REFERENCE_PACKET_SIZE];
+    request_t request[SERAPHIM_REFERENCE_PACKET_SIZE];
+} reference_packet_t;
+
+static vec3f reference_add(vec3f a, vec3f b) {
+    return {{ a.x + b.x, a.y + b.y, a.z + b.z }};
+}
+
+static vec3f reference_subtract(vec3f a, vec3f b) {
+    return {{ a.x - b.x, a.y - b.y, a.z - b.z }};
+}
+
+static vec3f reference_multiply(vec3f a, vec3f b) {
+    return {{ a.x * b.x, a.y * b.y, a.z * b.z }};
+}
+
+static vec3f reference_scale(vec3f a, float f) {
+    return {{ a.x * f, a.y * f, a.z * f }};
+}
+
+static float reference_dot(vec3f a, vec3f b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static float reference_length(vec3f a) {
+    return sqrtf(reference_dot(a, a));
+}
+
+static vec3f reference_normalize(vec3f a) {
+    return reference_scale(a, 1.0f / reference_length(a));
+}
+
+static float reference_sign(float x) {
+    return (float) ((x > 0.0f) - (x < 0.0f));
+}
+
+// multiplies a point by a column major matrix
+static vec3f reference_transform_position(const float *m, vec3f x) {
+    return {{
+        m[0] * x.x + m[4] * x.y + m[8]  * x.z + m[12],
+        m[1] * x.x + m[5] * x.y + m[9]  * x.z + m[13],
+        m[2] * x.x + m[6] * x.y + m[10] * x.z + m[14],
+    }};
+}
+
+// multiplies a direction by the upper left of a column major matrix
+static vec3f reference_transform_direction(const float *m, vec3f d) {
+    return {{
+        m[0] * d.x + m[4] * d.y + m[8]  * d.z,
+        m[1] * d.x + m[5] * d.y + m[9]  * d.z,
+        m[2] * d.x + m[6] * d.y + m[10] * d.z,
+    }};
+}
+
+static vec3f reference_eye_position(const reference_view_t *view) {
+    return {{ view->eye_transform[12], view->eye_transform[13], view->eye_transform[14] }};
+}
+
+// matches uv in comp.glsl, for a pixel of the whole dispatch
+static vec2 reference_uv(reference_renderer_t *self, uint32_t x, uint32_t y) {
+    vec2 uv = {{
+        (float) x / self->image_size.x * 2.0f - 1.0f,
+        (float) y / self->image_size.y * 2.0f - 1.0f,
+    }};
+    uv.y *= -(float) self->work_group_count.y / self->work_group_count.x;
+    return uv;
+}
+
+static vec3f reference_ray_direction(reference_renderer_t *self, uint32_t x, uint32_t y) {
+    vec2 uv = reference_uv(self, x, y);
+    vec3f d = {{ (float) uv.x, (float) uv.y, self->view->focal_depth }};
+    return reference_normalize(reference_transform_direction(self->view->eye_transform, d));
+}
+
+static float expected_size(int order) {
+    return geometry_epsilon * order * 2;
+}
+
+// matches expected_order in comp.glsl, given the distance of the ray's pixel
+// from the centre of the view
+static int reference_expected_order(reference_renderer_t *self, vec3f x, float centre) {
+    float distance = reference_length(reference_subtract(reference_eye_position(self->view), x));
+    return 10 + (int) (distance + centre * 2.0f);
+}
+
+static void reference_calculate_cell(vec3f x, int order, float *cell_radius, vec3f *patch_centre) {
+    float size = expected_size(order);
+    *cell_radius = size / 2;
+    *patch_centre = {{
+        floorf(x.x / size) * size + *cell_radius,
+        floorf(x.y / size) * size + *cell_radius,
+        floorf(x.z / size) * size + *cell_radius,
+    }};
+}
+
+static uint32_t reference_hash(vec3f x, int order, uint32_t id) {
+    vec3 position = {{ x.x, x.y, x.z }};
+    return request_prefetcher_hash(&position, order, id);
+}
+
+// matches build_request in comp.glsl
+static void reference_build_request(request_t *request, const substance_data_t *substance, vec3f x, int order,
+                                    uint32_t hash, uint32_t status) {
+    float cell_radius;
+    vec3f patch_centre;
+    reference_calculate_cell(x, order, &cell_radius, &patch_centre);
+
+    *request = {
+        .position = {{
+            patch_centre.x - cell_radius,
+            patch_centre.y - cell_radius,
+            patch_centre.z - cell_radius,
+        }},
+        .radius = cell_radius,
+        .hash = hash,
+        .sdf_id = substance->sdf_id,
+        .material_id = substance->material_id,
+        .status = status,
+        .direction = {{ 0.0f, 0.0f, 0.0f }},
+        ._1 = 0,
+    };
+}
+
+// matches get_patch in comp.glsl. the tile's shared copy of the pool is
+// checked first, then each way of the patch's set, and the slot looked up is
+// remembered so that the tile shares it next frame.
+static patch_t reference_get_patch(reference_renderer_t *self, reference_tile_t *tile, vec3f x, int order,
+                                   const substance_data_t *substance, request_t *request, bool *has_request,
+                                   bool *is_patch_found) {
+    *is_patch_found = true;
+    uint32_t hash = reference_hash(x, order, substance->sdf_id);
+
+    uint32_t index = hash % tile_pixels;
+    uint32_t geometry_index = (hash % self->patch_cache.number_of_sets) * SERAPHIM_CACHE_WAYS;
+
+    patch_t patch = tile->workspace[index];
+    if (patch.hash == hash) {
+        tile->patch_shared_hits++;
+        return patch;
+    }
+
+    uint32_t way = 0;
+    for (; way < SERAPHIM_CACHE_WAYS; way++) {
+        patch = self->patches[geometry_index + way];
+        if (patch.hash == hash) {
+            break;
+        }
+    }
+
+    tile->pointers[index] = geometry_index + (way < SERAPHIM_CACHE_WAYS ? way : SERAPHIM_CACHE_WAYS - 1);
+    if (patch.hash != hash) {
+        reference_build_request(request, substance, x, order, hash, geometry_request);
+        *has_request = true;
+        *is_patch_found = false;
+        tile->patch_misses++;
+    } else {
+        tile->patch_pool_hits++;
+    }
+
+    return patch;
+}
+
+// matches the part of phi in comp.glsl for rays inside the bound of a
+// substance, which steps by the patch of the cell they are in
+static float reference_phi_patch(reference_renderer_t *self, reference_tile_t *tile, vec3f x, vec3f d,
+                                 float centre, const substance_data_t *substance, request_t *request,
+                                 bool *has_request) {
+    int order = reference_expected_order(self, x, centre);
+
+    patch_t patch = {};
+    bool is_patch_found = false;
+    int tries = 0;
+    for (; tries < max_hash_retries && !is_patch_found; tries++) {
+        patch = reference_get_patch(self, tile, x, order + tries, substance, request, has_request, &is_patch_found);
+    }
+
+    float cell_radius;
+    vec3f patch_centre;
+    reference_calculate_cell(x, order + tries - 1, &cell_radius, &patch_centre);
+
+    vec3f n = {{
+        (float) (patch.normal & 0xFF) / 127.5f - 1.0f,
+        (float) ((patch.normal >> 8) & 0xFF) / 127.5f - 1.0f,
+        (float) ((patch.normal >> 16) & 0xFF) / 127.5f - 1.0f,
+    }};
+    float e = reference_dot(reference_subtract(patch_centre, x), n) - patch.phi;
+    float phi_plane = fminf(0.0f, e) / reference_dot(d, n);
+
+    float phi = phi_plane >= 0.0f ? phi_plane : patch.phi;
+    if (!is_patch_found) {
+        phi = 0.0f;
+    }
+
+    bool is_empty = patch.phi > cell_radius * sqrtf(3.0f);
+    return is_empty ? patch.phi : phi;
+}
+
+// steps the rays of a packet that may reach a substance towards it, as phi in
+// comp.glsl. the rays are moved into the substance's space and stepped to its
+// bound together, and only those inside it look up patches.
+static void reference_march(reference_renderer_t *self, reference_tile_t *tile, reference_packet_t *packet,
+                            uint32_t index, const bool *is_candidate, float *p) {
+    const reference_view_t * view = self->view;
+    const int n = SERAPHIM_REFERENCE_PACKET_SIZE;
+    const substance_data_t * substance = &view->substances[index];
+    const float * inv = substance->inverse_transform;
+    const float * radius = substance->r.v;
+
+    float local_x[3][n];
+    float local_d[3][n];
+    float phi_aabb[n];
+    bool is_inside[n];
+
+    for (int i = 0; i < n; i++) {
+        for (int a = 0; a < 3; a++) {
+            local_x[a][i] = inv[a] * packet->x[0][i] + inv[4 + a] * packet->x[1][i] +
+                            inv[8 + a] * packet->x[2][i] + inv[12 + a];
+            local_d[a][i] = inv[a] * packet->d[0][i] + inv[4 + a] * packet->d[1][i] +
+                            inv[8 + a] * packet->d[2][i];
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        float phi = -INFINITY;
+        bool is_within = true;
+        for (int a = 0; a < 3; a++) {
+            float face = -reference_sign(local_d[a][i]) * radius[a];
+            float phi_face = (face - local_x[a][i]) / local_d[a][i];
+
+            // rays parallel to a pair of faces only reach the bound between them
+            if (local_d[a][i] == 0.0f) {
+                phi_face = fabsf(local_x[a][i]) < radius[a] ? -view->render_distance : view->render_distance;
+            }
+
+            phi = fmaxf(phi, phi_face);
+            is_within &= fabsf(local_x[a][i]) < radius[a];
+        }
+        phi_aabb[i] = (phi > 0.0f ? phi : view->render_distance) + view->epsilon;
+        is_inside[i] = is_within;
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (!is_candidate[i] || packet->is_hit[i]) {
+            continue;
+        }
+
+        float phi = phi_aabb[i];
+        if (is_inside[i]) {
+            vec3f x = {{ local_x[0][i], local_x[1][i], local_x[2][i] }};
+            vec3f d = {{ local_d[0][i], local_d[1][i], local_d[2][i] }};
+            phi = reference_phi_patch(self, tile, x, d, packet->centre[i], substance,
+                                      &packet->request[i], &packet->has_request[i]);
+        }
+
+        p[i] = fminf(p[i], phi);
+        packet->is_hit[i] = p[i] < view->epsilon;
+        packet->substance[i] = index;
+    }
+}
+
+// matches bvh_distance in comp.glsl
+static float reference_bvh_distance(const reference_view_t *view, const reference_packet_t *packet, int i,
+                                    const substance_bvh_node_t *node) {
+    float t_near = 0.0f;
+    float t_far = INFINITY;
+    for (int a = 0; a < 3; a++) {
+        float x = packet->x[a][i];
+        float t_lower = (node->lower.v[a] - x) / packet->d[a][i];
+        float t_upper = (node->upper.v[a] - x) / packet->d[a][i];
+        float near = fminf(t_lower, t_upper);
+        float far = fmaxf(t_lower, t_upper);
+
+        // rays parallel to a pair of faces are only within the bound between them
+        if (packet->d[a][i] == 0.0f) {
+            bool is_between = node->lower.v[a] <= x && x <= node->upper.v[a];
+            near = is_between ? -view->render_distance : view->render_distance;
+            far = is_between ? view->render_distance : -view->render_distance;
+        }
+
+        t_near = fmaxf(t_near, near);
+        t_far = fminf(t_far, far);
+    }
+    return t_near <= t_far ? t_near : view->render_distance;
+}
+
+// marches a packet of rays through the substances of the tile, as raycast in
+// comp.glsl. tiles that see more substances than comp.glsl keeps in shared
+// memory find them from the bvh instead, where the packet visits every node
+// any of its rays would, but only those rays step towards its substance.
+static void reference_raycast(reference_renderer_t *self, reference_tile_t *tile, reference_packet_t *packet) {
+    const reference_view_t * view = self->view;
+    const int n = SERAPHIM_REFERENCE_PACKET_SIZE;
+    const substance_bvh_node_t * nodes = self->bvh.nodes.data();
+    uint32_t number_of_nodes = (uint32_t) self->bvh.nodes.size();
+    bool is_bvh = tile->number_of_substances > self->max_listed_substances;
+
+    bool is_active[n];
+    bool is_candidate[n];
+    float p[n];
+
+    for (int i = 0; i < n; i++) {
+        packet->distance[i] = 0.0f;
+        packet->is_hit[i] = false;
+        packet->min_substance[i] = 0;
+        packet->substance[i] = 0;
+        packet->has_request[i] = false;
+    }
+
+    for (int step = 0; step < max_steps; step++) {
+        bool is_any_active = false;
+        for (int i = 0; i < n; i++) {
+            is_active[i] = !packet->is_hit[i] && packet->distance[i] < view->render_distance;
+            is_any_active |= is_active[i];
+            p[i] = view->render_distance;
+
+            uint32_t m = packet->min_substance[i];
+            if (!is_bvh && is_active[i] && m < tile->number_of_substances &&
+                packet->distance[i] > view->substances[tile->substances[m]].far) {
+                packet->min_substance[i]++;
+            }
+        }
+
+        if (!is_any_active) {
+            break;
+        }
+
+        if (!is_bvh) {
+            for (uint32_t s = 0; s < tile->number_of_substances; s++) {
+                for (int i = 0; i < n; i++) {
+                    is_candidate[i] = is_active[i] && s >= packet->min_substance[i];
+                }
+                reference_march(self, tile, packet, tile->substances[s], is_candidate, p);
+            }
+        } else {
+            for (uint32_t index = 0; index < number_of_nodes;) {
+                const substance_bvh_node_t * node = &nodes[index];
+                bool is_any_near = false;
+                for (int i = 0; i < n; i++) {
+                    is_candidate[i] = is_active[i] && !packet->is_hit[i] &&
+                                      reference_bvh_distance(view, packet, i, node) < p[i];
+                    is_any_near |= is_candidate[i];
+                }
+
+                if (is_any_near && node->substance != (uint32_t) ~0) {
+                    for (int i = 0; i < n; i++) {
+                        is_candidate[i] &= packet->distance[i] <= view->substances[node->substance].far;
+                    }
+                    reference_march(self, tile, packet, node->substance, is_candidate, p);
+                }
+
+                index = is_any_near ? index + 1 : node->escape;
+            }
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (is_active[i]) {
+                for (int a = 0; a < 3; a++) {
+                    packet->x[a][i] += packet->d[a][i] * p[i];
+                }
+                packet->distance[i] += p[i];
+            }
+        }
+    }
+}
+
+static float reference_distribution_ggx(vec3f n, vec3f h, float a) {
+    float a2 = a * a;
+    float n_dot_h = fmaxf(reference_dot(n, h), 0.0f);
+    float denominator = n_dot_h * n_dot_h * (a2 - 1.0f) + 1.0f;
+    return a2 / (pi_f * denominator * denominator);
+}
+
+static float reference_geometry_schlick_ggx(float n_dot_v, float k) {
+    return n_dot_v / (n_dot_v * (1.0f - k) + k);
+}
+
+static float reference_geometry_smith(vec3f n, vec3f v, vec3f l, float k) {
+    float n_dot_v = fmaxf(reference_dot(n, v), 0.0f);
+    float n_dot_l = fmaxf(reference_dot(n, l), 0.0f);
+    return reference_geometry_schlick_ggx(n_dot_v, k) * reference_geometry_schlick_ggx(n_dot_l, k);
+}
+
+// matches cook_torrance_brdf in comp.glsl
+static vec3f reference_cook_torrance(vec3f light_position, vec3f light_colour, vec3f world_position,
+                                     vec3f eye_position, vec3f normal, float roughness, float metallic,
+                                     vec3f albedo) {
+    vec3f f0 = {{ 0.04f, 0.04f, 0.04f }};
+    f0 = reference_add(reference_scale(f0, 1.0f - metallic), reference_scale(albedo, metallic));
+
+    vec3f view = reference_normalize(reference_subtract(eye_position, world_position));
+    vec3f light = reference_normalize(reference_subtract(light_position, world_position));
+    vec3f half_vector = reference_normalize(reference_add(view, light));
+    float distance = reference_length(reference_subtract(light_position, world_position));
+    vec3f radiance = reference_scale(light_colour, 1.0f / (distance * distance));
+
+    float ndf = reference_distribution_ggx(normal, half_vector, roughness);
+    float g = reference_geometry_smith(normal, view, light, roughness);
+
+    float fresnel = powf(1.0f - fmaxf(reference_dot(half_vector, view), 0.0f), 5.0f);
+    vec3f one = {{ 1.0f, 1.0f, 1.0f }};
+    vec3f f = reference_add(f0, reference_scale(reference_subtract(one, f0), fresnel));
+    vec3f kd = reference_scale(reference_subtract(one, f), 1.0f - metallic);
+
+    float n_dot_l = fmaxf(reference_dot(normal, light), 0.0f);
+    float denominator = 4.0f * fmaxf(reference_dot(normal, view), 0.0f) * n_dot_l;
+    vec3f specular = reference_scale(f, ndf * g / fmaxf(denominator, 0.001f));
+
+    vec3f diffuse = reference_scale(reference_multiply(kd, albedo), 1.0f / pi_f);
+    return reference_scale(reference_multiply(reference_add(diffuse, specular), radiance), n_dot_l);
+}
+
+// samples the brick of a texture as the shader's linear sampler does between
+// the centres of its texels
+static vec3f reference_sample(const uint32_t *samples, vec3f alpha) {
+    vec3f result = {{ 0.0f, 0.0f, 0.0f }};
+    for (int o = 0; o < 8; o++) {
+        float w = ((o & 1) ? alpha.x : 1.0f - alpha.x) *
+                  ((o & 2) ? alpha.y : 1.0f - alpha.y) *
+                  ((o & 4) ? alpha.z : 1.0f - alpha.z);
+        const uint8_t * bytes = (const uint8_t *) &samples[o];
+        vec3f texel = {{ bytes[0] / 255.0f, bytes[1] / 255.0f, bytes[2] / 255.0f }};
+        result = reference_add(result, reference_scale(texel, w));
+    }
+    return result;
+}
+
+static uint8_t reference_unorm(float x) {
+    return (uint8_t) (fmaxf(0.0f, fminf(x, 1.0f)) * 255.0f + 0.5f);
+}
+
+// shades a ray of a packet as render in comp.glsl, and makes the texture and
+// geometry requests it would
+static void reference_shade(reference_renderer_t *self, reference_tile_t *tile, reference_packet_t *packet, int i,
+                            uint32_t x, uint32_t y) {
+    const reference_view_t * view = self->view;
+    bool is_hit = packet->is_hit[i];
+    vec3f world_position = {{ packet->x[0][i], packet->x[1][i], packet->x[2][i] }};
+
+    const substance_data_t * substance = tile->number_of_substances > 0 ?
+                                         &view->substances[packet->substance[i]] : NULL;
+
+    vec3f colour = sky;
+    bool is_texture_present = false;
+    request_t texture_request_;
+    vec3f local_x = {};
+    int order = 0;
+    uint32_t texture_hash = 0;
+
+    if (is_hit && substance != NULL) {
+        local_x = reference_transform_position(substance->inverse_transform, world_position);
+        order = reference_expected_order(self, local_x, packet->centre[i]) * 2;
+        float size = expected_size(order);
+        vec3f alpha = {{
+            local_x.x / size - floorf(local_x.x / size),
+            local_x.y / size - floorf(local_x.y / size),
+            local_x.z / size - floorf(local_x.z / size),
+        }};
+
+        texture_hash = reference_hash(local_x, order, substance->material_id);
+        uint32_t texture_set = (texture_hash % self->texture_cache.number_of_sets) * SERAPHIM_CACHE_WAYS;
+        const texture_response_t * texture = NULL;
+        for (uint32_t way = 0; way < SERAPHIM_CACHE_WAYS; way++) {
+            if (self->textures[texture_set + way].hash == texture_hash) {
+                texture = &self->textures[texture_set + way];
+                break;
+            }
+        }
+
+        if (texture != NULL) {
+            is_texture_present = true;
+            tile->texture_hits++;
+
+            vec3f half = {{ 0.5f, 0.5f, 0.5f }};
+            vec3f normal = reference_subtract(reference_sample(texture->samples[TEXTURE_TYPE_NORMAL], alpha), half);
+            normal = reference_transform_direction(substance->transform, reference_normalize(normal));
+            vec3f albedo = reference_sample(texture->samples[TEXTURE_TYPE_COLOUR], alpha);
+            vec3f physical = reference_sample(texture->samples[TEXTURE_TYPE_PHYSICAL], alpha);
+
+            colour = ambient;
+            for (uint32_t l = 0; l < tile->number_of_lights; l++) {
+                const light_t * light = tile->lights[l];
+                vec3f light_colour = {{ light->colour.x, light->colour.y, light->colour.z }};
+                colour = reference_add(colour, reference_cook_torrance(
+                    light->x, light_colour, world_position, reference_eye_position(view), normal, physical.y,
+                    physical.x, albedo));
+            }
+        } else {
+            tile->texture_misses++;
+        }
+    }
+
+    if (!is_hit || is_texture_present) {
+        uint8_t * pixel = &self->image[4 * (y * self->image_size.x + x)];
+        pixel[0] = reference_unorm(colour.x);
+        pixel[1] = reference_unorm(colour.y);
+        pixel[2] = reference_unorm(colour.z);
+        pixel[3] = 255;
+    }
+
+    if (is_hit && substance != NULL && !is_texture_present) {
+        reference_build_request(&texture_request_, substance, local_x, order, texture_hash, texture_request);
+        tile->requests->push_back(texture_request_);
+    }
+
+    if (packet->has_request[i]) {
+        tile->requests->push_back(packet->request[i]);
+    }
+}
+
+// finds the substances and lights the tile considers, as prerender in comp.glsl
+static void reference_prerender(reference_renderer_t *self, reference_tile_t *tile) {
+    uint32_t index = tile->id.x + tile->id.y * self->work_group_count.x;
+    const uint32_t * bins = self->bins.data.data();
+    tile->substances = &bins[bins[index]];
+    tile->number_of_substances = bins[index + 1] - bins[index];
+
+    tile->number_of_lights = 0;
+    for (uint32_t l = 0; l < self->view->number_of_lights && tile->number_of_lights < SERAPHIM_REFERENCE_MAX_LIGHTS;
+         l++) {
+        if (self->view->lights[l].id != (uint32_t) ~0) {
+            tile->lights[tile->number_of_lights++] = &self->view->lights[l];
+        }
+    }
+
+    // the tile's shared copy of the pool holds the patches it looked up last frame
+    for (uint32_t i = 0; i < tile_pixels; i++) {
+        tile->workspace[i] = self->patches[tile->pointers[i]];
+    }
+}
+
+static void reference_render_tile(void *self_, uint32_t index) {
+    reference_renderer_t * self = (reference_renderer_t *) self_;
+    reference_tile_t * tile = (reference_tile_t *) malloc(sizeof(reference_tile_t));
+    tile->id = {{ index % self->work_group_count.x, index / self->work_group_count.x }};
+    tile->pointers = &self->pointers[index * tile_pixels];
+    tile->requests = &self->tile_requests[index];
+    tile->requests->clear();
+    tile->patch_shared_hits = 0;
+    tile->patch_pool_hits = 0;
+    tile->patch_misses = 0;
+    tile->texture_hits = 0;
+    tile->texture_misses = 0;
+
+    reference_prerender(self, tile);
+
+    vec3f eye = reference_eye_position(self->view);
+    for (uint32_t j = 0; j < SERAPHIM_REFERENCE_TILE_SIZE; j++) {
+        uint32_t y = tile->id.y * SERAPHIM_REFERENCE_TILE_SIZE + j;
+
+        for (uint32_t first = 0; first < SERAPHIM_REFERENCE_TILE_SIZE; first += SERAPHIM_REFERENCE_PACKET_SIZE) {
+            reference_packet_t packet;
+            for (int i = 0; i < SERAPHIM_REFERENCE_PACKET_SIZE; i++) {
+                uint32_t x = tile->id.x * SERAPHIM_REFERENCE_TILE_SIZE + first + i;
+                vec3f d = reference_ray_direction(self, x, y);
+                vec2 uv = reference_uv(self, x, y);
+
+                for (int a = 0; a < 3; a++) {
+                    packet.x[a][i] = eye.v[a];
+                    packet.d[a][i] = d.v[a];
+                }
+                packet.centre[i] = (float) sqrt(uv.x * uv.x + uv.y * uv.y);
+            }
+
+            reference_raycast(self, tile, &packet);
+
+            for (int i = 0; i < SERAPHIM_REFERENCE_PACKET_SIZE; i++) {
+                reference_shade(self, tile, &packet, i, tile->id.x * SERAPHIM_REFERENCE_TILE_SIZE + first + i, y);
+            }
+        }
+    }
+
+    self->patch_shared_hits += tile->patch_shared_hits;
+    self->patch_pool_hits += tile->patch_pool_hits;
+    self->patch_misses += tile->patch_misses;
+    self->texture_hits += tile->texture_hits;
+    self->texture_misses += tile->texture_misses;
+
+    free(tile);
+}
+
+static void reference_generate(void *self_, uint32_t index) {
+    reference_renderer_t * self = (reference_renderer_t *) self_;
+    request_t * request = &self->requests[index];
+    if (request->status == geometry_request) {
+        self->is_generated[index] = generator_geometry(self->generator, request, &self->generated_patches[index]);
+    } else {
+        self->is_generated[index] = generator_texture(self->generator, request, &self->generated_textures[index]);
+    }
+}
+
+void reference_renderer_create(reference_renderer_t *self, generator_t *generator, vec2u work_group_count,
+                               uint32_t number_of_threads, uint32_t geometry_pool_size, uint32_t texture_pool_size) {
+    self->work_group_count = work_group_count;
+    self->image_size = {{
+        work_group_count.x * SERAPHIM_REFERENCE_TILE_SIZE,
+        work_group_count.y * SERAPHIM_REFERENCE_TILE_SIZE
+    }};
+    self->image = (uint8_t *) calloc(4 * self->image_size.x * self->image_size.y, sizeof(uint8_t));
+    self->generator = generator;
+
+    cache_create(&self->patch_cache, geometry_pool_size);
+    self->patches = (patch_t *) calloc(geometry_pool_size, sizeof(patch_t));
+    cache_create(&self->texture_cache, texture_pool_size);
+    self->textures = (texture_response_t *) calloc(texture_pool_size, sizeof(texture_response_t));
+
+    uint32_t number_of_tiles = work_group_count.x * work_group_count.y;
+    self->pointers = (uint32_t *) calloc(number_of_tiles * tile_pixels, sizeof(uint32_t));
+    self->tile_requests = new std::vector<request_t>[number_of_tiles];
+
+    self->patch_shared_hits = 0;
+    self->patch_pool_hits = 0;
+    self->patch_misses = 0;
+    self->texture_hits = 0;
+    self->texture_misses = 0;
+
+    self->view = NULL;
+    substance_bins_create(&self->bins, work_group_count);
+    substance_bvh_create(&self->bvh);
+    self->max_listed_substances = SERAPHIM_REFERENCE_TILE_SIZE;
+
+    // the thread rendering runs jobs too
+    job_pool_create(&self->jobs, number_of_threads > 1 ? number_of_threads - 1 : 0);
+}
+
+void reference_renderer_destroy(reference_renderer_t *self) {
+    job_pool_destroy(&self->jobs);
+
+    free(self->image);
+    cache_destroy(&self->patch_cache);
+    free(self->patches);
+    cache_destroy(&self->texture_cache);
+    free(self->textures);
+    free(self->pointers);
+    delete[] self->tile_requests;
+}
+
+// renders a frame into the image, then generates the patches and textures it
+// requested into the pools, so that they are there for the next frame.
+// returns the number of requests handled, which is 0 once the view converges.
+size_t reference_renderer_render(reference_renderer_t *self, const reference_view_t *view) {
+    self->view = view;
+
+    substance_bins_update(&self->bins, &self->jobs, view->substances, view->number_of_substances,
+                          view->eye_transform, view->focal_depth, view->render_distance);
+    substance_bvh_update(&self->bvh, view->substances, view->number_of_substances);
+
+    uint32_t number_of_tiles = self->work_group_count.x * self->work_group_count.y;
+    job_pool_run(&self->jobs, reference_render_tile, self, number_of_tiles);
+
+    // like the shader's claims, each request is only made once a frame, and
+    // those beyond what the request buffer holds are lost
+    std::unordered_set<uint64_t> keys;
+    self->requests.clear();
+    for (uint32_t i = 0; i < number_of_tiles; i++) {
+        for (request_t &request : self->tile_requests[i]) {
+            if (self->requests.size() >= SERAPHIM_REFERENCE_MAX_REQUESTS) {
+                break;
+            }
+
+            if (keys.insert(request_tracker_key(request.status, request.hash)).second) {
+                self->requests.push_back(request);
+            }
+        }
+    }
+
+    size_t count = self->requests.size();
+    self->generated_patches.resize(count);
+    self->generated_textures.resize(count);
+    self->is_generated.assign(count, 0);
+    job_pool_run(&self->jobs, reference_generate, self, (uint32_t) count);
+
+    for (size_t i = 0; i < count; i++) {
+        if (!self->is_generated[i]) {
+            continue;
+        }
+
+        uint32_t slot;
+        if (self->requests[i].status == geometry_request) {
+            cache_insert(&self->patch_cache, self->requests[i].hash, &slot);
+            self->patches[slot] = self->generated_patches[i];
+        } else {
+            cache_insert(&self->texture_cache, self->requests[i].hash, &slot);
+            self->textures[slot] = self->generated_textures[i];
+        }
+    }
+
+    self->view = NULL;
+    return count;
+}
+
+void reference_renderer_statistics(reference_renderer_t *self, reference_statistics_t *statistics) {
+    statistics->patch_shared_hits = self->patch_shared_hits.exchange(0);
+    statistics->patch_pool_hits = self->patch_pool_hits.exchange(0);
+    statistics->patch_misses = self->patch_misses.exchange(0);
+    statistics->texture_hits = self->texture_hits.exchange(0);
+    statistics->texture_misses = self->texture_misses.exchange(0);
+}
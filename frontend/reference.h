@@ -0,0 +1,113 @@
+#ifndef SERAPHIM_REFERENCE_H
+#define SERAPHIM_REFERENCE_H
+
+#include "../common/light.h"
+#include "../common/maths.h"
+#include "../common/substance_data.h"
+#include "binning.h"
+#include "bvh.h"
+#include "cache.h"
+#include "generator.h"
+#include "jobs.h"
+
+#include <atomic>
+#include <vector>
+
+// pixels along each side of a tile, which must match the work group size of
+// comp.glsl, as the patches shared by a work group and the substances it
+// considers are both per tile
+#define SERAPHIM_REFERENCE_TILE_SIZE 32
+
+// rays marched together in lockstep, along a row of a tile
+#define SERAPHIM_REFERENCE_PACKET_SIZE 8
+
+// lights each tile may consider, matching the shared array of comp.glsl
+#define SERAPHIM_REFERENCE_MAX_LIGHTS SERAPHIM_REFERENCE_TILE_SIZE
+
+// requests handled after each frame, matching max_requests in comp.glsl
+#define SERAPHIM_REFERENCE_MAX_REQUESTS 2048
+
+static_assert(SERAPHIM_REFERENCE_TILE_SIZE % SERAPHIM_REFERENCE_PACKET_SIZE == 0,
+              "packets must fit exactly in the rows of a tile");
+static_assert(SERAPHIM_REFERENCE_TILE_SIZE == SERAPHIM_BINNING_TILE_SIZE,
+              "tiles must be binned as the renderer bins work groups");
+
+// what comp.glsl is given to draw a frame. substances are sorted as the
+// renderer sorts them before writing the substance buffer.
+typedef struct reference_view_t {
+    float eye_transform[MAT4_SIZE];
+    float focal_depth;
+    float render_distance;
+    float epsilon;
+
+    const substance_data_t * substances;
+    uint32_t number_of_substances;
+
+    const light_t * lights;
+    uint32_t number_of_lights;
+} reference_view_t;
+
+// lookups made by the rays of the frames rendered since the statistics were
+// last taken. patches are found in the copy shared by the tile first, then in
+// the pool.
+typedef struct reference_statistics_t {
+    uint64_t patch_shared_hits;
+    uint64_t patch_pool_hits;
+    uint64_t patch_misses;
+    uint64_t texture_hits;
+    uint64_t texture_misses;
+} reference_statistics_t;
+
+// renders what comp.glsl renders on the cpu, from the same pools of patches and
+// textures filled by the same requests, so that its images can be compared
+// against the renderer's and the caches can be profiled without a device.
+// substances are binned by tile and put in a bvh as the renderer does them, and
+// tiles are shared between a pool of threads, each marching packets of rays.
+// as with the renderer, the requests made by a frame are handled after it, so
+// a view converges over several frames.
+typedef struct reference_renderer_t {
+    vec2u work_group_count;
+    vec2u image_size;
+    uint8_t * image;
+
+    generator_t * generator;
+
+    // the pools and their directories, which only change between frames
+    cache_t patch_cache;
+    patch_t * patches;
+    cache_t texture_cache;
+    texture_response_t * textures;
+
+    // the pool slot each tile last looked up for each of its shared patches
+    uint32_t * pointers;
+
+    // the requests made by each tile, and what was generated for them
+    std::vector<request_t> * tile_requests;
+    std::vector<request_t> requests;
+    std::vector<patch_t> generated_patches;
+    std::vector<texture_response_t> generated_textures;
+    std::vector<uint8_t> is_generated;
+
+    job_pool_t jobs;
+    substance_bins_t bins;
+    substance_bvh_t bvh;
+
+    // tiles that see more substances than this find them from the bvh, as
+    // comp.glsl does past those it keeps in shared memory
+    uint32_t max_listed_substances;
+    const reference_view_t * view;
+
+    std::atomic<uint64_t> patch_shared_hits;
+    std::atomic<uint64_t> patch_pool_hits;
+    std::atomic<uint64_t> patch_misses;
+    std::atomic<uint64_t> texture_hits;
+    std::atomic<uint64_t> texture_misses;
+} reference_renderer_t;
+
+void reference_renderer_create(reference_renderer_t *self, generator_t *generator, vec2u work_group_count,
+                               uint32_t number_of_threads, uint32_t geometry_pool_size, uint32_t texture_pool_size);
+void reference_renderer_destroy(reference_renderer_t *self);
+size_t reference_renderer_render(reference_renderer_t *self, const reference_view_t *view);
+void reference_renderer_statistics(reference_renderer_t *self, reference_statistics_t *statistics);
+
+#endif
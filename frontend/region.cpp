@@ -0,0 +1,96 @@
+#include "region.h"
+
+#include <algorithm>
+#include <map>
+
+static void region_emit(const buffer_region_t *region, uint64_t start, uint64_t end,
+                        std::vector<buffer_region_t> *pieces) {
+    if (start < end) {
+        pieces->push_back({ region->source + (start - region->destination), start, end - start });
+    }
+}
+
+// adds the range to a set of disjoint ranges, joining those it overlaps or touches
+static void region_cover(std::map<uint64_t, uint64_t> *covered, uint64_t start, uint64_t end) {
+    auto range = covered->lower_bound(start);
+    if (range != covered->begin() && std::prev(range)->second >= start) {
+        range--;
+    }
+
+    while (range != covered->end() && range->first <= end) {
+        start = std::min(start, range->first);
+        end = std::max(end, range->second);
+        range = covered->erase(range);
+    }
+
+    (*covered)[start] = end;
+}
+
+static bool region_is_before(const buffer_region_t &a, const buffer_region_t &b) {
+    return a.destination < b.destination;
+}
+
+// walking back from the last region written, only the parts of each region
+// that no later region covers are kept
+static void region_cut_overlaps(const buffer_region_t *regions, size_t count, std::vector<buffer_region_t> *pieces) {
+    std::map<uint64_t, uint64_t> covered;
+    for (size_t i = count; i-- > 0;) {
+        const buffer_region_t * region = &regions[i];
+        uint64_t start = region->destination;
+        uint64_t end = start + region->size;
+
+        auto range = covered.upper_bound(start);
+        if (range != covered.begin() && std::prev(range)->second > start) {
+            range--;
+        }
+
+        uint64_t cursor = start;
+        for (; range != covered.end() && range->first < end && cursor < end; range++) {
+            region_emit(region, cursor, std::min(range->first, end), pieces);
+            cursor = std::max(cursor, range->second);
+        }
+        region_emit(region, cursor, end, pieces);
+
+        region_cover(&covered, start, end);
+    }
+
+    std::sort(pieces->begin(), pieces->end(), region_is_before);
+}
+
+// turns the regions, in the order they were written, into the fewest regions
+// that copy the same result. where regions overlap at their destination only
+// the last written is copied, and regions that follow on from one another at
+// both their source and destination are joined. the result is sorted by
+// destination, so no two regions overlap there. coalesced keeps its capacity,
+// so a caller that reuses it does not allocate once it has grown.
+void buffer_regions_coalesce(const buffer_region_t *regions, size_t count, std::vector<buffer_region_t> *coalesced) {
+    // writes are usually to distinct slots, so sorting them is enough, and
+    // regions are only cut where some of them overlap
+    coalesced->assign(regions, regions + count);
+    std::sort(coalesced->begin(), coalesced->end(), region_is_before);
+
+    bool is_overlapping = false;
+    for (size_t i = 1; i < coalesced->size() && !is_overlapping; i++) {
+        const buffer_region_t * last = &(*coalesced)[i - 1];
+        is_overlapping = last->destination + last->size > (*coalesced)[i].destination;
+    }
+
+    if (is_overlapping) {
+        coalesced->clear();
+        region_cut_overlaps(regions, count, coalesced);
+    }
+
+    size_t number = 0;
+    for (size_t i = 0; i < coalesced->size(); i++) {
+        buffer_region_t * region = &(*coalesced)[i];
+        buffer_region_t * last = number > 0 ? &(*coalesced)[number - 1] : NULL;
+
+        if (last != NULL && last->destination + last->size == region->destination &&
+            last->source + last->size == region->source) {
+            last->size += region->size;
+        } else {
+            (*coalesced)[number++] = *region;
+        }
+    }
+    coalesced->resize(number);
+}
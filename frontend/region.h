@@ -0,0 +1,18 @@
+#ifndef SERAPHIM_REGION_H
+#define SERAPHIM_REGION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// a copy of size bytes between two buffers, laid out like VkBufferCopy
+typedef struct buffer_region_t {
+    uint64_t source;
+    uint64_t destination;
+    uint64_t size;
+} buffer_region_t;
+
+void buffer_regions_coalesce(const buffer_region_t *regions, size_t count, std::vector<buffer_region_t> *coalesced);
+
+#endif
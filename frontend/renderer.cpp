@@ -318,32 +318,38 @@ void renderer_t::create_command_buffers() {
 }
 
 void renderer_t::create_descriptor_pool() {
+    // a descriptor set for each image of the swapchain, or a single set if
+    // there is no swapchain
+    uint32_t number_of_sets = is_headless ? 1 : swapchain->get_size();
+
+    // each set has the request handler's four buffers and the renderer's six,
+    // the render texture and the request handler's textures
     std::vector<VkDescriptorPoolSize> pool_sizes = {
-        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, swapchain->get_size()},
-        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, swapchain->get_size()},
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, swapchain->get_size()}};
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 10 * number_of_sets},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, number_of_sets},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, TEXTURE_TYPE_MAXIMUM * number_of_sets}};
 
     VkDescriptorPoolCreateInfo pool_info = {};
     pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     pool_info.poolSizeCount = pool_sizes.size();
     pool_info.pPoolSizes = pool_sizes.data();
-    pool_info.maxSets = swapchain->get_size();
+    pool_info.maxSets = number_of_sets;
 
     if (vkCreateDescriptorPool(device->device, &pool_info, NULL, &desc_pool) !=
         VK_SUCCESS) {
         PANIC("Error: Failed to create descriptor pool.");
     }
 
-    std::vector<VkDescriptorSetLayout> layouts(swapchain->get_size(),
+    std::vector<VkDescriptorSetLayout> layouts(number_of_sets,
                                                descriptor_layout);
 
     VkDescriptorSetAllocateInfo alloc_info = {};
     alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
     alloc_info.descriptorPool = desc_pool;
-    alloc_info.descriptorSetCount = swapchain->get_size();
+    alloc_info.descriptorSetCount = number_of_sets;
     alloc_info.pSetLayouts = layouts.data();
 
-    desc_sets.resize(swapchain->get_size());
+    desc_sets.resize(number_of_sets);
     if (vkAllocateDescriptorSets(device->device, &alloc_info, desc_sets.data()) !=
         VK_SUCCESS) {
         PANIC("Error: Failed to allocate descriptor sets.");
@@ -370,6 +376,8 @@ void create_descriptor_set_layout(renderer_t * renderer) {
 
             buffer_descriptor_set_layout_binding(&renderer->pointer_buffer),
             buffer_descriptor_set_layout_binding(&renderer->work_group_persistent_buffer),
+            buffer_descriptor_set_layout_binding(&renderer->bin_buffer),
+            buffer_descriptor_set_layout_binding(&renderer->bvh_buffer),
     };
 
     for (int i = 0; i < TEXTURE_TYPE_MAXIMUM; i++){
@@ -405,6 +413,8 @@ void renderer_t::create_sync() {
                                     &render_finished_semas[i]);
         result |= vkCreateSemaphore(device->device, &create_info, NULL,
                                     &compute_done_semas[i]);
+        result |= vkCreateSemaphore(device->device, &create_info, NULL,
+                                    &graphics_done_semas[i]);
         result |=
             vkCreateFence(device->device, &fence_info, NULL, &in_flight_fences[i]);
     }
@@ -413,6 +423,40 @@ void renderer_t::create_sync() {
         PANIC(
             "Error: Failed to create synchronisation primitives.");
     }
+
+    for (int i = 0; i < frames_in_flight; i++) {
+        is_frame_pending[i] = false;
+    }
+
+    timed_frames = 0;
+    cpu_nanoseconds = 0;
+    wait_nanoseconds = 0;
+    gpu_nanoseconds = 0;
+    gpu_idle_nanoseconds = 0;
+
+    // the compute work is only timed if its queue can write timestamps
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device->physical_device, &queue_family_count, NULL);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(device->physical_device, &queue_family_count, queue_families.data());
+    uint32_t valid_bits = queue_families[device->compute_family].timestampValidBits;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device->physical_device, &properties);
+
+    has_timestamps = false;
+    timestamp_period = properties.limits.timestampPeriod;
+    timestamp_mask = valid_bits >= 64 ? ~((uint64_t) 0) : (((uint64_t) 1) << valid_bits) - 1;
+    last_timestamp = 0;
+
+    if (valid_bits > 0) {
+        VkQueryPoolCreateInfo query_pool_info = {};
+        query_pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        query_pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        query_pool_info.queryCount = 2 * frames_in_flight;
+
+        has_timestamps = vkCreateQueryPool(device->device, &query_pool_info, NULL, &timestamp_pool) == VK_SUCCESS;
+    }
 }
 
 void renderer_present(renderer_t * renderer, uint32_t image_index) {
@@ -429,93 +473,263 @@ void renderer_present(renderer_t * renderer, uint32_t image_index) {
     vkQueuePresentKHR(renderer->present_queue, &present_info);
 }
 
+// reads the timestamps around the compute work of a frame whose fence has been
+// signalled, and the time the device spent idle since the frame before it
+static void renderer_read_timestamps(renderer_t *renderer, uint32_t frame) {
+    if (!renderer->has_timestamps) {
+        return;
+    }
+
+    uint64_t timestamps[2];
+    if (vkGetQueryPoolResults(renderer->device->device, renderer->timestamp_pool, 2 * frame, 2, sizeof(timestamps),
+                              timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+        return;
+    }
+
+    uint64_t mask = renderer->timestamp_mask;
+    double period = renderer->timestamp_period;
+    renderer->gpu_nanoseconds += (uint64_t) (((timestamps[1] - timestamps[0]) & mask) * period);
+    if (renderer->last_timestamp != 0) {
+        uint64_t idle = (timestamps[0] - renderer->last_timestamp) & mask;
+        if (idle < mask / 2) {
+            renderer->gpu_idle_nanoseconds += (uint64_t) (idle * period);
+        }
+    }
+    renderer->last_timestamp = timestamps[1];
+}
+
+// waits for the frame that last used this frame's place, which frees its
+// compute work and staging memory and lets its requests be read. this is the
+// only place that the renderer waits for the device.
+static void renderer_wait_for_frame(renderer_t *renderer, uint32_t frame) {
+    auto start = std::chrono::steady_clock::now();
+    vkWaitForFences(renderer->device->device, 1, &renderer->in_flight_fences[frame], VK_TRUE, ~((uint64_t)0));
+    auto end = std::chrono::steady_clock::now();
+    renderer->wait_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    if (!renderer->is_frame_pending[frame]) {
+        return;
+    }
+    renderer->is_frame_pending[frame] = false;
+
+    command_buffer_destroy(&renderer->compute_command_buffers[frame]);
+
+    // the frame's copies are done, so its staging memory can be written again
+    staging_release_frame(&renderer->staging);
+
+    renderer_read_timestamps(renderer, frame);
+    request_handler_handle_requests(&renderer->request_handler, frame);
+
+    if (renderer->image_prefix != NULL) {
+        char filename[256];
+        snprintf(filename, sizeof(filename), "%s%06lu.ppm", renderer->image_prefix,
+                 (unsigned long) renderer->image_frames[frame]);
+
+        VkExtent3D extents = renderer->render_texture.extents;
+        if (!file_save_ppm(filename, extents.width, extents.height,
+                           (uint8_t *) buffer_memory(&renderer->image_readbacks[frame], 0))) {
+            printf("Unable to save %s\n", filename);
+        }
+    }
+}
+
+// waits for every frame still in flight, oldest first, so that their requests
+// are read and their images saved
+void renderer_finish(renderer_t *renderer) {
+    for (int i = 0; i < frames_in_flight; i++) {
+        renderer_wait_for_frame(renderer, (renderer->current_frame + i) % frames_in_flight);
+    }
+}
+
+// copies the image rendered this frame into the frame's readback
+static void renderer_record_image_readback(renderer_t *renderer, VkCommandBuffer command_buffer, uint32_t frame) {
+    VkExtent3D extents = renderer->render_texture.extents;
+
+    VkBufferImageCopy region = {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {extents.width, extents.height, 1};
+
+    vkCmdCopyImageToBuffer(command_buffer, renderer->render_texture.image, VK_IMAGE_LAYOUT_GENERAL,
+                           renderer->image_readbacks[frame].buffer, 1, &region);
+    renderer->image_frames[frame] = renderer->push_constants.current_frame;
+}
+
 void renderer_t::render() {
+    auto frame_start = std::chrono::steady_clock::now();
     frames++;
 
+    renderer_wait_for_frame(this, current_frame);
+
     uint32_t size = work_group_size.x * work_group_size.y;
 
-    // write substances
-    substance_data_t substance_datas[size];
-    for (size_t i = 0; i < *num_substances; i++) {
-        substance_t *s = &substances[i];
-        substance_data(s, &substance_datas[i], &main_camera->transform.position);
-    }
-    for (size_t i = *num_substances; i < size; i++){
-        substance_datas[i] = null_substance_data;
+    // write the substances that changed since the last frame
+    substance_list_update(&substance_list, substances, *num_substances, &main_camera->transform.position,
+                          &substance_ranges);
+    for (substance_range_t &range : substance_ranges) {
+        if (!buffer_write(&substance_buffer, &substance_list.sorted[range.first], range.number, range.first)) {
+            substance_list_invalidate(&substance_list);
+        }
     }
 
-    std::sort(substance_datas, substance_datas + size, substance_data_t::comparator_t());
-
-    buffer_write(&substance_buffer, substance_datas, size, 0);
+    // refit the hierarchy over them
+    if (substance_bvh_update(&substance_bvh, substance_list.sorted.data(), substance_list.number_sorted) ||
+        !is_bvh_written) {
+        is_bvh_written = buffer_write(&bvh_buffer, substance_bvh.nodes.data(), substance_bvh.nodes.size(), 0);
+    }
+    push_constants.number_of_bvh_nodes = substance_bvh.nodes.size();
 
-    // write lights
-    std::vector<light_t> lights(size);
-    vec3f light_x = {{ 0, 4, -4}};
-    vec4f light_colour = {{250, 250, 250, 250}};
-    lights[0] = light_t(0, &light_x, &light_colour);
-    buffer_write(&light_buffer, lights.data(), lights.size(), 0);
+    // write lights, which don't change, until a write succeeds
+    if (!is_lights_written) {
+        std::vector<light_t> lights(size);
+        light_create_scene(&lights[0]);
+        is_lights_written = buffer_write(&light_buffer, lights.data(), lights.size(), 0);
+    }
 
     camera_transformation_matrix(main_camera,
                                  push_constants.eye_transform);
 
-    uint32_t image_index;
-    vkAcquireNextImageKHR(
-            device->device, swapchain->handle, ~0,
-            image_available_semas[current_frame], VK_NULL_HANDLE, &image_index);
+    // bin the substances by the work groups that may see them
+    substance_bins_update(&substance_bins, &jobs, substance_list.sorted.data(), substance_list.number_sorted,
+                          push_constants.eye_transform, push_constants.focal_depth, push_constants.render_distance);
+    if (substance_bins.data != written_bins) {
+        if (buffer_write(&bin_buffer, substance_bins.data.data(), substance_bins.data.size(), 0)) {
+            written_bins = substance_bins.data;
+        } else {
+            written_bins.clear();
+        }
+    }
 
+    uint32_t image_index = 0;
+    if (!is_headless) {
+        vkAcquireNextImageKHR(
+                device->device, swapchain->handle, ~0,
+                image_available_semas[current_frame], VK_NULL_HANDLE, &image_index);
+    }
 
-    request_handler_handle_requests(&request_handler);
 
+    request_handler_set_view(&request_handler, main_camera, substances, *num_substances, push_constants.focal_depth,
+                             (float) work_group_count.y / work_group_count.x);
 
-    command_buffer_t command_buffer;
-    command_buffer_begin_buffer(&compute_command_pool, &command_buffer, true);
+    // the command buffer is kept until the frame's fence is next waited for,
+    // as it can't be freed while the device may still be executing it
+    command_buffer_t *command_buffer = &compute_command_buffers[current_frame];
+    command_buffer_begin_buffer(&compute_command_pool, command_buffer, false);
     {
-        request_handler_record_buffer_accesses(&request_handler, command_buffer.command_buffer);
+        if (has_timestamps) {
+            vkCmdResetQueryPool(command_buffer->command_buffer, timestamp_pool, 2 * current_frame, 2);
+            vkCmdWriteTimestamp(command_buffer->command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestamp_pool,
+                                2 * current_frame);
+        }
 
-        buffer_record_write(&substance_buffer, command_buffer.command_buffer);
-        buffer_record_write(&light_buffer, command_buffer.command_buffer);
+        // the last frame may still be running, so its shader and copies must
+        // finish with the buffers and textures before this frame writes them
+        command_buffer_record_barrier(command_buffer->command_buffer,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                      VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+                                      VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                      VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
 
-        vkCmdBindPipeline(command_buffer.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+        request_handler_record_buffer_accesses(&request_handler, command_buffer->command_buffer);
+
+        buffer_record_write(&substance_buffer, command_buffer->command_buffer);
+        buffer_record_write(&light_buffer, command_buffer->command_buffer);
+        buffer_record_write(&bin_buffer, command_buffer->command_buffer);
+        buffer_record_write(&bvh_buffer, command_buffer->command_buffer);
+
+        command_buffer_record_barrier(command_buffer->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                      VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+        vkCmdBindPipeline(command_buffer->command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
                           compute_pipeline);
-        vkCmdPushConstants(command_buffer.command_buffer, compute_pipeline_layout,
+        vkCmdPushConstants(command_buffer->command_buffer, compute_pipeline_layout,
                            VK_SHADER_STAGE_COMPUTE_BIT, 0,
                            sizeof(push_constant_t), &push_constants);
-        vkCmdBindDescriptorSets(command_buffer.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+        vkCmdBindDescriptorSets(command_buffer->command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
                                 compute_pipeline_layout, 0, 1,
                                 &desc_sets[image_index], 0, NULL);
-        vkCmdDispatch(command_buffer.command_buffer, work_group_count.x, work_group_count.y,
+        vkCmdDispatch(command_buffer->command_buffer, work_group_count.x, work_group_count.y,
                       1);
-    }
-    command_buffer_end(&command_buffer);
 
+        command_buffer_record_barrier(command_buffer->command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                      VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                      VK_ACCESS_TRANSFER_READ_BIT);
+        request_handler_record_readback(&request_handler, command_buffer->command_buffer, current_frame);
+        if (image_prefix != NULL) {
+            renderer_record_image_readback(this, command_buffer->command_buffer, current_frame);
+        }
+        command_buffer_record_barrier(command_buffer->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                      VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                                      VK_ACCESS_HOST_READ_BIT);
 
-    command_buffer_submit(&command_buffer,  image_available_semas[current_frame],
-                 compute_done_semas[current_frame], in_flight_fences[current_frame],
-                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+        if (has_timestamps) {
+            vkCmdWriteTimestamp(command_buffer->command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestamp_pool,
+                                2 * current_frame + 1);
+        }
+    }
+    command_buffer_end(command_buffer);
+    staging_end_frame(&staging);
 
-    command_buffer_submit(&command_buffers[image_index],
-        compute_done_semas[current_frame], render_finished_semas[current_frame],
-        in_flight_fences[current_frame],
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    vkResetFences(device->device, 1, &in_flight_fences[current_frame]);
 
-    renderer_present(this, image_index);
+    if (is_headless) {
+        command_buffer_submit(command_buffer, VK_NULL_HANDLE, VK_NULL_HANDLE, in_flight_fences[current_frame],
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    } else {
+        // the fence is signalled by the graphics work, which waits for the
+        // compute work, so it covers both. the compute work also waits for the
+        // last frame's graphics work to finish reading the render texture.
+        VkSemaphore wait_semas[2] = {image_available_semas[current_frame]};
+        VkPipelineStageFlags wait_stages[2] = {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
+        uint32_t number_of_waits = 1;
+        if (graphics_pending >= 0) {
+            wait_semas[number_of_waits] = graphics_done_semas[graphics_pending];
+            wait_stages[number_of_waits++] = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        }
+        command_buffer_submit_semaphores(command_buffer, wait_semas, wait_stages, number_of_waits,
+                                         &compute_done_semas[current_frame], 1, VK_NULL_HANDLE);
+
+        VkSemaphore signal_semas[2] = {render_finished_semas[current_frame], graphics_done_semas[current_frame]};
+        VkPipelineStageFlags graphics_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        command_buffer_submit_semaphores(&command_buffers[image_index], &compute_done_semas[current_frame],
+                                         &graphics_stage, 1, signal_semas, 2, in_flight_fences[current_frame]);
+        graphics_pending = current_frame;
+    }
+    is_frame_pending[current_frame] = true;
 
-    vkWaitForFences(device->device, 1, &in_flight_fences[current_frame], VK_TRUE,
-                    ~((uint64_t)0));
-    vkResetFences(device->device, 1, &in_flight_fences[current_frame]);
+    if (!is_headless) {
+        renderer_present(this, image_index);
+    }
 
     push_constants.current_frame++;
     current_frame = (current_frame + 1) % frames_in_flight;
+
+    // the frame is not waited for here, so the next frame is recorded while the
+    // device works on this one
+    auto frame_end = std::chrono::steady_clock::now();
+    timed_frames++;
+    cpu_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(frame_end - frame_start).count();
 }
 
 void renderer_t::create_buffers() {
     uint32_t c = work_group_count.x * work_group_count.y;
     uint32_t s = work_group_size.x * work_group_size.y;
 
-    buffer_create(&light_buffer, 3, device, s, true, sizeof(light_t));
-    buffer_create(&substance_buffer, 4, device, s, true, sizeof(substance_data_t));
-    buffer_create(&pointer_buffer, 5, device, c * s, true, sizeof(uint32_t));
-    buffer_create(&work_group_persistent_buffer, 6, device, c, true, sizeof(float) * 4);
+    buffer_create(&light_buffer, 3, device, s, BUFFER_USAGE_DEVICE, sizeof(light_t));
+    buffer_create(&substance_buffer, 4, device, s, BUFFER_USAGE_DEVICE, sizeof(substance_data_t));
+    buffer_create(&pointer_buffer, 5, device, c * s, BUFFER_USAGE_DEVICE, sizeof(uint32_t));
+    buffer_create(&work_group_persistent_buffer, 6, device, c, BUFFER_USAGE_DEVICE, sizeof(float) * 4);
+    buffer_create(&bin_buffer, 7, device, substance_bins_capacity(work_group_count, s), BUFFER_USAGE_DEVICE,
+                  sizeof(uint32_t));
+    buffer_create(&bvh_buffer, 14, device, substance_bvh_capacity(s), BUFFER_USAGE_DEVICE,
+                  sizeof(substance_bvh_node_t));
 }
 
 int renderer_t::get_frame_count() {
@@ -524,14 +738,32 @@ int renderer_t::get_frame_count() {
     return f;
 }
 
+void renderer_t::get_frame_statistics(frame_statistics_t *statistics) {
+    statistics->frames = timed_frames.exchange(0);
+    statistics->cpu_time = cpu_nanoseconds.exchange(0) / 1e9;
+    statistics->wait_time = wait_nanoseconds.exchange(0) / 1e9;
+    statistics->gpu_time = gpu_nanoseconds.exchange(0) / 1e9;
+    statistics->gpu_idle_time = gpu_idle_nanoseconds.exchange(0) / 1e9;
+}
+
 void renderer_destroy(renderer_t *renderer) {
 
-    shader_destroy(&renderer->vertex_shader);
-    shader_destroy(&renderer->fragment_shader);
+    if (!renderer->is_headless) {
+        shader_destroy(&renderer->vertex_shader);
+        shader_destroy(&renderer->fragment_shader);
+    }
 
     vkDestroyDescriptorSetLayout(renderer->device->device, renderer->descriptor_layout, NULL);
 
-    renderer->cleanup_swapchain();
+    if (!renderer->is_headless) {
+        renderer->cleanup_swapchain();
+    }
+
+    for (int i = 0; i < frames_in_flight; i++) {
+        if (renderer->is_frame_pending[i]) {
+            command_buffer_destroy(&renderer->compute_command_buffers[i]);
+        }
+    }
 
     command_pool_destroy(&renderer->graphics_command_pool);
     command_pool_destroy(&renderer->compute_command_pool);
@@ -543,7 +775,16 @@ void renderer_destroy(renderer_t *renderer) {
         vkDestroySemaphore(renderer->device->device, renderer->image_available_semas[i], NULL);
         vkDestroySemaphore(renderer->device->device, renderer->compute_done_semas[i], NULL);
         vkDestroySemaphore(renderer->device->device, renderer->render_finished_semas[i], NULL);
+        vkDestroySemaphore(renderer->device->device, renderer->graphics_done_semas[i], NULL);
         vkDestroyFence(renderer->device->device, renderer->in_flight_fences[i], NULL);
+
+        if (renderer->image_prefix != NULL) {
+            buffer_destroy(&renderer->image_readbacks[i]);
+        }
+    }
+
+    if (renderer->has_timestamps) {
+        vkDestroyQueryPool(renderer->device->device, renderer->timestamp_pool, NULL);
     }
 
     request_handler_destroy(&renderer->request_handler);
@@ -552,16 +793,25 @@ void renderer_destroy(renderer_t *renderer) {
     buffer_destroy(&renderer->light_buffer);
     buffer_destroy(&renderer->pointer_buffer);
     buffer_destroy(&renderer->work_group_persistent_buffer);
+    buffer_destroy(&renderer->bin_buffer);
+    buffer_destroy(&renderer->bvh_buffer);
+
+    job_pool_destroy(&renderer->jobs);
 
     texture_destroy(&renderer->render_texture);
+
+    staging_destroy(&renderer->staging);
+    renderer->device->staging = NULL;
 }
 
 void renderer_create(renderer_t *renderer, device_t *device, substance_t *substances, uint32_t *num_substances,
-                     VkSurfaceKHR surface, window_t *window, camera_t *test_camera, vec2u *work_group_count,
+                     VkSurfaceKHR surface, vec2u *window_size, camera_t *test_camera, vec2u *work_group_count,
                      vec2u *work_group_size, uint32_t max_image_size, material_t *materials, uint32_t *num_materials,
-                     sdf_t *sdfs, uint32_t *num_sdfs) {
+                     sdf_t *sdfs, uint32_t *num_sdfs, uint32_t number_of_request_workers) {
     renderer->device = device;
     renderer->surface = surface;
+    renderer->is_headless = surface == VK_NULL_HANDLE;
+    renderer->image_prefix = NULL;
     renderer->work_group_count = *work_group_count;
     renderer->work_group_size = *work_group_size;
     renderer->substances = substances;
@@ -572,9 +822,10 @@ void renderer_create(renderer_t *renderer, device_t *device, substance_t *substa
     renderer->start = std::chrono::high_resolution_clock::now();
 
     renderer->current_frame = 0;
+    renderer->graphics_pending = -1;
     renderer->push_constants.current_frame = 0;
     renderer->push_constants.render_distance = (float) rho;
-    renderer->push_constants.window_size = window->size;
+    renderer->push_constants.window_size = *window_size;
     renderer->push_constants.phi_initial = 0;
     renderer->push_constants.focal_depth = 1.0;
     renderer->push_constants.number_of_requests = number_of_requests;
@@ -585,28 +836,44 @@ void renderer_create(renderer_t *renderer, device_t *device, substance_t *substa
     renderer->push_constants.texture_pool_size = texture_pool_size;
     renderer->push_constants.epsilon = (float) epsilon;
     renderer->push_constants.number_of_raycasts = number_of_raycasts;
+    renderer->push_constants.number_of_bvh_nodes = 0;
 
     renderer->main_camera = test_camera;
 
     vkGetDeviceQueue(device->device, device->present_family, 0, &renderer->present_queue);
 
-    renderer->swapchain =
-            std::make_unique<swapchain_t>(device, &renderer->push_constants.window_size, surface);
+    if (!renderer->is_headless) {
+        renderer->swapchain =
+                std::make_unique<swapchain_t>(device, &renderer->push_constants.window_size, surface);
 
-    renderer->create_render_pass();
+        renderer->create_render_pass();
+    }
+
+    staging_create(&renderer->staging, device, SERAPHIM_STAGING_SIZE);
+    device->staging = &renderer->staging;
 
     renderer->create_buffers();
+    substance_list_create(&renderer->substance_list, renderer->work_group_size.x * renderer->work_group_size.y);
+    substance_bins_create(&renderer->substance_bins, renderer->work_group_count);
+    job_pool_create(&renderer->jobs, SERAPHIM_BINNING_THREADS);
+    substance_bvh_create(&renderer->substance_bvh);
+    renderer->is_bvh_written = false;
+    renderer->is_lights_written = false;
     request_handler_create(&renderer->request_handler, renderer->texture_size, renderer->push_constants.texture_depth, patch_sample_size, sdfs,
-                           num_sdfs, materials, num_materials, device);
+                           num_sdfs, materials, num_materials, device, number_of_request_workers);
 
     create_descriptor_set_layout(renderer);
-    renderer->create_graphics_pipeline();
+    if (!renderer->is_headless) {
+        renderer->create_graphics_pipeline();
+    }
     renderer->create_compute_pipeline();
 
     command_pool_create(&renderer->graphics_command_pool, device->device, device->graphics_family);
     command_pool_create(&renderer->compute_command_pool, device->device, device->compute_family);
 
-    renderer->create_framebuffers();
+    if (!renderer->is_headless) {
+        renderer->create_framebuffers();
+    }
     renderer->create_descriptor_pool();
     renderer->create_sync();
 
@@ -618,7 +885,7 @@ void renderer_create(renderer_t *renderer, device_t *device, substance_t *substa
 
     texture_create(&renderer->render_texture,
                    10, device, &size,
-                   VK_IMAGE_USAGE_STORAGE_BIT, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT,
+                   VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT,
                    VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
 
     std::vector<VkWriteDescriptorSet> write_desc_sets;
@@ -631,6 +898,10 @@ void renderer_create(renderer_t *renderer, device_t *device, substance_t *substa
                 buffer_write_descriptor_set(&renderer->pointer_buffer, descriptor_set));
         write_desc_sets.push_back(
                 buffer_write_descriptor_set(&renderer->work_group_persistent_buffer, descriptor_set));
+        write_desc_sets.push_back(
+                buffer_write_descriptor_set(&renderer->bin_buffer, descriptor_set));
+        write_desc_sets.push_back(
+                buffer_write_descriptor_set(&renderer->bvh_buffer, descriptor_set));
 
 
         write_desc_sets.push_back(
@@ -654,5 +925,23 @@ void renderer_create(renderer_t *renderer, device_t *device, substance_t *substa
     vkUpdateDescriptorSets(device->device, write_desc_sets.size(),
                            write_desc_sets.data(), 0, NULL);
 
-    renderer->create_command_buffers();
+    if (!renderer->is_headless) {
+        renderer->create_command_buffers();
+    }
+}
+
+// saves the image of every frame to a ppm named by the prefix and the frame's
+// number, once the frame has finished. this must be called before the first
+// frame is rendered.
+void renderer_save_images(renderer_t *renderer, const char *prefix) {
+    if (renderer->image_prefix != NULL) {
+        return;
+    }
+
+    VkExtent3D extents = renderer->render_texture.extents;
+    for (int i = 0; i < frames_in_flight; i++) {
+        buffer_create(&renderer->image_readbacks[i], ~0, renderer->device, 4 * extents.width * extents.height,
+                      BUFFER_USAGE_HOST, 1);
+    }
+    renderer->image_prefix = prefix;
 }
@@ -3,6 +3,7 @@
 
 #include <memory>
 
+#include <atomic>
 #include <chrono>
 #include <list>
 #include <map>
@@ -20,6 +21,10 @@
 #include "ui.h"
 #include "texture.h"
 #include "shader.h"
+#include "substances.h"
+#include "binning.h"
+#include "bvh.h"
+#include "jobs.h"
 #include "swapchain.h"
 #include "../common/camera.h"
 
@@ -41,12 +46,25 @@ struct push_constant_t {
     float epsilon;
 
     uint32_t number_of_raycasts;
-    uint32_t _unused[3];
+    uint32_t number_of_bvh_nodes;
+    uint32_t _unused[2];
 };
 
-static const uint8_t frames_in_flight = 2;
 static const uint32_t patch_sample_size = 2;
 
+// time spent on each side of the frames rendered since the statistics were
+// last taken, in seconds. the host's time includes the time waiting for earlier
+// frames. the device's times are measured by timestamps around the compute
+// work, where idle time is the gap between one frame's compute work and the
+// next, so they are zero if the compute queue has no timestamps.
+typedef struct frame_statistics_t {
+    uint64_t frames;
+    double cpu_time;
+    double wait_time;
+    double gpu_time;
+    double gpu_idle_time;
+} frame_statistics_t;
+
 struct renderer_t {
     vec2u work_group_count;
     vec2u work_group_size;
@@ -64,11 +82,46 @@ struct renderer_t {
     int frames;
     int current_frame;
 
+    // rendering without a surface, where the compute work is submitted alone
+    // and nothing is presented
+    bool is_headless;
+
     VkSemaphore image_available_semas[frames_in_flight];
     VkSemaphore compute_done_semas[frames_in_flight];
     VkSemaphore render_finished_semas[frames_in_flight];
+
+    // signalled by each frame's graphics work as well as render_finished, and
+    // waited for by the next frame's compute work, so that the render texture
+    // isn't written while the last frame still reads it. graphics_pending is
+    // the frame whose semaphore is yet to be waited for, or -1 if none is.
+    VkSemaphore graphics_done_semas[frames_in_flight];
+    int graphics_pending;
     VkFence in_flight_fences[frames_in_flight];
 
+    // the compute work of each frame in flight, which is freed once the frame
+    // that next uses its place has waited for it
+    command_buffer_t compute_command_buffers[frames_in_flight];
+    bool is_frame_pending[frames_in_flight];
+
+    // a timestamp before and after the compute work of each frame in flight
+    VkQueryPool timestamp_pool;
+    bool has_timestamps;
+    double timestamp_period;
+    uint64_t timestamp_mask;
+    uint64_t last_timestamp;
+
+    std::atomic<uint64_t> timed_frames;
+    std::atomic<uint64_t> cpu_nanoseconds;
+    std::atomic<uint64_t> wait_nanoseconds;
+    std::atomic<uint64_t> gpu_nanoseconds;
+    std::atomic<uint64_t> gpu_idle_nanoseconds;
+
+    // where each frame's image is saved, if they are, and the images read back
+    // by each frame in flight
+    const char *image_prefix;
+    buffer_t image_readbacks[frames_in_flight];
+    uint64_t image_frames[frames_in_flight];
+
     VkDescriptorSetLayout descriptor_layout;
     std::vector<VkDescriptorSet> desc_sets;
     VkDescriptorPool desc_pool;
@@ -92,6 +145,30 @@ struct renderer_t {
     buffer_t light_buffer;
     buffer_t pointer_buffer;
     buffer_t work_group_persistent_buffer;
+    buffer_t bin_buffer;
+    buffer_t bvh_buffer;
+
+    // the entries of the substance buffer, which are only written as they
+    // change, and the ranges of them that changed this frame
+    substance_list_t substance_list;
+    std::vector<substance_range_t> substance_ranges;
+
+    // the substances each work group may see, and the bins last written to the
+    // bin buffer, which are only written again when they change
+    substance_bins_t substance_bins;
+    std::vector<uint32_t> written_bins;
+    job_pool_t jobs;
+
+    // the hierarchy over the substance buffer, which is written whenever its
+    // nodes change or the last write failed
+    substance_bvh_t substance_bvh;
+    bool is_bvh_written;
+
+    // the light buffer is written once, or again if the last write failed
+    bool is_lights_written;
+
+    // host memory that writes to every device local buffer are staged in
+    staging_t staging;
 
     request_handler_t request_handler;
 
@@ -121,13 +198,17 @@ struct renderer_t {
     void render();
 
     int get_frame_count();
+
+    void get_frame_statistics(frame_statistics_t *statistics);
 };
 
 void renderer_create(renderer_t *renderer, device_t *device, substance_t *substances, uint32_t *num_substances,
-                     VkSurfaceKHR surface, window_t *window, camera_t *test_camera, vec2u *work_group_count,
+                     VkSurfaceKHR surface, vec2u *window_size, camera_t *test_camera, vec2u *work_group_count,
                      vec2u *work_group_size, uint32_t max_image_size, material_t *materials, uint32_t *num_materials,
-                     sdf_t *sdfs, uint32_t *num_sdfs);
+                     sdf_t *sdfs, uint32_t *num_sdfs, uint32_t number_of_request_workers);
 
 void renderer_destroy(renderer_t *renderer);
+void renderer_save_images(renderer_t *renderer, const char *prefix);
+void renderer_finish(renderer_t *renderer);
 
 #endif
@@ -1,40 +1,40 @@
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include "request.h"
 
-typedef struct patch_t {
-    uint32_t contents;
-    uint32_t hash;
-    float phi;
-    uint32_t normal;
-} patch_t;
-
-vec3 vertices[8] = {
-    {{0.0, 0.0, 0.0}}, {{2.0, 0.0, 0.0}},
-    {{0.0, 2.0, 0.0}}, {{2.0, 2.0, 0.0}},
-    {{0.0, 0.0, 2.0}}, {{2.0, 0.0, 2.0}},
-    {{0.0, 2.0, 2.0}}, {{2.0, 2.0, 2.0}}
-};
-
-request_t null_requests[number_of_requests];
-static const uint32_t null_status = 0;
-static const uint32_t geometry_request = 1;
-static const uint32_t texture_request = 2;
-static const uint32_t raycast_request = 3;
-
-static int request_handling_thread(void * request_handler);
-
-static uint32_t pack_vector(vec4 *x) {
-    uint8_t bytes[4];
-    for (int i = 0; i < 4; i++) {
-        bytes[i] = (uint8_t)(fmax(0.0, fmin(x->v[i] * 255.0, 255.0)));
-    }
-    return *(uint32_t *) bytes;
-}
+static int request_handling_thread(void * worker);
+static int request_dispatching_thread(void * request_handler);
 
 void request_handler_destroy(request_handler_t *request_handler) {
-    request_handler->should_quit = true;
-    cnd_broadcast(&request_handler->is_queue_empty);
-    thrd_join(request_handler->thread, NULL);
+    mtx_lock(&request_handler->dispatch_mutex);
+    {
+        request_handler->is_closed = true;
+        cnd_signal(&request_handler->dispatch_condition);
+    }
+    mtx_unlock(&request_handler->dispatch_mutex);
+    thrd_join(request_handler->dispatcher, NULL);
+
+    if (request_handler->is_capturing) {
+        capture_close(&request_handler->capture);
+    }
+
+    request_schedule_close(&request_handler->schedule);
+
+    for (uint32_t i = 0; i < request_handler->number_of_workers; i++) {
+        request_worker_t * worker = &request_handler->workers[i];
+        thrd_join(worker->thread, NULL);
+        mtx_destroy(&worker->response_mutex);
+    }
+
+    request_schedule_destroy(&request_handler->schedule);
+    generator_destroy(&request_handler->generator);
+    request_ring_destroy(&request_handler->ring);
+    cache_destroy(&request_handler->patch_cache);
+    cache_destroy(&request_handler->texture_cache);
+    mtx_destroy(&request_handler->dispatch_mutex);
+    mtx_destroy(&request_handler->view_mutex);
+    cnd_destroy(&request_handler->dispatch_condition);
 
     for (int i = 0; i < TEXTURE_TYPE_MAXIMUM; i++){
         texture_destroy(&request_handler->textures[i]);
@@ -48,34 +48,53 @@ void request_handler_destroy(request_handler_t *request_handler) {
 
 void request_handler_create(request_handler_t *request_handler, uint32_t texture_size, uint32_t texture_depth,
                             uint32_t patch_sample_size, sdf_t *sdfs, uint32_t *num_sdfs, material_t *materials,
-                            uint32_t *num_materials, device_t *device) {
+                            uint32_t *num_materials, device_t *device, uint32_t number_of_workers) {
     request_handler->device = device;
 
-    buffer_create(&request_handler->patch_buffer, 1, request_handler->device, geometry_pool_size, true,
-                  sizeof(patch_t));
-    buffer_create(&request_handler->request_buffer, 2, request_handler->device, number_of_requests, true, sizeof(request_t));
-    buffer_create(&request_handler->texture_hash_buffer, 8, request_handler->device, texture_pool_size, true,
-                  sizeof(uint32_t));
-    buffer_create(&request_handler->raycast_buffer, 9, request_handler->device, number_of_raycasts, true, sizeof(intersection_t));
-
-    request_handler->sdfs =sdfs;
-    request_handler->num_sdfs = num_sdfs;
-    request_handler->materials = materials;
-    request_handler->num_materials = num_materials;
+    buffer_create(&request_handler->patch_buffer, 1, request_handler->device, geometry_pool_size,
+                  BUFFER_USAGE_DEVICE, sizeof(patch_t));
+    buffer_create(&request_handler->request_buffer, 2, request_handler->device,
+                  SERAPHIM_REQUEST_HEADER_SIZE + number_of_requests * (sizeof(request_t) + sizeof(uint32_t)),
+                  BUFFER_USAGE_READBACK, 1);
+    request_handler->readback_size = SERAPHIM_REQUEST_MIN_READBACK;
+    for (uint32_t i = 0; i < frames_in_flight; i++) {
+        request_handler->readback_sizes[i] = 0;
+    }
+    buffer_create(&request_handler->texture_hash_buffer, 8, request_handler->device, texture_pool_size,
+                  BUFFER_USAGE_DEVICE, sizeof(uint32_t));
+    buffer_create(&request_handler->raycast_buffer, 9, request_handler->device, number_of_raycasts,
+                  BUFFER_USAGE_DEVICE, sizeof(intersection_t));
+
+    generator_create(&request_handler->generator, sdfs, num_sdfs, materials, num_materials);
+    if (!generator_open_stores(&request_handler->generator, SERAPHIM_REQUEST_PATCH_STORE,
+                               SERAPHIM_REQUEST_TEXTURE_STORE)) {
+        printf("Unable to open %s and %s, so patches and textures will not be kept\n",
+               SERAPHIM_REQUEST_PATCH_STORE, SERAPHIM_REQUEST_TEXTURE_STORE);
+    }
     request_handler->patch_sample_size = patch_sample_size;
     request_handler->texture_size = texture_size;
 
-    array_create(&request_handler->request_queue);
-    mtx_init(&request_handler->response_mutex, mtx_plain);
-    mtx_init(&request_handler->request_mutex, mtx_plain);
-    mtx_init(&request_handler->cnd_mutex, mtx_plain);
-    cnd_init(&request_handler->is_queue_empty);
-    request_handler->should_quit = false;
-    thrd_create(&request_handler->thread, request_handling_thread, request_handler);
-
-    for (size_t i = 0; i < number_of_requests; i++){
-        null_requests[i].status = null_status;
-    }
+    request_ring_create(&request_handler->ring, number_of_requests);
+    cache_create(&request_handler->patch_cache, geometry_pool_size);
+    cache_create(&request_handler->texture_cache, texture_pool_size);
+    request_tracker_create(&request_handler->tracker);
+    mtx_init(&request_handler->dispatch_mutex, mtx_plain);
+    cnd_init(&request_handler->dispatch_condition);
+    request_handler->is_closed = false;
+
+    mtx_init(&request_handler->view_mutex, mtx_plain);
+    request_handler->view = {};
+    request_handler->view_time = std::chrono::steady_clock::now();
+    request_prefetcher_create(&request_handler->prefetcher);
+    request_handler->is_capturing = false;
+    request_handler->dispatched = 0;
+    request_handler->unstaged = 0;
+    request_handler->waiting_textures = 0;
+    request_handler->texture_slot_hashes.assign(texture_pool_size, 0);
+    request_handler->texture_slot_states.assign(texture_pool_size, 0);
+    request_handler->pending_texture_slots.clear();
+    request_handler->pending_texture_slots.reserve(texture_pool_size);
+    request_handler->dropped = 0;
 
     vec3u size = {{ texture_size, texture_size, texture_depth }};
     vec3u_multiply_u(&size, &size, patch_sample_size);
@@ -87,204 +106,550 @@ void request_handler_create(request_handler_t *request_handler, uint32_t texture
                                                             VK_FORMAT_FEATURE_TRANSFER_DST_BIT),
                        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
     }
+
+    request_handler->number_of_workers = number_of_workers;
+    if (request_handler->number_of_workers < 1) {
+        request_handler->number_of_workers = 1;
+    } else if (request_handler->number_of_workers > SERAPHIM_REQUEST_MAX_WORKERS) {
+        request_handler->number_of_workers = SERAPHIM_REQUEST_MAX_WORKERS;
+    }
+    request_schedule_create(&request_handler->schedule, request_handler->number_of_workers);
+
+    for (uint32_t i = 0; i < request_handler->number_of_workers; i++) {
+        request_worker_t * worker = &request_handler->workers[i];
+        worker->request_handler = request_handler;
+        worker->index = i;
+
+        mtx_init(&worker->response_mutex, mtx_plain);
+        thrd_create(&worker->thread, request_handling_thread, worker);
+    }
+
+    thrd_create(&request_handler->dispatcher, request_dispatching_thread, request_handler);
 }
 
-static void handle_geometry_request(request_handler_t * request_handler, request_t * request){
-    uint32_t sdf_id = request->sdf_id;
-    if (sdf_id >= *request_handler->num_sdfs) {
+static void handle_geometry_request(request_worker_t * worker, request_t * request){
+    patch_t patch;
+    if (!generator_geometry(&worker->request_handler->generator, request, &patch)) {
         return;
     }
 
-    bound3_t *bound = sdf_bound(&request_handler->sdfs[sdf_id]);
-    vec3 midpoint;
-    bound3_midpoint(bound, &midpoint);
-    vec3 position = {{request->position.x, request->position.y, request->position.z}};
-    vec3_subtract(&position, &position, &midpoint);
+    mtx_lock(&worker->response_mutex);
+    {
+        worker->responses.patches.push_back({
+            .patch = patch,
+        });
+    }
+    mtx_unlock(&worker->response_mutex);
+}
+
+static void handle_raycast_requests(request_worker_t * worker, request_t ** requests, size_t count) {
+    request_t * handled[SERAPHIM_REQUEST_GROUP_SIZE];
+    intersection_t intersections[SERAPHIM_REQUEST_GROUP_SIZE];
+    size_t number_handled = generator_raycasts(&worker->request_handler->generator, requests, count, handled,
+                                               intersections);
 
-    uint32_t containsMask = 0;
+    mtx_lock(&worker->response_mutex);
+    {
+        for (size_t i = 0; i < number_handled; i++) {
+            worker->responses.raycasts.push_back({
+                .index = handled[i]->hash % number_of_raycasts,
+                .intersection = intersections[i],
+            });
+        }
+    }
+    mtx_unlock(&worker->response_mutex);
+}
 
-    for (int o = 0; o < 8; o++) {
-        vec3 d;
-        vec3_multiply_f(&d, &vertices[o], request->radius);
-        vec3_add(&d, &d, &position);
+static void handle_texture_request(request_worker_t * worker, request_t * request){
+    texture_response_t response;
+    if (!generator_texture(&worker->request_handler->generator, request, &response)) {
+        return;
+    }
 
-        if (!sdf_contains(&request_handler->sdfs[sdf_id], &d)) {
-            containsMask |= 1 << o;
+    mtx_lock(&worker->response_mutex);
+    {
+        worker->responses.textures.push_back(response);
+    }
+    mtx_unlock(&worker->response_mutex);
+}
+
+// workers take the most important requests from the schedule in small groups
+// of a single type, and record how long each group took against its budget
+static int request_handling_thread(void * worker_){
+    request_worker_t * worker = (request_worker_t *) worker_;
+    request_handler_t * request_handler = worker->request_handler;
+
+    while (true){
+        request_t requests[SERAPHIM_REQUEST_GROUP_SIZE];
+        uint32_t status;
+        size_t count = request_schedule_pop(&request_handler->schedule, requests, SERAPHIM_REQUEST_GROUP_SIZE, &status);
+        if (count == 0) {
+            break;
         }
+
+        auto start = std::chrono::steady_clock::now();
+
+        if (status == raycast_request){
+            request_t * raycast_requests[SERAPHIM_REQUEST_GROUP_SIZE];
+            for (size_t i = 0; i < count; i++){
+                raycast_requests[i] = &requests[i];
+            }
+            handle_raycast_requests(worker, raycast_requests, count);
+        } else {
+            for (size_t i = 0; i < count; i++){
+                if (status == geometry_request){
+                    handle_geometry_request(worker, &requests[i]);
+                } else if (status == texture_request){
+                    handle_texture_request(worker, &requests[i]);
+                }
+            }
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        request_schedule_spend(&request_handler->schedule, status, elapsed.count());
+
+        mtx_lock(&worker->response_mutex);
+        {
+            for (size_t i = 0; i < count; i++) {
+                worker->completed.push_back(request_tracker_key(status, requests[i].hash));
+            }
+        }
+        mtx_unlock(&worker->response_mutex);
     }
 
-    vec3 c;
-    vec3_multiply_f(&c, &position, request->radius);
-    float phi = (float) sdf_distance(&request_handler->sdfs[sdf_id], &c);
+    return 0;
+}
 
-    vec4 normal = vec4_zero;
-    normal.xyz = sdf_normal(&request_handler->sdfs[sdf_id], &c);
-    vec4_divide_f(&normal, &normal, 2);
-    vec4_add_f(&normal, &normal, 0.5);
-    uint32_t packed_normal = pack_vector(&normal);
+// copies the camera and the substances nearest to it for the prefetcher
+void request_handler_set_view(request_handler_t *request_handler, camera_t *camera, substance_t *substances,
+                              uint32_t num_substances, float focal_depth, float aspect_ratio) {
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> frame_time = now - request_handler->view_time;
+    request_handler->view_time = now;
+
+    prefetch_substance_t nearest[SERAPHIM_PREFETCH_MAX_SUBSTANCES];
+    double distances[SERAPHIM_PREFETCH_MAX_SUBSTANCES];
+    uint32_t number_of_nearest = 0;
+
+    for (uint32_t i = 0; i < num_substances; i++) {
+        matter_t * matter = &substances[i].matter;
+        double distance = vec3_distance_squared(&matter->transform.position, &camera->transform.position);
+
+        // keeps the nearest substances sorted by inserting each in place
+        uint32_t j = number_of_nearest < SERAPHIM_PREFETCH_MAX_SUBSTANCES ? number_of_nearest++ : number_of_nearest;
+        for (; j > 0 && distances[j - 1] > distance; j--) {
+            if (j < SERAPHIM_PREFETCH_MAX_SUBSTANCES) {
+                nearest[j] = nearest[j - 1];
+                distances[j] = distances[j - 1];
+            }
+        }
 
-    patch_t patch = {
-        .contents = containsMask << 16,
-        .hash = request->hash,
-        .phi = phi,
-        .normal = packed_normal,
-    };
-    uint32_t index = request->hash % geometry_pool_size;
+        if (j < SERAPHIM_PREFETCH_MAX_SUBSTANCES) {
+            nearest[j] = {
+                .sdf = matter->sdf,
+                .sdf_id = matter->sdf->id,
+                .material_id = matter->material->id,
+                .transform = matter->transform,
+            };
+            distances[j] = distance;
+        }
+    }
 
-    mtx_lock(&request_handler->response_mutex);
+    mtx_lock(&request_handler->view_mutex);
     {
-        buffer_write(&request_handler->patch_buffer, &patch, 1, index);
+        prefetch_view_t * view = &request_handler->view;
+        view->camera = camera->transform;
+        view->velocity = camera->velocity;
+        view->lookahead = SERAPHIM_PREFETCH_FRAMES * fmin(frame_time.count(), 0.1);
+        view->focal_depth = focal_depth;
+        view->aspect_ratio = aspect_ratio;
+        view->number_of_substances = number_of_nearest;
+        for (uint32_t i = 0; i < number_of_nearest; i++) {
+            view->substances[i] = nearest[i];
+        }
     }
-    mtx_unlock(&request_handler->response_mutex);
+    mtx_unlock(&request_handler->view_mutex);
 }
 
-static void handle_raycast_request(request_handler_t * request_handler, request_t * request) {
-    uint32_t sdf_id = request->sdf_id;
+// the render thread only copies the requests read back by the given frame,
+// once its fence has been signalled, into the next batch of the ring. the
+// shader appends requests to a compact list, so only the live requests are
+// read back and copied, and the batch is deduplicated and scheduled by the
+// dispatcher.
+void request_handler_handle_requests(request_handler_t * request_handler, uint32_t frame) {
+    uint32_t readback_size = request_handler->readback_sizes[frame];
+    if (readback_size == 0) {
+        return;
+    }
 
-    if (sdf_id >= *request_handler->num_sdfs) {
+    // if the dispatcher has fallen behind then this frame's requests are left,
+    // as the shader will repeat any that are still needed
+    request_t * requests = request_ring_acquire(&request_handler->ring);
+    if (requests == NULL) {
         return;
     }
 
-    sdf_t * sdf = &request_handler->sdfs[sdf_id];
-    ray_t ray = {
-        .position = {{.x = request->position.x, .y = request->position.y, .z = request->position.z }},
-        .direction = {{.x = request->direction.x, .y = request->direction.y, .z = request->direction.z }}
-    };
+    uint32_t count;
+
+    // the count includes requests appended after the list was full
+    char *memory = (char *) buffer_readback_memory(&request_handler->request_buffer, frame, 0);
+    count = *(uint32_t *) memory;
+    memcpy(requests, memory + SERAPHIM_REQUEST_HEADER_SIZE, std::min(count, readback_size) * sizeof(request_t));
+
+    request_ring_publish(&request_handler->ring, std::min(count, readback_size));
 
-    intersection_t intersection;
-    sdf_raycast(sdf, &ray, &intersection);
+    // requests beyond the readback are repeated by the shader next frame, when
+    // the readback has grown to fit them
+    request_handler->readback_size = std::min(
+        std::max(count + count / 2, (uint32_t) SERAPHIM_REQUEST_MIN_READBACK), number_of_requests);
 
-    uint32_t index = request->hash % number_of_raycasts;
-    mtx_lock(&request_handler->response_mutex);
+    mtx_lock(&request_handler->dispatch_mutex);
     {
-        buffer_write(&request_handler->raycast_buffer, &intersection, 1, index);
+        cnd_signal(&request_handler->dispatch_condition);
     }
-    mtx_unlock(&request_handler->response_mutex);
+    mtx_unlock(&request_handler->dispatch_mutex);
 }
 
-static void handle_texture_request(request_handler_t * request_handler, request_t * request){
-    uint32_t material_id = request->material_id;
-    uint32_t sdf_id = request->sdf_id;
-    if (material_id >= *request_handler->num_materials || sdf_id >= *request_handler->num_sdfs) {
-        return;
+// takes the keys of the requests that workers have handled since the last batch
+static void request_handler_complete_requests(request_handler_t *request_handler) {
+    for (uint32_t i = 0; i < request_handler->number_of_workers; i++) {
+        request_worker_t * worker = &request_handler->workers[i];
+
+        mtx_lock(&worker->response_mutex);
+        {
+            request_handler->completed.swap(worker->completed);
+        }
+        mtx_unlock(&worker->response_mutex);
+
+        for (uint64_t key : request_handler->completed) {
+            request_tracker_complete(&request_handler->tracker, key);
+        }
+        request_handler->completed.clear();
     }
+}
 
-    uint32_t normals[8];
-    uint32_t colours[8];
-    uint32_t physicals[8];
-    bound3_t *bound = sdf_bound(&request_handler->sdfs[sdf_id]);
-    vec3 midpoint;
-    bound3_midpoint(bound, &midpoint);
-    vec3 position = {{request->position.x, request->position.y, request->position.z}};
-    vec3_subtract(&position, &position, &midpoint);
+static void request_handler_dispatch_requests(request_handler_t *request_handler, request_t *requests,
+                                              uint32_t count) {
+    request_handler_complete_requests(request_handler);
 
-    for (int o = 0; o < 8; o++) {
-        vec3 d;
-        vec3_multiply_f(&d, &vertices[o], request->radius);
-        vec3_add(&d, &d, &position);
+    // speculative requests that waited too long are forgotten, so that they
+    // may be made again
+    request_handler->expired.clear();
+    request_schedule_advance(&request_handler->schedule, &request_handler->expired);
+    for (request_t &request : request_handler->expired) {
+        request_tracker_cancel(&request_handler->tracker, request_tracker_key(request.status, request.hash));
+    }
 
-        vec4 normal = vec4_zero;
-        normal.xyz = sdf_normal(&request_handler->sdfs[sdf_id], &d);
-        vec4_divide_f(&normal, &normal, 2);
-        vec4_add_f(&normal, &normal, 0.5);
-        normals[o] = pack_vector(&normal);
+    // the shader repeats a request every frame until its response arrives, so
+    // requests that are already being handled or were just served are dropped
+    request_tracker_advance(&request_handler->tracker);
 
-        vec4 colour = vec4_zero;
-        material_colour(&request_handler->materials[material_id], NULL, &colour.xyz);
-        colours[o] = pack_vector(&colour);
+    uint64_t dispatched = 0;
+    uint64_t dropped = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        request_t * request = &requests[i];
+        if (request->status == null_status) {
+            continue;
+        }
 
-        vec4 physical;
-        material_physical(&request_handler->materials[material_id], NULL, &physical);
-        physicals[o] = pack_vector(&physical);
+        uint64_t key = request_tracker_key(request->status, request->hash);
+        if (!request_tracker_dispatch(&request_handler->tracker, key)) {
+            dropped++;
+            continue;
+        }
+
+        if (request_schedule_push(&request_handler->schedule, request)) {
+            dispatched++;
+        } else {
+            request_tracker_cancel(&request_handler->tracker, key);
+            dropped++;
+        }
     }
 
-    int index = (int) (request->hash % texture_pool_size);
-    int texture_size = request_handler->texture_size;
-    vec3i p = {{
-        index % texture_size,
-        (index % (texture_size * texture_size)) / texture_size,
-        index / texture_size / texture_size
-    }};
-    vec3i_multiply_i(&p, &p, request_handler->patch_sample_size);
+    request_handler->dispatched += dispatched;
+    request_handler->dropped += dropped;
+}
 
-    mtx_lock(&request_handler->response_mutex);
+// speculatively schedules the requests for cells expected to become visible
+static void request_handler_prefetch_requests(request_handler_t *request_handler) {
+    prefetch_view_t view;
+    mtx_lock(&request_handler->view_mutex);
     {
-        buffer_write(&request_handler->texture_hash_buffer, &request->hash, 1, index);
-        request_handler->textures[TEXTURE_TYPE_NORMAL].write(&p, normals);
-        request_handler->textures[TEXTURE_TYPE_COLOUR].write(&p, colours);
-        request_handler->textures[TEXTURE_TYPE_PHYSICAL].write(&p, physicals);
+        view = request_handler->view;
     }
-    mtx_unlock(&request_handler->response_mutex);
+    mtx_unlock(&request_handler->view_mutex);
+
+    size_t count = request_prefetcher_predict(&request_handler->prefetcher, &view, request_handler->prefetches,
+                                              SERAPHIM_PREFETCH_MAX_REQUESTS);
+
+    size_t issued = 0;
+    for (size_t i = 0; i < count; i++) {
+        request_t * request = &request_handler->prefetches[i];
+        uint64_t key = request_tracker_key(request->status, request->hash);
+        if (!request_tracker_dispatch(&request_handler->tracker, key)) {
+            continue;
+        }
+
+        if (request_schedule_push_speculative(&request_handler->schedule, request, SERAPHIM_PREFETCH_FRAMES)) {
+            issued++;
+        } else {
+            request_tracker_cancel(&request_handler->tracker, key);
+        }
+    }
+
+    request_prefetcher_issue(&request_handler->prefetcher, issued);
 }
 
-static int request_handling_thread(void * request_handler_){
+// starts writing each batch of requests to the file, along with the sdfs and
+// materials they refer to. returns false if the file can't be opened.
+bool request_handler_capture(request_handler_t *request_handler, const char *filename) {
+    capture_t capture;
+    if (!capture_open_write(&capture, filename)) {
+        return false;
+    }
+
+    mtx_lock(&request_handler->dispatch_mutex);
+    {
+        if (request_handler->is_capturing) {
+            capture_close(&request_handler->capture);
+        }
+
+        request_handler->capture = capture;
+        request_handler->is_capturing = true;
+    }
+    mtx_unlock(&request_handler->dispatch_mutex);
+
+    return true;
+}
+
+static int request_dispatching_thread(void * request_handler_) {
     request_handler_t * request_handler = (request_handler_t *) request_handler_;
-    while (!request_handler->should_quit){
-        request_t * requests = NULL;
 
-        mtx_lock(&request_handler->request_mutex);
+    while (true) {
+        request_t * requests;
+        uint32_t count;
+        bool is_capturing;
+
+        mtx_lock(&request_handler->dispatch_mutex);
         {
-            if (!array_is_empty(&request_handler->request_queue)) {
-                requests = *request_handler->request_queue.first;
-                array_pop_front(&request_handler->request_queue);
+            while ((requests = request_ring_peek(&request_handler->ring, &count)) == NULL &&
+                   !request_handler->is_closed) {
+                cnd_wait(&request_handler->dispatch_condition, &request_handler->dispatch_mutex);
             }
+            is_capturing = request_handler->is_capturing;
         }
-        mtx_unlock(&request_handler->request_mutex);
+        mtx_unlock(&request_handler->dispatch_mutex);
 
         if (requests == NULL) {
-            cnd_wait(&request_handler->is_queue_empty, &request_handler->cnd_mutex);
-        } else {
-            for (size_t i = 0; i < number_of_requests; i++){
-                request_t * request = &requests[i];
-                if (request->status == geometry_request){
-                    handle_geometry_request(request_handler, request);
-                } else if (request->status == texture_request){
-                    handle_texture_request(request_handler, request);
-                } else if (request->status == raycast_request){
-                    handle_raycast_request(request_handler, request);
-                }
-            }
+            break;
+        }
 
-            free(requests);
+        if (is_capturing) {
+            generator_t * generator = &request_handler->generator;
+            capture_write_batch(&request_handler->capture, generator->sdfs, *generator->num_sdfs,
+                                generator->materials, *generator->num_materials, requests, count);
         }
+
+        request_handler_dispatch_requests(request_handler, requests, count);
+        request_ring_release(&request_handler->ring);
+        request_handler_prefetch_requests(request_handler);
     }
 
     return 0;
 }
 
-void request_handler_handle_requests(request_handler_t * request_handler) {
-    vkDeviceWaitIdle(request_handler->device->device);
+// writes a texture response to its slot of the pool, returning false if this
+// frame's uploads are used up
+static bool request_handler_upload_texture(request_handler_t *request_handler, texture_response_t *response) {
+    if (request_handler->texture_uploads == 0) {
+        return false;
+    }
 
-    request_t * requests = (request_t *) malloc(sizeof(request_t) * number_of_requests);
+    uint32_t slot;
+    bool is_stored = cache_insert(&request_handler->texture_cache, response->hash, &slot);
+    uint8_t * state = &request_handler->texture_slot_states[slot];
+
+    // the shader may still find the last occupant's hash in a reassigned slot,
+    // so an invalid hash is copied before the new bricks are
+    if (!is_stored || (*state & SERAPHIM_TEXTURE_SLOT_STALE)) {
+        uint32_t invalid = cache_invalid_hash(&request_handler->texture_cache, slot);
+        if (!buffer_write(&request_handler->texture_hash_buffer, &invalid, 1, slot)) {
+            *state |= SERAPHIM_TEXTURE_SLOT_STALE;
+            return false;
+        }
+        *state &= ~SERAPHIM_TEXTURE_SLOT_STALE;
+    }
+    request_handler->texture_uploads--;
 
-    void *memory_map = buffer_map(&request_handler->request_buffer, 0, number_of_requests);
-    {
-        memcpy(requests, memory_map, number_of_requests * sizeof(request_t));
-        memcpy(memory_map, null_requests, number_of_requests * sizeof(request_t));
+    int texture_size = request_handler->texture_size;
+    int index = (int) slot;
+    vec3i position = {{
+        index % texture_size,
+        (index % (texture_size * texture_size)) / texture_size,
+        index / texture_size / texture_size
+    }};
+    vec3i_multiply_i(&position, &position, request_handler->patch_sample_size);
+
+    for (int j = 0; j < TEXTURE_TYPE_MAXIMUM; j++) {
+        request_handler->textures[j].write(&position, response->samples[j]);
     }
-    buffer_unmap(&request_handler->request_buffer);
 
-    mtx_lock(&request_handler->request_mutex);
-    {
-        array_push_back(&request_handler->request_queue);
-        *(request_handler->request_queue.last) = requests;
+    // a hash waiting for an earlier occupant of the slot is replaced
+    request_handler->texture_slot_hashes[slot] = response->hash;
+    if (!(*state & SERAPHIM_TEXTURE_SLOT_HASH_PENDING)) {
+        *state |= SERAPHIM_TEXTURE_SLOT_HASH_PENDING;
+        request_handler->pending_texture_slots.push_back(slot);
     }
-    mtx_unlock(&request_handler->request_mutex);
+    return true;
+}
 
-    cnd_signal(&request_handler->is_queue_empty);
+static uint32_t request_handler_texture_slot(request_handler_t *request_handler, const vec3i *position) {
+    uint32_t texture_size = request_handler->texture_size;
+    uint32_t x = position->x / request_handler->patch_sample_size;
+    uint32_t y = position->y / request_handler->patch_sample_size;
+    uint32_t z = position->z / request_handler->patch_sample_size;
+    return x + (y + z * texture_size) * texture_size;
 }
 
-void request_handler_record_buffer_accesses(request_handler_t *request_handler, VkCommandBuffer command_buffer) {
-    buffer_record_read(&request_handler->request_buffer, command_buffer);
+// writes the hashes of the textures whose bricks have all been staged, leaving
+// the rest for a later frame
+static void request_handler_write_texture_hashes(request_handler_t *request_handler) {
+    std::vector<uint8_t> * states = &request_handler->texture_slot_states;
+    for (int i = 0; i < TEXTURE_TYPE_MAXIMUM; i++) {
+        for (texture_brick_t &brick : request_handler->textures[i].pending) {
+            (*states)[request_handler_texture_slot(request_handler, &brick.position)] |=
+                    SERAPHIM_TEXTURE_SLOT_BRICKS_WAITING;
+        }
+    }
+
+    std::vector<uint32_t> * pending = &request_handler->pending_texture_slots;
+    size_t number = 0;
+    for (uint32_t slot : *pending) {
+        uint8_t * state = &(*states)[slot];
+        if (!(*state & SERAPHIM_TEXTURE_SLOT_BRICKS_WAITING) &&
+            buffer_write(&request_handler->texture_hash_buffer, &request_handler->texture_slot_hashes[slot], 1,
+                         slot)) {
+            *state &= ~SERAPHIM_TEXTURE_SLOT_HASH_PENDING;
+        } else {
+            (*pending)[number++] = slot;
+        }
+    }
+    pending->resize(number);
+
+    for (int i = 0; i < TEXTURE_TYPE_MAXIMUM; i++) {
+        for (texture_brick_t &brick : request_handler->textures[i].pending) {
+            (*states)[request_handler_texture_slot(request_handler, &brick.position)] &=
+                    ~SERAPHIM_TEXTURE_SLOT_BRICKS_WAITING;
+        }
+    }
+}
 
-    mtx_lock(&request_handler->response_mutex);
+// moves the responses staged by each worker into the staging buffers. the
+// response sets are swapped so that workers are only blocked for the swap.
+static void request_handler_drain_worker(request_handler_t *request_handler, request_worker_t *worker) {
+    request_responses_t * drained = &worker->drained;
+
+    mtx_lock(&worker->response_mutex);
     {
-        buffer_record_write(&request_handler->patch_buffer, command_buffer);
-        buffer_record_write(&request_handler->texture_hash_buffer, command_buffer);
-        buffer_record_write(&request_handler->raycast_buffer, command_buffer);
-        for (int i = 0; i < TEXTURE_TYPE_MAXIMUM; i++) {
-            request_handler->textures[i].record_write(command_buffer);
+        drained->patches.swap(worker->responses.patches);
+        drained->textures.swap(worker->responses.textures);
+        drained->raycasts.swap(worker->responses.raycasts);
+    }
+    mtx_unlock(&worker->response_mutex);
+
+    for (patch_response_t &response : drained->patches) {
+        uint32_t slot;
+        cache_insert(&request_handler->patch_cache, response.patch.hash, &slot);
+        if (!buffer_write(&request_handler->patch_buffer, &response.patch, 1, slot)) {
+            request_handler->unstaged++;
+        }
+    }
+
+    for (texture_response_t &response : drained->textures) {
+        if (!request_handler_upload_texture(request_handler, &response)) {
+            request_handler->deferred_textures.push_back(response);
+        }
+    }
+
+    for (raycast_response_t &response : drained->raycasts) {
+        if (!buffer_write(&request_handler->raycast_buffer, &response.intersection, 1, response.index)) {
+            request_handler->unstaged++;
         }
     }
-    mtx_unlock(&request_handler->response_mutex);
+
+    drained->patches.clear();
+    drained->textures.clear();
+    drained->raycasts.clear();
+}
+
+void request_handler_record_buffer_accesses(request_handler_t *request_handler, VkCommandBuffer command_buffer) {
+    // only the count and the claimed slots need to be cleared before the
+    // shader appends this frame's requests
+    buffer_t * request_buffer = &request_handler->request_buffer;
+    uint64_t claims_offset = SERAPHIM_REQUEST_HEADER_SIZE + number_of_requests * sizeof(request_t);
+    buffer_record_fill(request_buffer, command_buffer, 0, SERAPHIM_REQUEST_HEADER_SIZE, 0);
+    buffer_record_fill(request_buffer, command_buffer, claims_offset, number_of_requests * sizeof(uint32_t), 0);
+
+    // bricks left over from the last frame count against this frame's uploads,
+    // and textures held back from the last frame are uploaded first
+    size_t waiting = request_handler->textures[0].pending.size();
+    request_handler->texture_uploads = waiting < SERAPHIM_REQUEST_MAX_TEXTURE_UPLOADS ?
+                                       SERAPHIM_REQUEST_MAX_TEXTURE_UPLOADS - (uint32_t) waiting : 0;
+
+    std::vector<texture_response_t> * retried = &request_handler->retried_textures;
+    retried->swap(request_handler->deferred_textures);
+    for (texture_response_t &response : *retried) {
+        if (!request_handler_upload_texture(request_handler, &response)) {
+            request_handler->deferred_textures.push_back(response);
+        }
+    }
+    retried->clear();
+
+    for (uint32_t i = 0; i < request_handler->number_of_workers; i++) {
+        request_handler_drain_worker(request_handler, &request_handler->workers[i]);
+    }
+    request_handler->waiting_textures = request_handler->deferred_textures.size();
+
+    buffer_record_write(&request_handler->patch_buffer, command_buffer);
+    buffer_record_write(&request_handler->raycast_buffer, command_buffer);
+    for (int i = 0; i < TEXTURE_TYPE_MAXIMUM; i++) {
+        request_handler->textures[i].record_write(command_buffer);
+    }
+
+    // the hashes are staged after the bricks, so that a hash is never copied
+    // in a frame before its texels are
+    request_handler_write_texture_hashes(request_handler);
+    buffer_record_write(&request_handler->texture_hash_buffer, command_buffer);
+}
+
+// copies the count and the requests expected back into the frame's mirror,
+// after the shader has appended this frame's requests
+void request_handler_record_readback(request_handler_t *request_handler, VkCommandBuffer command_buffer,
+                                     uint32_t frame) {
+    request_handler->readback_sizes[frame] = request_handler->readback_size;
+    buffer_record_read_range(&request_handler->request_buffer, command_buffer, frame, 0,
+                             SERAPHIM_REQUEST_HEADER_SIZE + request_handler->readback_size * sizeof(request_t));
+}
+
+void request_handler_statistics(request_handler_t *request_handler, request_statistics_t *statistics) {
+    statistics->dispatched = request_handler->dispatched.exchange(0);
+    statistics->dropped = request_handler->dropped.exchange(0);
+    statistics->unstaged = request_handler->unstaged.exchange(0);
+    statistics->waiting_textures = request_handler->waiting_textures;
+
+    statistics->updates = {};
+    buffer_t * buffers[3] = {
+        &request_handler->patch_buffer, &request_handler->texture_hash_buffer, &request_handler->raycast_buffer
+    };
+    for (buffer_t * buffer : buffers) {
+        buffer_statistics_t updates;
+        buffer_statistics(buffer, &updates);
+        statistics->updates.regions_written += updates.regions_written;
+        statistics->updates.regions_copied += updates.regions_copied;
+    }
+    cache_statistics(&request_handler->patch_cache, &statistics->patches);
+    cache_statistics(&request_handler->texture_cache, &statistics->textures);
+    corner_cache_statistics(&request_handler->generator.corner_cache, &statistics->corners);
+    generator_store_statistics(&request_handler->generator, &statistics->patch_store, &statistics->texture_store);
+    request_prefetcher_statistics(&request_handler->prefetcher, &statistics->prefetches);
 }
@@ -2,70 +2,187 @@
 #define SERAPHIM_RENDER_REQUEST_H
 
 #include "../common/array.h"
+#include "../common/camera.h"
+#include "../common/request_data.h"
 #include "../backend/metaphysics.h"
+#include "cache.h"
+#include "capture.h"
+#include "generator.h"
+#include "prefetch.h"
+#include "ring.h"
+#include "schedule.h"
 #include "texture.h"
+#include "tracker.h"
 
+#include <atomic>
+#include <chrono>
 #include <threads.h>
 
+#include <vector>
+
 static const uint32_t geometry_pool_size = 1000000;
 static const uint32_t texture_pool_size = 1000000;
 static const uint32_t number_of_requests = 2048;
 static const uint32_t base_texture_binding = 11;
 static const uint32_t number_of_raycasts = 1000000;
 
-typedef enum texture_type_t {
-    TEXTURE_TYPE_NORMAL = 0,
-    TEXTURE_TYPE_COLOUR,
-    TEXTURE_TYPE_PHYSICAL,
-    TEXTURE_TYPE_MAXIMUM
-} texture_type_t;
+#define SERAPHIM_REQUEST_MAX_WORKERS 32
 
-struct request_t {
-    vec3f position;
-    float radius;
+// files that generated patches and textures are kept in between runs, so that
+// the first frames after starting don't wait for them to be generated again
+#ifndef SERAPHIM_REQUEST_PATCH_STORE
+#define SERAPHIM_REQUEST_PATCH_STORE "patches.store"
+#endif
 
-    uint32_t hash;
-    uint32_t sdf_id;
-    uint32_t material_id;
-    uint32_t status;
+#ifndef SERAPHIM_REQUEST_TEXTURE_STORE
+#define SERAPHIM_REQUEST_TEXTURE_STORE "textures.store"
+#endif
 
-    vec3f direction;
-    uint32_t _1;
-};
+// texture responses uploaded each frame, beyond which they wait for the next.
+// the bricks of this many textures fit several times over in the staging.
+#define SERAPHIM_REQUEST_MAX_TEXTURE_UPLOADS 16384
 
-typedef struct request_handler_t {
-    device_t * device;
+// requests a worker takes from the schedule at a time
+#define SERAPHIM_REQUEST_GROUP_SIZE SERAPHIM_SDF_PACKET_SIZE
 
+// patches and textures are given their slot in the pool when they are drained
+typedef struct patch_response_t {
+    patch_t patch;
+} patch_response_t;
+
+typedef struct raycast_response_t {
+    uint32_t index;
+    intersection_t intersection;
+} raycast_response_t;
+
+typedef struct request_responses_t {
+    std::vector<patch_response_t> patches;
+    std::vector<texture_response_t> textures;
+    std::vector<raycast_response_t> raycasts;
+} request_responses_t;
+
+typedef struct request_worker_t {
+    struct request_handler_t * request_handler;
     thrd_t thread;
-    array_t(request_t *) request_queue;
-    mtx_t request_mutex;
+    uint32_t index;
+
+    // responses are staged per worker and swapped into drained by the render
+    // thread, so that both sets keep their capacity from frame to frame
     mtx_t response_mutex;
-    mtx_t cnd_mutex;
-    cnd_t is_queue_empty;
-    bool should_quit;
+    request_responses_t responses;
+    request_responses_t drained;
+
+    // keys of handled requests, taken by the dispatcher
+    std::vector<uint64_t> completed;
+} request_worker_t;
+
+typedef struct request_statistics_t {
+    uint64_t dispatched;
+    uint64_t dropped;
+    uint64_t unstaged;
+    uint64_t waiting_textures;
+    buffer_statistics_t updates;
+    cache_statistics_t patches;
+    cache_statistics_t textures;
+    corner_cache_statistics_t corners;
+    store_statistics_t patch_store;
+    store_statistics_t texture_store;
+    prefetch_statistics_t prefetches;
+} request_statistics_t;
+
+// the state of a slot of the texture pool, while its hash is waiting to be written
+#define SERAPHIM_TEXTURE_SLOT_HASH_PENDING 1
+#define SERAPHIM_TEXTURE_SLOT_BRICKS_WAITING 2
+#define SERAPHIM_TEXTURE_SLOT_STALE 4
+
+typedef struct request_handler_t {
+    device_t * device;
+
+    uint32_t number_of_workers;
+    request_worker_t workers[SERAPHIM_REQUEST_MAX_WORKERS];
+    request_schedule_t schedule;
+    generator_t generator;
+
+    // batches read back by the render thread are deduplicated and scheduled on
+    // the dispatcher thread, which is the only user of the tracker
+    request_ring_t ring;
+    thrd_t dispatcher;
+    mtx_t dispatch_mutex;
+    cnd_t dispatch_condition;
+    bool is_closed;
+    request_tracker_t tracker;
+    std::vector<uint64_t> completed;
+
+    // batches are also written to the capture, when one is open, so that they
+    // can be replayed without a device
+    bool is_capturing;
+    capture_t capture;
+
+    // the view is copied by the render thread each frame, and the dispatcher
+    // prefetches the cells it expects to become visible
+    mtx_t view_mutex;
+    prefetch_view_t view;
+    std::chrono::steady_clock::time_point view_time;
+    request_prefetcher_t prefetcher;
+    request_t prefetches[SERAPHIM_PREFETCH_MAX_REQUESTS];
+    std::vector<request_t> expired;
+
+    std::atomic<uint64_t> dispatched;
+    std::atomic<uint64_t> dropped;
+
+    // responses that didn't fit in the staging memory left for the frame,
+    // which the shader requests again
+    std::atomic<uint64_t> unstaged;
+
+    // texture responses held back because a frame's uploads were used up, and
+    // those being retried, which are swapped like the drained responses so
+    // that both keep their capacity. only used on the render thread.
+    std::vector<texture_response_t> deferred_textures;
+    std::vector<texture_response_t> retried_textures;
+    uint32_t texture_uploads;
+    std::atomic<uint64_t> waiting_textures;
+
+    // the hash of a texture is only written once its bricks are staged, and a
+    // reassigned slot is given an invalid hash before its new bricks are, so
+    // that the shader never finds a hash with another texture's texels. the
+    // hash waiting for each slot and its state are kept by slot, with the
+    // slots whose hashes are waiting. only used on the render thread.
+    std::vector<uint32_t> texture_slot_hashes;
+    std::vector<uint8_t> texture_slot_states;
+    std::vector<uint32_t> pending_texture_slots;
 
     texture_t textures[TEXTURE_TYPE_MAXIMUM];
 
+    // directories of the patch and texture pools, only used on the render thread
+    cache_t patch_cache;
+    cache_t texture_cache;
+
     buffer_t patch_buffer;
     buffer_t request_buffer;
     buffer_t texture_hash_buffer;
     buffer_t raycast_buffer;
 
+    // requests copied back by the next readback recorded, sized by the number
+    // the shader appended in the last frame read, and the requests copied
+    // back by the readback recorded in each frame in flight
+    uint32_t readback_size;
+    uint32_t readback_sizes[frames_in_flight];
+
     uint32_t patch_sample_size;
     uint32_t texture_size;
-
-    sdf_t * sdfs;
-    uint32_t * num_sdfs;
-
-    material_t *materials;
-    uint32_t *num_materials;
 } request_handler_t;
 
 void request_handler_create(request_handler_t *request_handler, uint32_t texture_size, uint32_t texture_depth,
                             uint32_t patch_sample_size, sdf_t *sdfs, uint32_t *num_sdfs, material_t *materials,
-                            uint32_t *num_materials, device_t *device);
+                            uint32_t *num_materials, device_t *device, uint32_t number_of_workers);
 void request_handler_destroy(request_handler_t *request_handler);
-void request_handler_handle_requests(request_handler_t * request_handler);
+bool request_handler_capture(request_handler_t *request_handler, const char *filename);
+void request_handler_set_view(request_handler_t *request_handler, camera_t *camera, substance_t *substances,
+                              uint32_t num_substances, float focal_depth, float aspect_ratio);
+void request_handler_handle_requests(request_handler_t * request_handler, uint32_t frame);
 void request_handler_record_buffer_accesses(request_handler_t *request_handler, VkCommandBuffer command_buffer);
+void request_handler_record_readback(request_handler_t *request_handler, VkCommandBuffer command_buffer,
+                                     uint32_t frame);
+void request_handler_statistics(request_handler_t *request_handler, request_statistics_t *statistics);
 
 #endif
@@ -0,0 +1,58 @@
+#include "ring.h"
+
+#include <stdlib.h>
+
+static_assert((SERAPHIM_RING_SIZE & (SERAPHIM_RING_SIZE - 1)) == 0, "ring size must be a power of two");
+
+void request_ring_create(request_ring_t *self, uint32_t batch_size) {
+    self->batch_size = batch_size;
+    for (int i = 0; i < SERAPHIM_RING_SIZE; i++) {
+        self->batches[i] = (request_t *) calloc(batch_size, sizeof(request_t));
+        self->counts[i] = 0;
+    }
+
+    self->head = 0;
+    self->tail = 0;
+}
+
+void request_ring_destroy(request_ring_t *self) {
+    for (int i = 0; i < SERAPHIM_RING_SIZE; i++) {
+        free(self->batches[i]);
+    }
+}
+
+// returns the next batch for the producer to fill, or NULL if the consumer has
+// fallen behind and every batch is waiting
+request_t *request_ring_acquire(request_ring_t *self) {
+    uint32_t head = self->head.load(std::memory_order_relaxed);
+    uint32_t tail = self->tail.load(std::memory_order_acquire);
+    if (head - tail >= SERAPHIM_RING_SIZE) {
+        return NULL;
+    }
+
+    return self->batches[head % SERAPHIM_RING_SIZE];
+}
+
+// makes the first count requests of the acquired batch ready to be dispatched
+void request_ring_publish(request_ring_t *self, uint32_t count) {
+    uint32_t head = self->head.load(std::memory_order_relaxed);
+    self->counts[head % SERAPHIM_RING_SIZE] = count;
+    self->head.store(head + 1, std::memory_order_release);
+}
+
+// returns the oldest published batch, or NULL if there are none
+request_t *request_ring_peek(request_ring_t *self, uint32_t *count) {
+    uint32_t tail = self->tail.load(std::memory_order_relaxed);
+    uint32_t head = self->head.load(std::memory_order_acquire);
+    if (head == tail) {
+        return NULL;
+    }
+
+    *count = self->counts[tail % SERAPHIM_RING_SIZE];
+    return self->batches[tail % SERAPHIM_RING_SIZE];
+}
+
+void request_ring_release(request_ring_t *self) {
+    uint32_t tail = self->tail.load(std::memory_order_relaxed);
+    self->tail.store(tail + 1, std::memory_order_release);
+}
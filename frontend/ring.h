@@ -0,0 +1,34 @@
+#ifndef SERAPHIM_RING_H
+#define SERAPHIM_RING_H
+
+#include "../common/request_data.h"
+
+#include <atomic>
+
+// batches of requests that can be waiting to be dispatched at once, which must
+// be a power of two
+#define SERAPHIM_RING_SIZE 4
+
+// a fixed ring of preallocated request batches passed from the render thread to
+// the dispatcher. the render thread is the only producer and the dispatcher the
+// only consumer, so each side only writes its own index and no lock is needed.
+typedef struct request_ring_t {
+    request_t * batches[SERAPHIM_RING_SIZE];
+    uint32_t counts[SERAPHIM_RING_SIZE];
+    uint32_t batch_size;
+
+    // batches in [tail, head) are ready to be dispatched
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+} request_ring_t;
+
+void request_ring_create(request_ring_t *self, uint32_t batch_size);
+void request_ring_destroy(request_ring_t *self);
+
+request_t *request_ring_acquire(request_ring_t *self);
+void request_ring_publish(request_ring_t *self, uint32_t count);
+
+request_t *request_ring_peek(request_ring_t *self, uint32_t *count);
+void request_ring_release(request_ring_t *self);
+
+#endif
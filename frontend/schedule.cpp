@@ -0,0 +1,196 @@
+#include "schedule.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+static const uint64_t never_expires = ~(uint64_t)0;
+
+static bool scheduled_request_comparator(const scheduled_request_t &a,
+                                         const scheduled_request_t &b) {
+    return a.priority < b.priority;
+}
+
+// the budgets are per worker, so that the time workers spend together on a type
+// of request is only limited as much as one worker's time would be
+void request_schedule_create(request_schedule_t *self, uint32_t number_of_workers) {
+    mtx_init(&self->mutex, mtx_plain);
+    cnd_init(&self->condition);
+    self->is_closed = false;
+    self->frame = 0;
+    self->size = 0;
+    self->speculative = 0;
+
+    for (uint32_t i = 0; i < SERAPHIM_REQUEST_TYPE_COUNT; i++) {
+        self->queues[i].clear();
+        self->budgets[i] = 0.0;
+        self->spent[i] = 0.0;
+    }
+
+    double workers = number_of_workers > 0 ? (double) number_of_workers : 1.0;
+    self->budgets[geometry_request] = SERAPHIM_SCHEDULE_GEOMETRY_BUDGET * workers;
+    self->budgets[texture_request] = SERAPHIM_SCHEDULE_TEXTURE_BUDGET * workers;
+    self->budgets[raycast_request] = SERAPHIM_SCHEDULE_RAYCAST_BUDGET * workers;
+}
+
+void request_schedule_destroy(request_schedule_t *self) {
+    for (uint32_t i = 0; i < SERAPHIM_REQUEST_TYPE_COUNT; i++) {
+        self->queues[i].clear();
+    }
+
+    mtx_destroy(&self->mutex);
+    cnd_destroy(&self->condition);
+}
+
+static bool request_schedule_push_ranked(request_schedule_t *self, const request_t *request, double penalty,
+                                         uint64_t frames) {
+    if (request->status == null_status || request->status >= SERAPHIM_REQUEST_TYPE_COUNT) {
+        return false;
+    }
+
+    bool is_speculative = frames != never_expires;
+
+    bool is_pushed = false;
+
+    mtx_lock(&self->mutex);
+    {
+        bool is_full = self->size >= SERAPHIM_SCHEDULE_MAX_QUEUED ||
+                       (is_speculative && self->speculative >= SERAPHIM_SCHEDULE_MAX_SPECULATIVE);
+        if (!is_full) {
+            // each level of detail halves the radius, and waiting raises the
+            // priority of every queued request at the same rate, so the
+            // priority can be fixed when the request is queued
+            double level = log2(fmax(request->radius, 1e-6));
+            double age = -(double)self->frame / SERAPHIM_SCHEDULE_FRAMES_PER_LEVEL;
+
+            std::vector<scheduled_request_t> *queue = &self->queues[request->status];
+            queue->push_back({
+                .request = *request,
+                .priority = level + age - penalty,
+                .expiry = is_speculative ? self->frame + frames : never_expires,
+            });
+            std::push_heap(queue->begin(), queue->end(), scheduled_request_comparator);
+
+            self->size++;
+            self->speculative += is_speculative;
+            is_pushed = true;
+        }
+    }
+    mtx_unlock(&self->mutex);
+
+    if (is_pushed) {
+        cnd_signal(&self->condition);
+    }
+
+    return is_pushed;
+}
+
+// returns false if the request could not be queued
+bool request_schedule_push(request_schedule_t *self, const request_t *request) {
+    return request_schedule_push_ranked(self, request, 0.0, never_expires);
+}
+
+// queues a request that may never be needed, such as a prefetch, behind those
+// made by the shader at the same level of detail, for the given number of frames
+bool request_schedule_push_speculative(request_schedule_t *self, const request_t *request, uint32_t frames) {
+    return request_schedule_push_ranked(self, request, SERAPHIM_SCHEDULE_SPECULATIVE_PENALTY, frames);
+}
+
+static int request_schedule_next_status(request_schedule_t *self) {
+    for (uint32_t i = 1; i < SERAPHIM_REQUEST_TYPE_COUNT; i++) {
+        if (!self->queues[i].empty() && self->spent[i] < self->budgets[i]) {
+            return (int)i;
+        }
+    }
+
+    return -1;
+}
+
+// waits for requests of a type that has not used its budget for this frame and
+// takes up to the given number of them. returns zero once the schedule is
+// closed.
+size_t request_schedule_pop(request_schedule_t *self, request_t *requests, size_t maximum,
+                            uint32_t *status) {
+    size_t count = 0;
+
+    mtx_lock(&self->mutex);
+    {
+        int next_status = request_schedule_next_status(self);
+        while (next_status < 0 && !self->is_closed) {
+            cnd_wait(&self->condition, &self->mutex);
+            next_status = request_schedule_next_status(self);
+        }
+
+        if (!self->is_closed) {
+            std::vector<scheduled_request_t> *queue = &self->queues[next_status];
+            while (count < maximum && !queue->empty()) {
+                std::pop_heap(queue->begin(), queue->end(), scheduled_request_comparator);
+                requests[count++] = queue->back().request;
+                self->speculative -= queue->back().expiry != never_expires;
+                queue->pop_back();
+            }
+
+            self->size -= count;
+            *status = (uint32_t)next_status;
+        }
+    }
+    mtx_unlock(&self->mutex);
+
+    return count;
+}
+
+void request_schedule_spend(request_schedule_t *self, uint32_t status, double seconds) {
+    mtx_lock(&self->mutex);
+    {
+        self->spent[status] += seconds;
+    }
+    mtx_unlock(&self->mutex);
+}
+
+// starts a new frame, which renews the budget of every request type and drops
+// the speculative requests that have expired, adding them to expired if given
+void request_schedule_advance(request_schedule_t *self, std::vector<request_t> *expired) {
+    mtx_lock(&self->mutex);
+    {
+        self->frame++;
+        for (uint32_t i = 0; i < SERAPHIM_REQUEST_TYPE_COUNT; i++) {
+            self->spent[i] = 0.0;
+        }
+
+        for (uint32_t i = 0; i < SERAPHIM_REQUEST_TYPE_COUNT && self->speculative > 0; i++) {
+            std::vector<scheduled_request_t> *queue = &self->queues[i];
+            uint64_t frame = self->frame;
+            auto first = std::partition(queue->begin(), queue->end(), [frame](const scheduled_request_t &scheduled) {
+                return scheduled.expiry >= frame;
+            });
+            if (first == queue->end()) {
+                continue;
+            }
+
+            if (expired != NULL) {
+                for (auto it = first; it != queue->end(); ++it) {
+                    expired->push_back(it->request);
+                }
+            }
+
+            size_t count = queue->end() - first;
+            queue->erase(first, queue->end());
+            std::make_heap(queue->begin(), queue->end(), scheduled_request_comparator);
+            self->size -= count;
+            self->speculative -= count;
+        }
+    }
+    mtx_unlock(&self->mutex);
+
+    cnd_broadcast(&self->condition);
+}
+
+void request_schedule_close(request_schedule_t *self) {
+    mtx_lock(&self->mutex);
+    {
+        self->is_closed = true;
+    }
+    mtx_unlock(&self->mutex);
+
+    cnd_broadcast(&self->condition);
+}
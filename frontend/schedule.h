@@ -0,0 +1,66 @@
+#ifndef SERAPHIM_SCHEDULE_H
+#define SERAPHIM_SCHEDULE_H
+
+#include "../common/request_data.h"
+
+#include <threads.h>
+
+#include <vector>
+
+// requests waiting beyond this are refused until the queue drains
+#define SERAPHIM_SCHEDULE_MAX_QUEUED 65536
+
+// frames waited that are worth the same as a request one level coarser
+#define SERAPHIM_SCHEDULE_FRAMES_PER_LEVEL 8.0
+
+// levels of detail that speculative requests are ranked below requests made by
+// the shader
+#define SERAPHIM_SCHEDULE_SPECULATIVE_PENALTY 4.0
+
+// speculative requests that may wait at once, which leaves the rest of the
+// queue for requests made by the shader
+#define SERAPHIM_SCHEDULE_MAX_SPECULATIVE (SERAPHIM_SCHEDULE_MAX_QUEUED / 4)
+
+// time per frame, in seconds, that each worker may spend on each type of request
+#define SERAPHIM_SCHEDULE_GEOMETRY_BUDGET 0.008
+#define SERAPHIM_SCHEDULE_TEXTURE_BUDGET 0.004
+#define SERAPHIM_SCHEDULE_RAYCAST_BUDGET 0.002
+
+// speculative requests expire on the last frame they may still be handled in,
+// and requests made by the shader never do
+typedef struct scheduled_request_t {
+    request_t request;
+    double priority;
+    uint64_t expiry;
+} scheduled_request_t;
+
+// queues requests by priority and shares each frame's time between request
+// types, so that the most visible holes are filled first under load. types are
+// served in order of their status, and within a type coarser and older
+// requests come first. speculative requests are dropped once they expire, as
+// by then the view they were predicted from has passed.
+typedef struct request_schedule_t {
+    mtx_t mutex;
+    cnd_t condition;
+    bool is_closed;
+
+    uint64_t frame;
+    size_t size;
+    size_t speculative;
+    std::vector<scheduled_request_t> queues[SERAPHIM_REQUEST_TYPE_COUNT];
+
+    double budgets[SERAPHIM_REQUEST_TYPE_COUNT];
+    double spent[SERAPHIM_REQUEST_TYPE_COUNT];
+} request_schedule_t;
+
+void request_schedule_create(request_schedule_t *self, uint32_t number_of_workers);
+void request_schedule_destroy(request_schedule_t *self);
+bool request_schedule_push(request_schedule_t *self, const request_t *request);
+bool request_schedule_push_speculative(request_schedule_t *self, const request_t *request, uint32_t frames);
+size_t request_schedule_pop(request_schedule_t *self, request_t *requests, size_t maximum,
+                            uint32_t *status);
+void request_schedule_spend(request_schedule_t *self, uint32_t status, double seconds);
+void request_schedule_advance(request_schedule_t *self, std::vector<request_t> *expired);
+void request_schedule_close(request_schedule_t *self);
+
+#endif
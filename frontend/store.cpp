@@ -0,0 +1,172 @@
+#include "store.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct store_header_t {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t value_size;
+    uint32_t number_of_sets;
+} store_header_t;
+
+typedef struct store_entry_t {
+    uint64_t key;
+    uint32_t is_valid;
+    uint32_t _1;
+} store_entry_t;
+
+// fnv-1a, continuing from the hash given
+uint32_t store_hash(uint32_t hash, const void *data, size_t size) {
+    const uint8_t * bytes = (const uint8_t *) data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t store_set(store_t *self, uint64_t key) {
+    uint64_t x = key * 0x9E3779B97F4A7C15ull;
+    return (uint32_t) (x >> 32) % self->number_of_sets;
+}
+
+static store_entry_t *store_entry(store_t *self, uint32_t index) {
+    return (store_entry_t *) (self->memory + sizeof(store_header_t) + (size_t) index * self->entry_size);
+}
+
+// maps the file, emptying it if it was made for values of another size or by
+// another version. returns false if the file can't be opened or mapped.
+bool store_open(store_t *self, const char *filename, size_t value_size, uint32_t size) {
+    self->value_size = value_size;
+    self->entry_size = sizeof(store_entry_t) + (value_size + 7) / 8 * 8;
+    self->number_of_sets = size / SERAPHIM_STORE_WAYS;
+    self->memory_size = sizeof(store_header_t) + (size_t) self->number_of_sets * SERAPHIM_STORE_WAYS *
+                                                 self->entry_size;
+
+    self->file = open(filename, O_RDWR | O_CREAT, 0644);
+    if (self->file < 0) {
+        return false;
+    }
+
+    store_header_t expected = {
+        .magic = SERAPHIM_STORE_MAGIC,
+        .version = SERAPHIM_STORE_VERSION,
+        .value_size = (uint32_t) value_size,
+        .number_of_sets = self->number_of_sets,
+    };
+
+    store_header_t header;
+    struct stat file_stat;
+    bool is_current = fstat(self->file, &file_stat) == 0 && (size_t) file_stat.st_size == self->memory_size &&
+                      pread(self->file, &header, sizeof(header), 0) == sizeof(header) &&
+                      memcmp(&header, &expected, sizeof(header)) == 0;
+
+    // truncating the file to nothing discards every entry, and the file is
+    // extended with zeros that mark each entry as empty
+    if (!is_current && (ftruncate(self->file, 0) != 0 || ftruncate(self->file, self->memory_size) != 0 ||
+                        pwrite(self->file, &expected, sizeof(expected), 0) != sizeof(expected))) {
+        close(self->file);
+        return false;
+    }
+
+    void * memory = mmap(NULL, self->memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, self->file, 0);
+    if (memory == MAP_FAILED) {
+        close(self->file);
+        return false;
+    }
+    self->memory = (uint8_t *) memory;
+
+    for (int i = 0; i < SERAPHIM_STORE_STRIPES; i++) {
+        mtx_init(&self->stripes[i], mtx_plain);
+    }
+
+    self->hits = 0;
+    self->misses = 0;
+    self->writes = 0;
+    return true;
+}
+
+void store_close(store_t *self) {
+    msync(self->memory, self->memory_size, MS_ASYNC);
+    munmap(self->memory, self->memory_size);
+    close(self->file);
+
+    for (int i = 0; i < SERAPHIM_STORE_STRIPES; i++) {
+        mtx_destroy(&self->stripes[i]);
+    }
+}
+
+// copies the value stored for the key, returning false if there is none
+bool store_load(store_t *self, uint64_t key, void *value) {
+    uint32_t set = store_set(self, key);
+    mtx_t * stripe = &self->stripes[set % SERAPHIM_STORE_STRIPES];
+
+    bool is_found = false;
+    mtx_lock(stripe);
+    {
+        for (int i = 0; i < SERAPHIM_STORE_WAYS && !is_found; i++) {
+            store_entry_t * entry = store_entry(self, set * SERAPHIM_STORE_WAYS + i);
+            if (entry->is_valid && entry->key == key) {
+                memcpy(value, entry + 1, self->value_size);
+                is_found = true;
+            }
+        }
+    }
+    mtx_unlock(stripe);
+
+    if (is_found) {
+        self->hits++;
+    } else {
+        self->misses++;
+    }
+    return is_found;
+}
+
+// stores the value for the key, in place of the value already stored for it,
+// or else in an empty entry of its set, or else in place of another entry
+void store_save(store_t *self, uint64_t key, const void *value) {
+    uint32_t set = store_set(self, key);
+    mtx_t * stripe = &self->stripes[set % SERAPHIM_STORE_STRIPES];
+
+    mtx_lock(stripe);
+    {
+        store_entry_t * chosen = NULL;
+        for (int i = 0; i < SERAPHIM_STORE_WAYS; i++) {
+            store_entry_t * entry = store_entry(self, set * SERAPHIM_STORE_WAYS + i);
+            if (entry->is_valid && entry->key == key) {
+                chosen = entry;
+                break;
+            }
+            if (!entry->is_valid && chosen == NULL) {
+                chosen = entry;
+            }
+        }
+
+        // the entry replaced depends on the key, so that keys that share a set
+        // don't keep replacing the same entry
+        if (chosen == NULL) {
+            chosen = store_entry(self, set * SERAPHIM_STORE_WAYS + (uint32_t) key % SERAPHIM_STORE_WAYS);
+        }
+
+        // the entry is invalidated while it is written, so that if the process
+        // stops part way through, a torn value is never loaded
+        chosen->is_valid = 0;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        memcpy(chosen + 1, value, self->value_size);
+        chosen->key = key;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        chosen->is_valid = 1;
+    }
+    mtx_unlock(stripe);
+
+    self->writes++;
+}
+
+void store_statistics(store_t *self, store_statistics_t *statistics) {
+    statistics->hits = self->hits.exchange(0);
+    statistics->misses = self->misses.exchange(0);
+    statistics->writes = self->writes.exchange(0);
+}
@@ -0,0 +1,56 @@
+#ifndef SERAPHIM_STORE_H
+#define SERAPHIM_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <threads.h>
+
+#include <atomic>
+
+// identifies store files, and the version of their layout
+#define SERAPHIM_STORE_MAGIC 0x524f5453
+#define SERAPHIM_STORE_VERSION 1
+
+// entries that may share a set of a store
+#define SERAPHIM_STORE_WAYS 4
+
+// locks shared between the sets of a store
+#define SERAPHIM_STORE_STRIPES 64
+
+typedef struct store_statistics_t {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t writes;
+} store_statistics_t;
+
+// a set associative table of fixed size values kept in a memory mapped file,
+// so that generated patches and textures outlive the process that made them.
+// pages of the file are only read when an entry in them is looked up. keys
+// include a hash of whatever the value was generated from, so values made
+// from an sdf or material that has since changed are never found, and are
+// replaced as their sets fill.
+typedef struct store_t {
+    int file;
+    uint8_t * memory;
+    size_t memory_size;
+
+    size_t value_size;
+    size_t entry_size;
+    uint32_t number_of_sets;
+
+    mtx_t stripes[SERAPHIM_STORE_STRIPES];
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> writes;
+} store_t;
+
+bool store_open(store_t *self, const char *filename, size_t value_size, uint32_t size);
+void store_close(store_t *self);
+bool store_load(store_t *self, uint64_t key, void *value);
+void store_save(store_t *self, uint64_t key, const void *value);
+void store_statistics(store_t *self, store_statistics_t *statistics);
+
+uint32_t store_hash(uint32_t hash, const void *data, size_t size);
+
+#endif
@@ -0,0 +1,106 @@
+#include "substances.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+void substance_list_create(substance_list_t *self, uint32_t capacity) {
+    self->capacity = capacity;
+    self->is_written = false;
+
+    self->datas.clear();
+    self->versions.clear();
+    self->order.clear();
+    self->sorted.assign(capacity, null_substance_data);
+    self->number_sorted = 0;
+
+    self->eye = vec3_zero;
+
+    self->recalculated = 0;
+    self->written = 0;
+}
+
+// forgets what was written, so that every entry is written by the next update.
+// this is for when a write didn't reach the device.
+void substance_list_invalidate(substance_list_t *self) {
+    self->is_written = false;
+}
+
+static void substance_list_mark(std::vector<substance_range_t> *ranges, uint32_t i) {
+    if (!ranges->empty() && ranges->back().first + ranges->back().number == i) {
+        ranges->back().number++;
+    } else {
+        ranges->push_back({ i, 1 });
+    }
+}
+
+// brings the entries up to date with the substances and the eye, finding the
+// ranges of entries that changed and so need to be written
+void substance_list_update(substance_list_t *self, substance_t *substances, uint32_t number_of_substances,
+                           vec3 *eye, std::vector<substance_range_t> *ranges) {
+    uint32_t number = std::min(number_of_substances, self->capacity);
+    uint32_t previous = (uint32_t) self->datas.size();
+
+    bool has_eye_moved = !self->is_written || self->eye.x != eye->x || self->eye.y != eye->y ||
+                         self->eye.z != eye->z;
+    self->eye = *eye;
+
+    self->datas.resize(number);
+    self->versions.resize(number);
+    for (uint32_t i = 0; i < number; i++) {
+        substance_t * substance = &substances[i];
+        substance_data_t * data = &self->datas[i];
+        uint32_t version = substance->version.load(std::memory_order_acquire);
+
+        if (i >= previous || self->versions[i] != version || data->id != substance->id) {
+            substance_data(substance, data, eye);
+            self->versions[i] = version;
+            self->recalculated++;
+        } else if (has_eye_moved) {
+            substance_data_distances(substance, data, eye);
+        }
+    }
+
+    if (number < previous) {
+        self->order.erase(std::remove_if(self->order.begin(), self->order.end(),
+                                         [number](uint32_t i) { return i >= number; }),
+                          self->order.end());
+    }
+
+    for (uint32_t i = previous; i < number; i++) {
+        self->order.push_back(i);
+    }
+
+    // the order of the last update is nearly sorted, so an insertion sort
+    // repairs it in close to a single pass
+    for (size_t i = 1; i < self->order.size(); i++) {
+        uint32_t index = self->order[i];
+        float far = self->datas[index].far;
+
+        size_t j = i;
+        for (; j > 0 && self->datas[self->order[j - 1]].far > far; j--) {
+            self->order[j] = self->order[j - 1];
+        }
+        self->order[j] = index;
+    }
+
+    // entries past the last substance only change when substances are removed
+    ranges->clear();
+    uint32_t end = self->is_written ? std::max(number, self->number_sorted) : self->capacity;
+    for (uint32_t i = 0; i < end; i++) {
+        const substance_data_t * data = i < number ? &self->datas[self->order[i]] : &null_substance_data;
+        if (!self->is_written || memcmp(&self->sorted[i], data, sizeof(substance_data_t)) != 0) {
+            self->sorted[i] = *data;
+            substance_list_mark(ranges, i);
+            self->written++;
+        }
+    }
+
+    self->number_sorted = number;
+    self->is_written = true;
+}
+
+void substance_list_statistics(substance_list_t *self, substance_list_statistics_t *statistics) {
+    statistics->recalculated = self->recalculated.exchange(0);
+    statistics->written = self->written.exchange(0);
+}
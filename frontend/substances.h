@@ -0,0 +1,51 @@
+#ifndef SERAPHIM_SUBSTANCES_H
+#define SERAPHIM_SUBSTANCES_H
+
+#include "../backend/metaphysics.h"
+
+#include <atomic>
+#include <vector>
+
+// a run of entries of the substance buffer that changed since it was last written
+typedef struct substance_range_t {
+    uint32_t first;
+    uint32_t number;
+} substance_range_t;
+
+typedef struct substance_list_statistics_t {
+    uint64_t recalculated;
+    uint64_t written;
+} substance_list_statistics_t;
+
+// the substance buffer as the shader sees it, kept up to date between frames.
+// substances are only recalculated when physics has moved them, their
+// distances from the eye only when either has moved, and the order by far
+// distance is repaired rather than sorted again, as it rarely changes much
+// from one frame to the next. entries past the last substance are null.
+typedef struct substance_list_t {
+    uint32_t capacity;
+    bool is_written;
+
+    // by the index of each substance, and the version it was calculated from
+    std::vector<substance_data_t> datas;
+    std::vector<uint32_t> versions;
+
+    // the indices of the substances by far distance, and the entries of the
+    // substance buffer in that order
+    std::vector<uint32_t> order;
+    std::vector<substance_data_t> sorted;
+    uint32_t number_sorted;
+
+    vec3 eye;
+
+    std::atomic<uint64_t> recalculated;
+    std::atomic<uint64_t> written;
+} substance_list_t;
+
+void substance_list_create(substance_list_t *self, uint32_t capacity);
+void substance_list_invalidate(substance_list_t *self);
+void substance_list_update(substance_list_t *self, substance_t *substances, uint32_t number_of_substances,
+                           vec3 *eye, std::vector<substance_range_t> *ranges);
+void substance_list_statistics(substance_list_t *self, substance_list_statistics_t *statistics);
+
+#endif
@@ -4,6 +4,10 @@
 #include "../common/debug.h"
 #include "buffer.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 VkImageView texture_create_image_view(VkDevice device, VkImage image,
                                       VkFormat format) {
     VkImageViewCreateInfo view_info = {};
@@ -51,32 +55,95 @@ texture_t::get_descriptor_write(VkDescriptorSet desc_set) const {
 }
 
 void texture_t::write(vec3i *p, uint32_t *x) {
-    uint32_t offset = (index++ % buffer_size(&staging_buffer));
-    buffer_write(&staging_buffer, x, 1, offset);
-
-    VkBufferImageCopy region;
-    region.bufferOffset = offset * staging_buffer.element_size;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset = {p->x, p->y, p->z};
-    region.imageExtent = {2, 2, 2};
-
-    updates.push_back(region);
+    texture_brick_t brick;
+    brick.position = *p;
+    memcpy(brick.texels, x, sizeof(brick.texels));
+    pending.push_back(brick);
 }
 
+static bool brick_comparator(const texture_brick_t &a, const texture_brick_t &b) {
+    if (a.position.z != b.position.z) {
+        return a.position.z < b.position.z;
+    }
+    if (a.position.y != b.position.y) {
+        return a.position.y < b.position.y;
+    }
+    return a.position.x < b.position.x;
+}
+
+// records copies of the pending bricks from the device's staging. bricks
+// written to the same place more than once are only copied the last time,
+// and runs of bricks next to each other along x are laid out as rows in the
+// staging and copied as one region. if the staging is too full then the rest
+// of the bricks wait for the next frame.
 void texture_t::record_write(VkCommandBuffer command_buffer) {
-    if (updates.empty()){
+    if (pending.empty()){
         return;
     }
 
-    vkCmdCopyBufferToImage(command_buffer, staging_buffer.buffer, image,
-                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, updates.size(),
-                           updates.data());
-    updates.clear();
+    // sorting keeps bricks written to the same place in the order written, so
+    // the last of each is kept
+    std::stable_sort(pending.begin(), pending.end(), brick_comparator);
+
+    size_t number = 0;
+    for (size_t i = 0; i < pending.size(); i++) {
+        if (number > 0 && !brick_comparator(pending[number - 1], pending[i])) {
+            pending[number - 1] = pending[i];
+        } else {
+            pending[number++] = pending[i];
+        }
+    }
+    pending.resize(number);
+
+    staging_t * staging = device->staging;
+    size_t first = 0;
+    while (first < pending.size()) {
+        size_t last = first + 1;
+        while (last < pending.size() && pending[last].position.z == pending[first].position.z &&
+               pending[last].position.y == pending[first].position.y &&
+               pending[last].position.x == pending[last - 1].position.x + 2) {
+            last++;
+        }
+
+        uint32_t length = (uint32_t) (last - first);
+        uint64_t offset;
+        if (!staging_claim(staging, length * sizeof(pending[first].texels), &offset)) {
+            break;
+        }
+
+        // each row of the run holds two texels from each of its bricks
+        uint32_t * texels = (uint32_t *) (staging->buffer.mapped + offset);
+        for (uint32_t k = 0; k < length; k++) {
+            for (int o = 0; o < 8; o++) {
+                int x = o & 1;
+                int row = o >> 1;
+                texels[row * 2 * length + 2 * k + x] = pending[first + k].texels[o];
+            }
+        }
+
+        VkBufferImageCopy region;
+        region.bufferOffset = offset;
+        region.bufferRowLength = 2 * length;
+        region.bufferImageHeight = 2;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {pending[first].position.x, pending[first].position.y, pending[first].position.z};
+        region.imageExtent = {2 * length, 2, 2};
+        updates.push_back(region);
+
+        first = last;
+    }
+
+    if (!updates.empty()) {
+        vkCmdCopyBufferToImage(command_buffer, staging->buffer.buffer, image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, updates.size(),
+                               updates.data());
+        updates.clear();
+    }
+
+    pending.erase(pending.begin(), pending.begin() + first);
 }
 
 void texture_create(texture_t *texture, uint32_t binding, device_t *device, vec3u *size, VkImageUsageFlags usage,
@@ -114,18 +181,11 @@ void texture_create(texture_t *texture, uint32_t binding, device_t *device, vec3
     VkMemoryRequirements mem_req;
     vkGetImageMemoryRequirements(device->device, texture->image, &mem_req);
 
-    VkMemoryAllocateInfo mem_alloc_info = {};
-    mem_alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    mem_alloc_info.allocationSize = mem_req.size;
-    mem_alloc_info.memoryTypeIndex = device_memory_type(
-            device, mem_req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    uint32_t memory_type = device_memory_type(device, mem_req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    allocator_allocate(&device->allocator, &mem_req, memory_type, ALLOCATOR_USAGE_IMAGE, &texture->allocation);
 
-    if (vkAllocateMemory(device->device, &mem_alloc_info, NULL, &texture->memory) !=
+    if (vkBindImageMemory(device->device, texture->image, texture->allocation.memory, texture->allocation.offset) !=
         VK_SUCCESS) {
-        PANIC("Error: Failed to allocate image memory.");
-    }
-
-    if (vkBindImageMemory(device->device, texture->image, texture->memory, 0) != VK_SUCCESS) {
         PANIC("Error: Failed to bind image.");
     }
     // create image view
@@ -158,17 +218,13 @@ void texture_create(texture_t *texture, uint32_t binding, device_t *device, vec3
     texture->image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
     texture->image_info.imageView = texture->image_view;
     texture->image_info.sampler = texture->sampler;
-
-    buffer_create(&texture->staging_buffer, ~0, device, staging_buffer_size, false,
-                  sizeof(uint32_t) * 8);
 }
 
 void texture_destroy(texture_t *texture) {
     vkDestroyImageView(texture->device->device, texture->image_view, NULL);
     vkDestroyImage(texture->device->device, texture->image, NULL);
-    vkFreeMemory(texture->device->device, texture->memory, NULL);
+    allocator_free(&texture->device->allocator, &texture->allocation);
     vkDestroySampler(texture->device->device, texture->sampler, NULL);
-    buffer_destroy(&texture->staging_buffer);
 }
 
 void texture_descriptor_layout_binding(texture_t *texture, VkDescriptorSetLayoutBinding * layout_binding) {
@@ -8,12 +8,16 @@
 
 #include <vector>
 
-static const uint32_t staging_buffer_size = 10000;
+// a 2x2x2 block of texels written to a texture, in x, then y, then z order
+typedef struct texture_brick_t {
+    vec3i position;
+    uint32_t texels[8];
+} texture_brick_t;
 
 typedef struct texture_t {
     VkImage image;
     VkImageView image_view;
-    VkDeviceMemory memory;
+    allocation_t allocation;
     VkFormat format;
     VkImageLayout layout;
     VkSampler sampler;
@@ -23,9 +27,10 @@ typedef struct texture_t {
     VkExtent3D extents;
     device_t *device;
 
-    buffer_t staging_buffer;
+    // bricks written since the last record, and those that didn't fit in the
+    // staging memory left for the frame, which are recorded with the next
+    std::vector<texture_brick_t> pending;
     std::vector<VkBufferImageCopy> updates;
-    uint32_t index;
 
     VkWriteDescriptorSet get_descriptor_write(VkDescriptorSet desc_set) const;
 
@@ -0,0 +1,55 @@
+#include "tracker.h"
+
+uint64_t request_tracker_key(uint32_t status, uint32_t hash) {
+    return ((uint64_t)status << 32) | hash;
+}
+
+void request_tracker_create(request_tracker_t *self) {
+    self->frame = 0;
+    self->in_flight.clear();
+    self->served.clear();
+    for (int i = 0; i < SERAPHIM_TRACKER_SERVED_FRAMES; i++) {
+        self->served_frames[i].clear();
+    }
+}
+
+// returns false if the request is a duplicate of one that is in flight or was
+// recently served
+bool request_tracker_dispatch(request_tracker_t *self, uint64_t key) {
+    if (self->in_flight.count(key) > 0 || self->served.count(key) > 0) {
+        return false;
+    }
+
+    self->in_flight.insert(key);
+    return true;
+}
+
+void request_tracker_complete(request_tracker_t *self, uint64_t key) {
+    if (self->in_flight.erase(key) == 0) {
+        return;
+    }
+
+    self->served[key] = self->frame;
+    self->served_frames[self->frame % SERAPHIM_TRACKER_SERVED_FRAMES].push_back(key);
+}
+
+// forgets a request that was dispatched but will not be handled
+void request_tracker_cancel(request_tracker_t *self, uint64_t key) {
+    self->in_flight.erase(key);
+}
+
+// forgets the requests served longest ago
+void request_tracker_advance(request_tracker_t *self) {
+    self->frame++;
+
+    std::vector<uint64_t> *expired =
+        &self->served_frames[self->frame % SERAPHIM_TRACKER_SERVED_FRAMES];
+    for (uint64_t key : *expired) {
+        auto it = self->served.find(key);
+        if (it != self->served.end() &&
+            it->second + SERAPHIM_TRACKER_SERVED_FRAMES <= self->frame) {
+            self->served.erase(it);
+        }
+    }
+    expired->clear();
+}
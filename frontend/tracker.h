@@ -0,0 +1,32 @@
+#ifndef SERAPHIM_TRACKER_H
+#define SERAPHIM_TRACKER_H
+
+#include <stdint.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// frames that a served request is remembered for, which covers the time taken
+// for its response to be uploaded and seen by the shader
+#define SERAPHIM_TRACKER_SERVED_FRAMES 4
+
+// remembers which requests are being handled and which were recently served,
+// so that the requests the shader repeats every frame are only handled once
+typedef struct request_tracker_t {
+    uint64_t frame;
+
+    std::unordered_set<uint64_t> in_flight;
+    std::unordered_map<uint64_t, uint64_t> served;
+    std::vector<uint64_t> served_frames[SERAPHIM_TRACKER_SERVED_FRAMES];
+} request_tracker_t;
+
+uint64_t request_tracker_key(uint32_t status, uint32_t hash);
+
+void request_tracker_create(request_tracker_t *self);
+bool request_tracker_dispatch(request_tracker_t *self, uint64_t key);
+void request_tracker_complete(request_tracker_t *self, uint64_t key);
+void request_tracker_cancel(request_tracker_t *self, uint64_t key);
+void request_tracker_advance(request_tracker_t *self);
+
+#endif
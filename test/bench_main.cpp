@@ -0,0 +1,64 @@
+//
+// raycast throughput benchmark
+//
+#include <stdio.h>
+#include <time.h>
+
+#include "../backend/primitive.h"
+#include "../backend/sdf.h"
+
+static const int image_size = 512;
+static const int repetitions = 8;
+
+static double now(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec * 1e-9;
+}
+
+static void create_ray(ray_t * ray, int u, int v){
+    ray->position = {{0.0, 0.5, -4.0}};
+    ray->direction = {{
+        (double) u / image_size - 0.5,
+        (double) v / image_size - 0.5,
+        1.0
+    }};
+    vec3_normalize(&ray->direction, &ray->direction);
+}
+
+static double benchmark(sdf_t * sdf, int packet_size){
+    ray_t rays[SERAPHIM_SDF_PACKET_SIZE];
+    intersection_t intersections[SERAPHIM_SDF_PACKET_SIZE];
+
+    double start = now();
+    for (int r = 0; r < repetitions; r++){
+        for (int v = 0; v < image_size; v++){
+            for (int u = 0; u < image_size; u += packet_size){
+                for (int i = 0; i < packet_size; i++){
+                    create_ray(&rays[i], u + i, v);
+                }
+
+                if (packet_size == 1){
+                    sdf_raycast(sdf, rays, intersections);
+                } else {
+                    sdf_raycast_packet(sdf, rays, packet_size, intersections);
+                }
+            }
+        }
+    }
+    double elapsed = now() - start;
+
+    return (double) image_size * image_size * repetitions / elapsed;
+}
+
+int main(){
+    double torus_radii[2] = {1.0, 0.25};
+    sdf_t torus_sdf;
+    sdf_create(0, &torus_sdf, sdf_torus, torus_radii);
+
+    int packet_sizes[3] = {1, 4, 8};
+    for (int i = 0; i < 3; i++){
+        double rays_per_second = benchmark(&torus_sdf, packet_sizes[i]);
+        printf("Packet size %d: %.0f rays/sec\n", packet_sizes[i], rays_per_second);
+    }
+}
@@ -0,0 +1,326 @@
+//
+// replays requests captured from the renderer through request handling, without a device
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../frontend/cache.h"
+#include "../frontend/capture.h"
+#include "../frontend/generator.h"
+#include "../frontend/schedule.h"
+#include "../frontend/tracker.h"
+
+// these match the pools of the request handler
+static const uint32_t geometry_pool_size = 1000000;
+static const uint32_t texture_pool_size = 1000000;
+
+static const uint32_t max_sdfs = 100;
+static const uint32_t max_materials = 100;
+static const size_t group_size = SERAPHIM_SDF_PACKET_SIZE;
+
+typedef std::chrono::steady_clock::time_point time_point_t;
+
+typedef struct replay_batch_t {
+    double time;
+    std::vector<request_t> requests;
+} replay_batch_t;
+
+typedef struct replay_completion_t {
+    uint32_t status;
+    uint32_t hash;
+    time_point_t time;
+} replay_completion_t;
+
+typedef struct replay_worker_t {
+    thrd_t thread;
+    request_schedule_t * schedule;
+    generator_t * generator;
+
+    mtx_t mutex;
+    std::vector<replay_completion_t> completed;
+} replay_worker_t;
+
+typedef struct replay_t {
+    sdf_t sdfs[max_sdfs];
+    uint8_t sdf_data[max_sdfs][SERAPHIM_CAPTURE_DATA_SIZE];
+    uint32_t num_sdfs;
+    uint32_t num_substitutes;
+    material_t materials[max_materials];
+    uint32_t num_materials;
+    std::vector<replay_batch_t> batches;
+
+    generator_t generator;
+    request_schedule_t schedule;
+    request_tracker_t tracker;
+    cache_t patch_cache;
+    cache_t texture_cache;
+
+    std::unordered_map<uint64_t, time_point_t> dispatch_times;
+    std::vector<double> latencies;
+    uint64_t patches;
+    uint64_t textures;
+    uint64_t raycasts;
+    uint64_t dispatched;
+    uint64_t dropped;
+} replay_t;
+
+static bool replay_load(replay_t *replay, const char *filename) {
+    capture_t capture;
+    if (!capture_open_read(&capture, filename)) {
+        return false;
+    }
+
+    replay->num_sdfs = 0;
+    replay->num_substitutes = 0;
+    replay->num_materials = 0;
+
+    capture_record_t record;
+    while (capture_read(&capture, &record)) {
+        if (record.type == CAPTURE_RECORD_SDF && replay->num_sdfs < max_sdfs) {
+            sdf_t * sdf = &replay->sdfs[replay->num_sdfs];
+            uint8_t * data = replay->sdf_data[replay->num_sdfs];
+            memcpy(data, record.sdf.data, SERAPHIM_CAPTURE_DATA_SIZE);
+
+            // sdfs that can't be recreated keep their place, so that later ids
+            // still match, as a unit sphere
+            if (!record.sdf.is_described || !sdf_create_described(record.sdf.id, sdf, record.sdf.name, data)) {
+                double r = 1.0;
+                memcpy(data, &r, sizeof(r));
+                sdf_create_described(record.sdf.id, sdf, "sphere", data);
+                replay->num_substitutes++;
+            }
+            replay->num_sdfs++;
+        } else if (record.type == CAPTURE_RECORD_MATERIAL && replay->num_materials < max_materials) {
+            replay->materials[replay->num_materials++] = record.material;
+        } else if (record.type == CAPTURE_RECORD_BATCH) {
+            replay->batches.push_back({ record.time, record.requests });
+        }
+    }
+
+    capture_close(&capture);
+    return true;
+}
+
+static int replay_worker_thread(void * worker_) {
+    replay_worker_t * worker = (replay_worker_t *) worker_;
+
+    while (true) {
+        request_t requests[group_size];
+        uint32_t status;
+        size_t count = request_schedule_pop(worker->schedule, requests, group_size, &status);
+        if (count == 0) {
+            break;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        if (status == raycast_request) {
+            request_t * raycast_requests[group_size];
+            request_t * handled[group_size];
+            intersection_t intersections[group_size];
+            for (size_t i = 0; i < count; i++) {
+                raycast_requests[i] = &requests[i];
+            }
+            generator_raycasts(worker->generator, raycast_requests, count, handled, intersections);
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                if (status == geometry_request) {
+                    patch_t patch;
+                    generator_geometry(worker->generator, &requests[i], &patch);
+                } else if (status == texture_request) {
+                    texture_response_t response;
+                    generator_texture(worker->generator, &requests[i], &response);
+                }
+            }
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed = end - start;
+        request_schedule_spend(worker->schedule, status, elapsed.count());
+
+        mtx_lock(&worker->mutex);
+        {
+            for (size_t i = 0; i < count; i++) {
+                worker->completed.push_back({ status, requests[i].hash, end });
+            }
+        }
+        mtx_unlock(&worker->mutex);
+    }
+
+    return 0;
+}
+
+// takes the requests completed by the workers, as the request handler does
+// when it drains their responses into the pools
+static void replay_complete(replay_t *replay, replay_worker_t *workers, uint32_t number_of_workers) {
+    std::vector<replay_completion_t> completed;
+
+    for (uint32_t i = 0; i < number_of_workers; i++) {
+        mtx_lock(&workers[i].mutex);
+        {
+            completed.swap(workers[i].completed);
+        }
+        mtx_unlock(&workers[i].mutex);
+
+        for (replay_completion_t &completion : completed) {
+            uint64_t key = request_tracker_key(completion.status, completion.hash);
+            request_tracker_complete(&replay->tracker, key);
+
+            auto dispatch_time = replay->dispatch_times.find(key);
+            if (dispatch_time != replay->dispatch_times.end()) {
+                std::chrono::duration<double> latency = completion.time - dispatch_time->second;
+                replay->latencies.push_back(latency.count());
+                replay->dispatch_times.erase(dispatch_time);
+            }
+
+            uint32_t slot;
+            if (completion.status == geometry_request) {
+                cache_insert(&replay->patch_cache, completion.hash, &slot);
+                replay->patches++;
+            } else if (completion.status == texture_request) {
+                cache_insert(&replay->texture_cache, completion.hash, &slot);
+                replay->textures++;
+            } else {
+                replay->raycasts++;
+            }
+        }
+        completed.clear();
+    }
+}
+
+static void replay_dispatch(replay_t *replay, replay_batch_t *batch) {
+    request_schedule_advance(&replay->schedule, NULL);
+    request_tracker_advance(&replay->tracker);
+
+    auto now = std::chrono::steady_clock::now();
+    for (request_t &request : batch->requests) {
+        if (request.status == null_status) {
+            continue;
+        }
+
+        uint64_t key = request_tracker_key(request.status, request.hash);
+        if (!request_tracker_dispatch(&replay->tracker, key)) {
+            replay->dropped++;
+            continue;
+        }
+
+        if (request_schedule_push(&replay->schedule, &request)) {
+            replay->dispatch_times[key] = now;
+            replay->dispatched++;
+        } else {
+            request_tracker_cancel(&replay->tracker, key);
+            replay->dropped++;
+        }
+    }
+}
+
+static double percentile(std::vector<double> &values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+
+    size_t index = std::min(values.size() - 1, (size_t) (p * (double) values.size()));
+    return values[index];
+}
+
+static void print_cache(const char *name, cache_t *cache) {
+    cache_statistics_t statistics;
+    cache_statistics(cache, &statistics);
+    printf("%s cache: %lu hits; %lu misses; %lu evictions\n", name, (unsigned long) statistics.hits,
+           (unsigned long) statistics.misses, (unsigned long) statistics.evictions);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("Usage: %s <capture file> [workers]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t number_of_workers = argc > 2 ? (uint32_t) atoi(argv[2]) : std::thread::hardware_concurrency();
+    number_of_workers = std::max(1u, std::min(number_of_workers, 32u));
+
+    replay_t * replay = new replay_t;
+    if (!replay_load(replay, argv[1])) {
+        printf("Unable to read capture %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("Replaying %zu batches for %u sdfs and %u materials on %u workers\n", replay->batches.size(),
+           replay->num_sdfs, replay->num_materials, number_of_workers);
+    if (replay->num_substitutes > 0) {
+        printf("%u sdfs could not be recreated and are replaced by spheres\n", replay->num_substitutes);
+    }
+
+    generator_create(&replay->generator, replay->sdfs, &replay->num_sdfs, replay->materials,
+                     &replay->num_materials);
+    request_schedule_create(&replay->schedule, number_of_workers);
+    request_tracker_create(&replay->tracker);
+    cache_create(&replay->patch_cache, geometry_pool_size);
+    cache_create(&replay->texture_cache, texture_pool_size);
+    replay->patches = 0;
+    replay->textures = 0;
+    replay->raycasts = 0;
+    replay->dispatched = 0;
+    replay->dropped = 0;
+
+    replay_worker_t * workers = new replay_worker_t[number_of_workers];
+    for (uint32_t i = 0; i < number_of_workers; i++) {
+        workers[i].schedule = &replay->schedule;
+        workers[i].generator = &replay->generator;
+        mtx_init(&workers[i].mutex, mtx_plain);
+        thrd_create(&workers[i].thread, replay_worker_thread, &workers[i]);
+    }
+
+    // batches are dispatched at the time they were read back from the renderer
+    auto start = std::chrono::steady_clock::now();
+    for (replay_batch_t &batch : replay->batches) {
+        std::this_thread::sleep_until(start + std::chrono::duration<double>(batch.time));
+        replay_complete(replay, workers, number_of_workers);
+        replay_dispatch(replay, &batch);
+    }
+
+    while (!replay->tracker.in_flight.empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        replay_complete(replay, workers, number_of_workers);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    request_schedule_close(&replay->schedule);
+    for (uint32_t i = 0; i < number_of_workers; i++) {
+        thrd_join(workers[i].thread, NULL);
+        mtx_destroy(&workers[i].mutex);
+    }
+
+    std::sort(replay->latencies.begin(), replay->latencies.end());
+    double seconds = elapsed.count() > 0.0 ? elapsed.count() : 1.0;
+
+    printf("Replayed in %.3f seconds\n", elapsed.count());
+    printf("Requests: %lu dispatched; %lu duplicates dropped\n", (unsigned long) replay->dispatched,
+           (unsigned long) replay->dropped);
+    printf("Throughput: %.0f patches/sec; %.0f textures/sec; %.0f raycasts/sec\n",
+           replay->patches / seconds, replay->textures / seconds, replay->raycasts / seconds);
+    printf("Latency: p50 %.3f ms; p90 %.3f ms; p99 %.3f ms; max %.3f ms\n",
+           percentile(replay->latencies, 0.5) * 1000.0, percentile(replay->latencies, 0.9) * 1000.0,
+           percentile(replay->latencies, 0.99) * 1000.0, percentile(replay->latencies, 1.0) * 1000.0);
+
+    corner_cache_statistics_t corners;
+    corner_cache_statistics(&replay->generator.corner_cache, &corners);
+    printf("Corner cache: %lu hits; %lu misses\n", (unsigned long) corners.hits, (unsigned long) corners.misses);
+    print_cache("Patch", &replay->patch_cache);
+    print_cache("Texture", &replay->texture_cache);
+
+    delete[] workers;
+    cache_destroy(&replay->patch_cache);
+    cache_destroy(&replay->texture_cache);
+    request_schedule_destroy(&replay->schedule);
+    generator_destroy(&replay->generator);
+    delete replay;
+}
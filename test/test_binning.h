@@ -0,0 +1,64 @@
+#ifndef SERAPHIM_TEST_BINNING_H
+#define SERAPHIM_TEST_BINNING_H
+
+#include "test_header.h"
+
+#include "../frontend/binning.h"
+
+extern inline const char * test_binning_covers_projection(){
+    // in front of the eye, behind it, far off to the side, and around it
+    const uint32_t n = 4;
+    float positions[n][3] = {{0.0f, 0.0f, 5.0f}, {0.0f, 0.0f, -5.0f}, {100.0f, 0.0f, 5.0f}, {2.0f, 0.0f, 0.0f}};
+    substance_data_t substances[n] = {};
+    for (uint32_t s = 0; s < n; s++){
+        for (int i = 0; i < MAT4_SIZE; i++){
+            substances[s].transform[i] = (float) mat4_identity.v[i];
+        }
+        for (int a = 0; a < 3; a++){
+            substances[s].transform[12 + a] = positions[s][a];
+        }
+        substances[s].r = {{0.5f, 0.5f, 0.5f}};
+        substances[s].near = 4.5f;
+        substances[s].far = 5.5f;
+        substances[s].id = s;
+    }
+
+    float eye[MAT4_SIZE];
+    for (int i = 0; i < MAT4_SIZE; i++){
+        eye[i] = (float) mat4_identity.v[i];
+    }
+
+    job_pool_t jobs;
+    job_pool_create(&jobs, 2);
+
+    substance_bins_t bins;
+    substance_bins_create(&bins, {{4u, 4u}});
+    substance_bins_update(&bins, &jobs, substances, n, eye, 1.0f, 100.0f);
+
+    uint32_t * data = bins.data.data();
+    TEST_ASSERT(data[16] == bins.data.size(), "the last offset should be the end of the bins");
+    for (uint32_t y = 0; y < 4; y++){
+        for (uint32_t x = 0; x < 4; x++){
+            uint32_t t = x + y * 4;
+            bool is_centre = (x == 1 || x == 2) && (y == 1 || y == 2);
+            uint32_t * list = &data[data[t]];
+            uint32_t size = data[t + 1] - data[t];
+
+            if (is_centre){
+                TEST_ASSERT(size == 2 && list[0] == 0 && list[1] == 3,
+                            "the centre tiles should see the substance in front of the eye, in order");
+            } else {
+                TEST_ASSERT(size == 1 && list[0] == 3, "only a bound straddling the eye should cover every tile");
+            }
+        }
+    }
+
+    // a substance beyond the render distance covers no tiles
+    substance_bins_update(&bins, &jobs, substances, 1, eye, 1.0f, 4.0f);
+    TEST_ASSERT(bins.data.size() == 17, "substances that can't be reached should not be binned");
+
+    job_pool_destroy(&jobs);
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_BINNING_H
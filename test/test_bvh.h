@@ -0,0 +1,82 @@
+#ifndef SERAPHIM_TEST_BVH_H
+#define SERAPHIM_TEST_BVH_H
+
+#include "test_header.h"
+
+#include "../frontend/bvh.h"
+
+static void test_bvh_substance(substance_data_t *substance, uint32_t id, float x){
+    *substance = {};
+    for (int i = 0; i < MAT4_SIZE; i++){
+        substance->transform[i] = (float) mat4_identity.v[i];
+    }
+    substance->transform[12] = x;
+    substance->r = {{0.5f, 0.5f, 0.5f}};
+    substance->id = id;
+}
+
+// whether every substance is in exactly one leaf, whose bound is the substance's
+static bool test_bvh_is_valid(substance_bvh_t *bvh, substance_data_t *substances, uint32_t n){
+    if (bvh->nodes.size() != 2 * n - 1 || bvh->nodes[0].escape != bvh->nodes.size()){
+        return false;
+    }
+
+    std::vector<uint32_t> leaves(n, 0);
+    for (substance_bvh_node_t &node : bvh->nodes){
+        if (node.substance != (uint32_t) ~0){
+            leaves[node.substance]++;
+            float x = substances[node.substance].transform[12];
+            if (node.lower.x != x - 0.5f || node.upper.x != x + 0.5f){
+                return false;
+            }
+        }
+    }
+
+    for (uint32_t count : leaves){
+        if (count != 1){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+extern inline const char * test_bvh_refits_moving_substances(){
+    const uint32_t n = 5;
+    substance_data_t substances[n];
+    for (uint32_t i = 0; i < n; i++){
+        test_bvh_substance(&substances[i], i, 2.0f * i);
+    }
+
+    substance_bvh_t bvh;
+    substance_bvh_create(&bvh);
+    substance_bvh_statistics_t statistics;
+
+    TEST_ASSERT(substance_bvh_update(&bvh, substances, n), "the first update should build the bvh");
+    TEST_ASSERT(test_bvh_is_valid(&bvh, substances, n), "the bvh should hold each substance once");
+    TEST_ASSERT(!substance_bvh_update(&bvh, substances, n), "nothing should change when nothing moved");
+
+    substances[4].transform[12] += 0.5f;
+    TEST_ASSERT(substance_bvh_update(&bvh, substances, n), "a moved substance should change the bvh");
+    TEST_ASSERT(bvh.nodes[0].upper.x == 9.0f, "the root should be refitted around the moved substance");
+
+    // the entries are reordered, as when the eye moves
+    std::swap(substances[0], substances[3]);
+    TEST_ASSERT(substance_bvh_update(&bvh, substances, n), "reordered entries should change the bvh");
+    TEST_ASSERT(test_bvh_is_valid(&bvh, substances, n), "leaves should follow their substances");
+
+    substance_bvh_statistics(&bvh, &statistics);
+    TEST_ASSERT(statistics.rebuilds == 1 && statistics.refits == 3, "the bvh should only be built once");
+
+    // far enough that the refitted bounds are too loose
+    substances[1].transform[12] = 100.0f;
+    substance_bvh_update(&bvh, substances, n);
+    substance_bvh_update(&bvh, substances, n - 1);
+    substance_bvh_statistics(&bvh, &statistics);
+    TEST_ASSERT(statistics.rebuilds == 2, "loose bounds and removed substances should rebuild the bvh");
+    TEST_ASSERT(test_bvh_is_valid(&bvh, substances, n - 1), "the rebuilt bvh should hold each substance once");
+
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_BVH_H
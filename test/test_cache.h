@@ -0,0 +1,43 @@
+#ifndef SERAPHIM_TEST_CACHE_H
+#define SERAPHIM_TEST_CACHE_H
+
+#include "test_header.h"
+
+#include "../frontend/cache.h"
+
+extern inline const char * test_cache_eviction(){
+    cache_t cache;
+    cache_create(&cache, SERAPHIM_CACHE_WAYS * 2);
+
+    // hashes that are equal modulo the number of sets share a set
+    uint32_t slots[SERAPHIM_CACHE_WAYS + 1];
+    for (uint32_t i = 0; i < SERAPHIM_CACHE_WAYS; i++){
+        TEST_ASSERT(!cache_insert(&cache, i * 2, &slots[i]), "new hash should miss");
+        TEST_ASSERT(slots[i] < SERAPHIM_CACHE_WAYS, "hash should be stored in its set");
+        for (uint32_t j = 0; j < i; j++){
+            TEST_ASSERT(slots[i] != slots[j], "colliding hashes should not overwrite each other");
+        }
+    }
+
+    uint32_t slot;
+    TEST_ASSERT(cache_insert(&cache, 0, &slot) && slot == slots[0], "stored hash should hit");
+
+    cache_statistics_t statistics;
+    cache_statistics(&cache, &statistics);
+    TEST_ASSERT(statistics.evictions == 0, "set should have room for every way");
+
+    // the first hash was referenced again, so the second is evicted instead
+    cache_insert(&cache, 1, &slot);
+    cache_insert(&cache, SERAPHIM_CACHE_WAYS * 2, &slots[SERAPHIM_CACHE_WAYS]);
+    TEST_ASSERT(slots[SERAPHIM_CACHE_WAYS] != slots[0], "referenced hash should not be evicted first");
+    TEST_ASSERT(cache_insert(&cache, 0, &slot), "referenced hash should still be stored");
+
+    cache_statistics(&cache, &statistics);
+    TEST_ASSERT(statistics.hits == 1 && statistics.misses == 2 && statistics.evictions == 1,
+                "statistics should count hits, misses and evictions");
+
+    cache_destroy(&cache);
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_CACHE_H
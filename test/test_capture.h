@@ -0,0 +1,70 @@
+#ifndef SERAPHIM_TEST_CAPTURE_H
+#define SERAPHIM_TEST_CAPTURE_H
+
+#include "test_header.h"
+
+#include "../backend/primitive.h"
+#include "../frontend/capture.h"
+
+extern inline const char * test_capture_round_trip(){
+    double radii[2] = {1.0, 0.25};
+    sdf_t sdfs[2];
+    sdf_create(0, &sdfs[0], sdf_torus, radii);
+    sdf_create(1, &sdfs[1], sdf_sphere, &radii[0]);
+
+    material_t material;
+    vec3 colour = {{0.5, 0.25, 1.0}};
+    material_create(&material, 0, &colour);
+
+    request_t requests[3] = {};
+    for (int i = 0; i < 3; i++){
+        requests[i].hash = 100 + i;
+        requests[i].sdf_id = i % 2;
+        requests[i].status = geometry_request;
+    }
+
+    const char * filename = "test_capture.bin";
+    capture_t capture;
+    TEST_ASSERT(capture_open_write(&capture, filename), "capture should open for writing");
+    capture_write_batch(&capture, sdfs, 1, &material, 1, requests, 3);
+    capture_write_batch(&capture, sdfs, 2, &material, 1, requests, 1);
+    capture_close(&capture);
+
+    TEST_ASSERT(capture_open_read(&capture, filename), "capture should open for reading");
+
+    capture_record_t record;
+    int types[5] = {CAPTURE_RECORD_SDF, CAPTURE_RECORD_MATERIAL, CAPTURE_RECORD_BATCH, CAPTURE_RECORD_SDF,
+                    CAPTURE_RECORD_BATCH};
+    sdf_t replayed;
+    size_t batch_sizes[2] = {3, 1};
+    int number_of_batches = 0;
+
+    for (int i = 0; i < 5; i++){
+        TEST_ASSERT(capture_read(&capture, &record), "capture should have every record");
+        TEST_ASSERT(record.type == types[i], "registrations should come before the batch that first sees them");
+
+        if (record.type == CAPTURE_RECORD_SDF){
+            TEST_ASSERT(record.sdf.is_described, "primitive sdfs should be described");
+            TEST_ASSERT(sdf_create_described(record.sdf.id, &replayed, record.sdf.name, record.sdf.data),
+                        "described sdf should be created again");
+            vec3 x = {{0.5, 0.25, 0.0}};
+            TEST_ASSERT(fabs(sdf_distance(&replayed, &x) - sdf_distance(&sdfs[record.sdf.id], &x)) < 1e-9,
+                        "replayed sdf should match the original");
+        } else if (record.type == CAPTURE_RECORD_MATERIAL){
+            TEST_ASSERT(record.material.colour.y == 0.25, "material should be copied");
+        } else {
+            TEST_ASSERT(record.requests.size() == batch_sizes[number_of_batches], "batch should keep its size");
+            TEST_ASSERT(record.requests[0].hash == 100 && record.requests.back().sdf_id == (record.requests.size() - 1) % 2,
+                        "batch should keep its requests");
+            number_of_batches++;
+        }
+    }
+
+    TEST_ASSERT(!capture_read(&capture, &record), "capture should end after the last batch");
+    capture_close(&capture);
+    remove(filename);
+
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_CAPTURE_H
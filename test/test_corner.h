@@ -0,0 +1,47 @@
+#ifndef SERAPHIM_TEST_CORNER_H
+#define SERAPHIM_TEST_CORNER_H
+
+#include "test_header.h"
+
+#include "../backend/primitive.h"
+#include "../frontend/corner.h"
+
+extern inline const char * test_corner_cache_reuse(){
+    double r = 1.0;
+    sdf_t sphere_sdf;
+    sdf_create(0, &sphere_sdf, sdf_sphere, &r);
+
+    corner_cache_t cache;
+    corner_cache_create(&cache);
+
+    corner_key_t key = {
+        .sdf_id = 0,
+        .corner = {{1, 0, 0}},
+    };
+    vec3 x = {{0.5, 0.0, 0.0}};
+
+    corner_sample_t sample;
+    corner_cache_sample(&cache, &sphere_sdf, &key, &x, false, &sample);
+    TEST_ASSERT(fabs(sample.phi - sdf_distance(&sphere_sdf, &x)) < 1e-9, "sample should match the sdf");
+
+    corner_cache_sample(&cache, &sphere_sdf, &key, &x, false, &sample);
+    corner_cache_statistics_t statistics;
+    corner_cache_statistics(&cache, &statistics);
+    TEST_ASSERT(statistics.hits == 1 && statistics.misses == 1, "second sample of a corner should hit");
+
+    corner_cache_sample(&cache, &sphere_sdf, &key, &x, true, &sample);
+    TEST_ASSERT(sample.has_normal && sample.normal.x > 0.99, "normal should be added to the sample");
+    corner_cache_sample(&cache, &sphere_sdf, &key, &x, true, &sample);
+    corner_cache_statistics(&cache, &statistics);
+    TEST_ASSERT(statistics.hits == 1 && statistics.misses == 1, "cached normal should be reused");
+
+    key.sdf_id = 1;
+    corner_cache_sample(&cache, &sphere_sdf, &key, &x, false, &sample);
+    corner_cache_statistics(&cache, &statistics);
+    TEST_ASSERT(statistics.misses == 1, "corners of another sdf should not be shared");
+
+    corner_cache_destroy(&cache);
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_CORNER_H
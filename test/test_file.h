@@ -0,0 +1,36 @@
+#ifndef SERAPHIM_TEST_FILE_H
+#define SERAPHIM_TEST_FILE_H
+
+#include "test_header.h"
+
+#include "../common/file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern inline const char * test_file_save_ppm(){
+    const char * filename = "test_image.ppm";
+    const uint8_t rgba[2 * 2 * 4] = {
+        1, 2, 3, 255,    4, 5, 6, 255,
+        7, 8, 9, 255,    10, 11, 12, 255,
+    };
+    const char header[] = "P6\n2 2\n255\n";
+    const uint8_t rgb[2 * 2 * 3] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+
+    TEST_ASSERT(file_save_ppm(filename, 2, 2, rgba), "image should be saved");
+
+    size_t size;
+    uint8_t * bytes = file_load_binary(filename, &size);
+    remove(filename);
+
+    TEST_ASSERT(bytes != NULL && size == strlen(header) + sizeof(rgb), "image should have a header and three bytes a pixel");
+    bool is_equal = memcmp(bytes, header, strlen(header)) == 0 &&
+                    memcmp(bytes + strlen(header), rgb, sizeof(rgb)) == 0;
+    free(bytes);
+    TEST_ASSERT(is_equal, "pixels should be saved in rows without their alpha");
+
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_FILE_H
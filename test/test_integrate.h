@@ -0,0 +1,61 @@
+#ifndef SERAPHIM_TEST_INTEGRATE_H
+#define SERAPHIM_TEST_INTEGRATE_H
+
+#include "test_header.h"
+
+#include "../backend/integrate.h"
+#include "../backend/platonic.h"
+#include "../backend/primitive.h"
+#include "../common/constant.h"
+
+extern inline const char * test_integrate_uniform_cube(){
+    vec3 cube_size = {{0.5, 0.5, 0.5}};
+    sdf_t cube_sdf;
+    sdf_create(0, &cube_sdf, sdf_cuboid, &cube_size);
+
+    mass_properties_t properties;
+    integrate_mass_properties(&cube_sdf, sdf_bound(&cube_sdf), 0.001, &properties);
+
+    double tolerance = 0.01;
+    TEST_ASSERT(fabs(properties.volume - 1.0) < tolerance, "incorrect cube volume");
+    TEST_ASSERT(vec3_length(&properties.com) < tolerance, "cube centre of mass should be at origin");
+
+    for (int j = 0; j < 9; j++){
+        if (j / 3 == j % 3){
+            TEST_ASSERT(
+                fabs(properties.inertia_tensor.v[j] - 1.0 / 6.0) < tolerance,
+                "incorrect diagonal elements to inertia tensor"
+            );
+        } else {
+            TEST_ASSERT(
+                fabs(properties.inertia_tensor.v[j]) < tolerance,
+                "non-diagonal elements of cube inertia tensor should be zero"
+            );
+        }
+    }
+
+    return TEST_SUCCESS;
+}
+
+extern inline const char * test_integrate_offset_sphere(){
+    double r = 1.0;
+    sdf_t sphere_sdf;
+    sdf_create(0, &sphere_sdf, sdf_sphere, &r);
+
+    bound3_t bound = {
+        .lower = {{-1.0, -1.0, -1.0}},
+        .upper = {{ 3.0,  3.0,  3.0}},
+    };
+
+    mass_properties_t properties;
+    integrate_mass_properties(&sphere_sdf, &bound, 0.001, &properties);
+
+    double expected_volume = 4.0 / 3.0 * pi * r * r * r;
+    TEST_ASSERT(fabs(properties.volume - expected_volume) < expected_volume * 0.01, "incorrect sphere volume");
+    TEST_ASSERT(vec3_length(&properties.com) < 0.01, "sphere centre of mass should be at origin");
+    TEST_ASSERT(fabs(properties.inertia_tensor.v[0] - 0.4 * r * r) < 0.01, "incorrect sphere inertia tensor");
+
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_INTEGRATE_H
@@ -0,0 +1,84 @@
+#ifndef SERAPHIM_TEST_INTERVAL_H
+#define SERAPHIM_TEST_INTERVAL_H
+
+#include "test_header.h"
+
+#include "../backend/platonic.h"
+#include "../backend/primitive.h"
+
+// checks that the distance at every sampled point of each box lies within the
+// interval found for that box
+static inline bool interval_contains_samples(sdf_t *sdf){
+    for (int i = 0; i < 100; i++){
+        bound3_t box;
+        for (int axis = 0; axis < 3; axis++){
+            double a = 4.0 * ((i * 37 + axis * 11) % 17) / 17.0 - 2.0;
+            double w = 0.05 + ((i * 13 + axis * 7) % 11) / 11.0;
+            box.lower.v[axis] = a;
+            box.upper.v[axis] = a + w;
+        }
+
+        interval_t phi;
+        sdf_distance_interval(sdf, &box, &phi);
+
+        for (int j = 0; j < 27; j++){
+            vec3 x;
+            for (int axis = 0; axis < 3; axis++){
+                double t = ((j / (axis == 0 ? 1 : axis == 1 ? 3 : 9)) % 3) / 2.0;
+                x.v[axis] = box.lower.v[axis] + t * (box.upper.v[axis] - box.lower.v[axis]);
+            }
+
+            double p = sdf_distance(sdf, &x);
+            if (p < phi.lower - 1e-9 || p > phi.upper + 1e-9){
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+extern inline const char * test_interval_primitives(){
+    double sphere_radius = 1.0;
+    double torus_radii[2] = {1.0, 0.25};
+    vec3 cube_size = {{0.5, 1.0, 0.25}};
+    double octahedron_size = 1.0;
+
+    sdf_t sdfs[4];
+    sdf_create(0, &sdfs[0], sdf_sphere, &sphere_radius);
+    sdf_create(1, &sdfs[1], sdf_torus, torus_radii);
+    sdf_create(2, &sdfs[2], sdf_cuboid, &cube_size);
+    sdf_create(3, &sdfs[3], sdf_octahedron, &octahedron_size);
+
+    for (int i = 0; i < 4; i++){
+        TEST_ASSERT(interval_contains_samples(&sdfs[i]), "distance outside of interval bound");
+    }
+
+    return TEST_SUCCESS;
+}
+
+extern inline const char * test_interval_classify(){
+    vec3 cube_size = {{1.0, 1.0, 1.0}};
+    sdf_t cube_sdf;
+    sdf_create(0, &cube_sdf, sdf_cuboid, &cube_size);
+
+    bound3_t inside = {
+        .lower = {{-0.5, -0.5, -0.5}},
+        .upper = {{ 0.5,  0.5,  0.5}},
+    };
+    bound3_t outside = {
+        .lower = {{1.5, -0.5, -0.5}},
+        .upper = {{2.5,  0.5,  0.5}},
+    };
+
+    interval_t phi;
+    sdf_distance_interval(&cube_sdf, &inside, &phi);
+    TEST_ASSERT(interval_is_non_positive(&phi), "box should be classified as inside");
+
+    sdf_distance_interval(&cube_sdf, &outside, &phi);
+    TEST_ASSERT(interval_is_positive(&phi), "box should be classified as outside");
+
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_INTERVAL_H
@@ -10,6 +10,24 @@
 #include "test_array.h"
 #include "test_matter.h"
 #include "test_bound3.h"
+#include "test_integrate.h"
+#include "test_interval.h"
+#include "test_sdf.h"
+#include "test_mesh.h"
+#include "test_tracker.h"
+#include "test_schedule.h"
+#include "test_ring.h"
+#include "test_cache.h"
+#include "test_corner.h"
+#include "test_prefetch.h"
+#include "test_capture.h"
+#include "test_store.h"
+#include "test_region.h"
+#include "test_file.h"
+#include "test_reference.h"
+#include "test_substances.h"
+#include "test_binning.h"
+#include "test_bvh.h"
 
 int main(){
     int passed_tests = 0;
@@ -44,6 +62,38 @@ int main(){
 
     RUN_TEST(test_bound3_intersection);
 
+    RUN_TEST(test_integrate_uniform_cube);
+    RUN_TEST(test_integrate_offset_sphere);
+
+    RUN_TEST(test_interval_primitives);
+    RUN_TEST(test_interval_classify);
+
+    RUN_TEST(test_sdf_bound_primitive);
+    RUN_TEST(test_sdf_bound_search);
+    RUN_TEST(test_sdf_raycast_packet);
+
+    RUN_TEST(test_mesh_distance);
+    RUN_TEST(test_mesh_sdf_cache);
+
+    RUN_TEST(test_tracker_drops_duplicates);
+    RUN_TEST(test_schedule_priority);
+    RUN_TEST(test_schedule_age);
+    RUN_TEST(test_schedule_speculative_expiry);
+    RUN_TEST(test_ring_handoff);
+    RUN_TEST(test_cache_eviction);
+    RUN_TEST(test_corner_cache_reuse);
+    RUN_TEST(test_prefetch_predicts_visible_cells);
+    RUN_TEST(test_capture_round_trip);
+    RUN_TEST(test_store_persists);
+    RUN_TEST(test_store_invalidated_by_sdf);
+    RUN_TEST(test_region_coalesce);
+    RUN_TEST(test_file_save_ppm);
+    RUN_TEST(test_reference_converges);
+    RUN_TEST(test_reference_bvh_matches_list);
+    RUN_TEST(test_substance_list_writes_changes);
+    RUN_TEST(test_binning_covers_projection);
+    RUN_TEST(test_bvh_refits_moving_substances);
+
     printf("Total tests run: %d\n", total_tests);
     printf("Total tests passed: %d\n", passed_tests);
     printf("Test pass rate: %.2f%%\n", (double) passed_tests * 100.0 / (double) total_tests);
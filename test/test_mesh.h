@@ -0,0 +1,114 @@
+#ifndef SERAPHIM_TEST_MESH_H
+#define SERAPHIM_TEST_MESH_H
+
+#include "test_header.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <filesystem>
+#include <string>
+
+#include "../backend/mesh.h"
+
+// creates a directory of its own for a test's files, which are removed with it
+static inline bool test_mesh_create_directory(std::string *directory){
+    std::error_code error;
+    std::filesystem::path temporary = std::filesystem::temp_directory_path(error);
+    if (error){
+        return false;
+    }
+
+    *directory = (temporary / "seraphim_test_XXXXXX").string();
+    return mkdtemp(directory->data()) != NULL;
+}
+
+static inline void test_mesh_remove_directory(const std::string &directory){
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+}
+
+static inline bool test_mesh_write_cube(const char * filename){
+    FILE * file = fopen(filename, "w");
+    if (file == NULL){
+        return false;
+    }
+
+    for (int i = 0; i < 8; i++){
+        fprintf(file, "v %f %f %f\n", (i & 1) - 0.5, ((i >> 1) & 1) - 0.5, ((i >> 2) & 1) - 0.5);
+    }
+
+    fprintf(file,
+        "f 1 3 4 2\n"
+        "f 5 6 8 7\n"
+        "f 1 2 6 5\n"
+        "f 3 7 8 4\n"
+        "f 1 5 7 3\n"
+        "f 2 4 8 6\n"
+    );
+    fclose(file);
+    return true;
+}
+
+extern inline const char * test_mesh_distance(){
+    std::string directory;
+    TEST_ASSERT(test_mesh_create_directory(&directory), "failed to create directory");
+    std::string filename = directory + "/cube.obj";
+
+    bool is_written = test_mesh_write_cube(filename.c_str());
+    mesh_t mesh;
+    bool is_loaded = is_written && mesh_load(&mesh, filename.c_str());
+    test_mesh_remove_directory(directory);
+    TEST_ASSERT(is_written, "failed to write mesh");
+    TEST_ASSERT(is_loaded, "failed to load mesh");
+    TEST_ASSERT(mesh.triangles.size == 12, "quads should be split into two triangles");
+
+    vec3 centre = {{0.0, 0.0, 0.0}};
+    vec3 face = {{1.0, 0.1, 0.0}};
+    vec3 corner = {{1.0, 1.0, 1.0}};
+    TEST_ASSERT(fabs(mesh_distance(&mesh, &centre) + 0.5) < 1e-9, "incorrect distance inside mesh");
+    TEST_ASSERT(fabs(mesh_distance(&mesh, &face) - 0.5) < 1e-9, "incorrect distance outside face");
+    TEST_ASSERT(fabs(mesh_distance(&mesh, &corner) - sqrt(0.75)) < 1e-9, "incorrect distance outside corner");
+
+    mesh_destroy(&mesh);
+    return TEST_SUCCESS;
+}
+
+extern inline const char * test_mesh_sdf_cache(){
+    // the cache starts empty, so the first grid is generated and the second
+    // loaded from the cache
+    std::string directory;
+    TEST_ASSERT(test_mesh_create_directory(&directory), "failed to create directory");
+    std::string filename = directory + "/cube.obj";
+    std::string cache_directory = directory + "/cache";
+
+    bool is_written = test_mesh_write_cube(filename.c_str());
+    mesh_sdf_t generated, cached, degenerate;
+    bool is_generated = is_written && mesh_sdf_create(&generated, filename.c_str(), 16, cache_directory.c_str());
+    bool is_cached = is_generated && mesh_sdf_create(&cached, filename.c_str(), 16, cache_directory.c_str());
+    bool is_degenerate = mesh_sdf_create(&degenerate, filename.c_str(), 1, cache_directory.c_str());
+
+    std::error_code error;
+    bool is_saved = !std::filesystem::is_empty(cache_directory, error);
+    mesh_sdf_remove_cache(filename.c_str(), 16, cache_directory.c_str());
+    bool is_removed = std::filesystem::is_empty(cache_directory, error);
+    test_mesh_remove_directory(directory);
+    TEST_ASSERT(is_written, "failed to write mesh");
+    TEST_ASSERT(is_generated && is_cached, "failed to create mesh sdf");
+    TEST_ASSERT(is_saved && is_removed, "grid should be cached until its cache is removed");
+    TEST_ASSERT(!is_degenerate, "a grid of one sample should not be created");
+
+    vec3 xs[2] = {{{0.1, 0.2, 0.0}}, {{0.0, 0.8, 0.1}}};
+    double expected[2] = {-0.3, 0.3};
+    for (int i = 0; i < 2; i++){
+        double phi = mesh_sdf_distance(&generated, &xs[i]);
+        TEST_ASSERT(fabs(phi - expected[i]) < 0.05, "incorrect mesh sdf distance");
+        TEST_ASSERT(phi == mesh_sdf_distance(&cached, &xs[i]), "cached mesh sdf should match");
+    }
+
+    mesh_sdf_destroy(&generated);
+    mesh_sdf_destroy(&cached);
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_MESH_H
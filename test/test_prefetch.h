@@ -0,0 +1,60 @@
+#ifndef SERAPHIM_TEST_PREFETCH_H
+#define SERAPHIM_TEST_PREFETCH_H
+
+#include "test_header.h"
+
+#include "../backend/primitive.h"
+#include "../frontend/prefetch.h"
+
+extern inline const char * test_prefetch_predicts_visible_cells(){
+    double r = 1.0;
+    sdf_t sphere_sdf;
+    sdf_create(0, &sphere_sdf, sdf_sphere, &r);
+
+    prefetch_view_t view = {};
+    view.camera.position = {{0.0, 0.0, -5.0}};
+    view.camera.rotation = quat_identity;
+    view.velocity = {{0.0, 0.0, 1.0}};
+    view.lookahead = 1.0;
+    view.focal_depth = 1.0f;
+    view.aspect_ratio = 1.0f;
+    view.number_of_substances = 1;
+    view.substances[0] = {
+        .sdf = &sphere_sdf,
+        .sdf_id = 0,
+        .material_id = 0,
+        .transform = { .position = vec3_zero, .rotation = quat_identity },
+    };
+
+    request_prefetcher_t prefetcher;
+    request_prefetcher_create(&prefetcher);
+
+    request_t requests[SERAPHIM_PREFETCH_MAX_REQUESTS];
+    size_t count = request_prefetcher_predict(&prefetcher, &view, requests, SERAPHIM_PREFETCH_MAX_REQUESTS);
+    TEST_ASSERT(count > 0, "cells of the sphere ahead should be predicted");
+
+    for (size_t i = 0; i < count; i++){
+        vec3 x = {{requests[i].position.x, requests[i].position.y, requests[i].position.z}};
+        TEST_ASSERT(fabs(vec3_length(&x) - 1.0) < 4.0 * requests[i].radius, "predicted cells should be on the surface");
+    }
+
+    prefetch_statistics_t statistics;
+    request_prefetcher_statistics(&prefetcher, &statistics);
+    TEST_ASSERT(statistics.hits == 0, "nothing should have been predicted before the first frame");
+
+    // the camera arrives where it was predicted to be
+    view.camera.position = {{0.0, 0.0, -4.0}};
+    request_prefetcher_predict(&prefetcher, &view, requests, SERAPHIM_PREFETCH_MAX_REQUESTS);
+    request_prefetcher_statistics(&prefetcher, &statistics);
+    TEST_ASSERT(statistics.sampled > 0 && statistics.hits == statistics.sampled,
+                "visible cells should have been predicted");
+
+    // nothing is predicted while the camera is still
+    view.velocity = vec3_zero;
+    TEST_ASSERT(request_prefetcher_predict(&prefetcher, &view, requests, SERAPHIM_PREFETCH_MAX_REQUESTS) == 0,
+                "still camera should not prefetch");
+
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_PREFETCH_H
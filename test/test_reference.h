@@ -0,0 +1,203 @@
+#ifndef SERAPHIM_TEST_REFERENCE_H
+#define SERAPHIM_TEST_REFERENCE_H
+
+#include "test_header.h"
+
+#include "../backend/primitive.h"
+#include "../frontend/reference.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+extern inline const char * test_reference_converges(){
+    double r = 1.0;
+    sdf_t sdfs[1];
+    uint32_t num_sdfs = 1;
+    sdf_create(0, &sdfs[0], sdf_sphere, &r);
+
+    vec3 colour = {{0.8, 0.2, 0.2}};
+    material_t materials[1];
+    uint32_t num_materials = 1;
+    material_create(&materials[0], 0, &colour);
+
+    generator_t generator;
+    generator_create(&generator, sdfs, &num_sdfs, materials, &num_materials);
+
+    substance_data_t substance = {
+        .near = 4.0f,
+        .far = 6.0f,
+        .sdf_id = 0,
+        .material_id = 0,
+        .r = {{1.0f, 1.0f, 1.0f}},
+        .id = 0,
+    };
+    for (int i = 0; i < MAT4_SIZE; i++){
+        substance.transform[i] = (float) mat4_identity.v[i];
+        substance.inverse_transform[i] = (float) mat4_identity.v[i];
+    }
+
+    light_t light;
+    light_create_scene(&light);
+
+    reference_view_t view = {};
+    for (int i = 0; i < MAT4_SIZE; i++){
+        view.eye_transform[i] = (float) mat4_identity.v[i];
+    }
+    view.eye_transform[14] = -5.0f;
+    view.focal_depth = 1.0f;
+    view.render_distance = 100.0f;
+    view.epsilon = 1.0f / 300.0f;
+    view.substances = &substance;
+    view.number_of_substances = 1;
+    view.lights = &light;
+    view.number_of_lights = 1;
+
+    reference_renderer_t reference;
+    reference_renderer_create(&reference, &generator, {{2u, 2u}}, 2, 65536, 65536);
+
+    size_t first = reference_renderer_render(&reference, &view);
+    TEST_ASSERT(first > 0, "the first frame should request the patches it sees");
+
+    size_t requests = first;
+    for (int frame = 0; frame < 64 && requests > 0; frame++){
+        requests = reference_renderer_render(&reference, &view);
+    }
+    TEST_ASSERT(requests == 0, "a still view should converge");
+
+    reference_statistics_t statistics;
+    reference_renderer_statistics(&reference, &statistics);
+    TEST_ASSERT(statistics.patch_misses > 0 && statistics.patch_shared_hits + statistics.patch_pool_hits > 0,
+                "patches should be missed then found");
+
+    // once converged, every lookup is a hit
+    reference_renderer_render(&reference, &view);
+    reference_renderer_statistics(&reference, &statistics);
+    TEST_ASSERT(statistics.patch_misses == 0 && statistics.texture_misses == 0,
+                "a converged view should find everything it looks up");
+
+    uint8_t * centre = &reference.image[4 * (32 * reference.image_size.x + 32)];
+    uint8_t * corner = &reference.image[0];
+    TEST_ASSERT(centre[0] > centre[2], "the sphere should be drawn in its colour");
+    TEST_ASSERT(corner[2] > corner[0], "the sky should be drawn around the sphere");
+
+    reference_renderer_destroy(&reference);
+    generator_destroy(&generator);
+    return TEST_SUCCESS;
+}
+
+// tiles that see more substances than fit in shared memory find them from the
+// bvh, which should draw just what stepping through each of them draws
+extern inline const char * test_reference_bvh_matches_list(){
+    double r = 1.0;
+    sdf_t sdfs[1];
+    uint32_t num_sdfs = 1;
+    sdf_create(0, &sdfs[0], sdf_sphere, &r);
+
+    vec3 colour = {{0.8, 0.2, 0.2}};
+    material_t materials[1];
+    uint32_t num_materials = 1;
+    material_create(&materials[0], 0, &colour);
+
+    generator_t generator;
+    generator_create(&generator, sdfs, &num_sdfs, materials, &num_materials);
+
+    // layers of spheres across the view, each layer shifted so that the
+    // spheres behind show between those in front
+    const uint32_t side = 6;
+    const uint32_t layers = 4;
+    const uint32_t n = side * side * layers;
+    float eye_z = -5.0f;
+    std::vector<substance_data_t> substances(n);
+    for (uint32_t s = 0; s < n; s++){
+        substance_data_t * substance = &substances[s];
+        *substance = {};
+        for (int i = 0; i < MAT4_SIZE; i++){
+            substance->transform[i] = (float) mat4_identity.v[i];
+            substance->inverse_transform[i] = (float) mat4_identity.v[i];
+        }
+
+        uint32_t layer = s / (side * side);
+        float x[3] = {
+            3.0f * (s % side) - 7.5f + 0.75f * layer,
+            3.0f * (s / side % side) - 7.5f + 0.75f * layer,
+            10.0f + 5.0f * layer,
+        };
+
+        float near = 0.0f;
+        float far = 0.0f;
+        for (int a = 0; a < 3; a++){
+            substance->transform[12 + a] = x[a];
+            substance->inverse_transform[12 + a] = -x[a];
+
+            float d = fabsf(a == 2 ? x[a] - eye_z : x[a]);
+            near += fmaxf(d - 1.0f, 0.0f) * fmaxf(d - 1.0f, 0.0f);
+            far += (d + 1.0f) * (d + 1.0f);
+        }
+        substance->r = {{1.0f, 1.0f, 1.0f}};
+        substance->near = sqrtf(near);
+        substance->far = sqrtf(far);
+        substance->id = s;
+    }
+
+    // as the renderer sorts them
+    std::sort(substances.begin(), substances.end(),
+              [](const substance_data_t &a, const substance_data_t &b){ return a.far < b.far; });
+
+    light_t light;
+    light_create_scene(&light);
+
+    reference_view_t view = {};
+    for (int i = 0; i < MAT4_SIZE; i++){
+        view.eye_transform[i] = (float) mat4_identity.v[i];
+    }
+    view.eye_transform[14] = eye_z;
+    view.focal_depth = 1.0f;
+    view.render_distance = 100.0f;
+    view.epsilon = 1.0f / 300.0f;
+    view.substances = substances.data();
+    view.number_of_substances = n;
+    view.lights = &light;
+    view.number_of_lights = 1;
+
+    reference_renderer_t list;
+    reference_renderer_t bvh;
+    reference_renderer_create(&list, &generator, {{2u, 2u}}, 2, 65536, 65536);
+    reference_renderer_create(&bvh, &generator, {{2u, 2u}}, 2, 65536, 65536);
+    list.max_listed_substances = n;
+
+    size_t requests = 1;
+    for (int frame = 0; frame < 64 && requests > 0; frame++){
+        requests = reference_renderer_render(&list, &view);
+        requests += reference_renderer_render(&bvh, &view);
+    }
+    TEST_ASSERT(requests == 0, "both views should converge");
+
+    for (uint32_t t = 0; t < 4; t++){
+        TEST_ASSERT(bvh.bins.data[t + 1] - bvh.bins.data[t] > SERAPHIM_REFERENCE_TILE_SIZE,
+                    "every tile should see more substances than fit in shared memory");
+
+        // some of the tile's pixels are drawn in the spheres' colour
+        uint32_t drawn = 0;
+        for (uint32_t j = 0; j < SERAPHIM_REFERENCE_TILE_SIZE; j++){
+            for (uint32_t i = 0; i < SERAPHIM_REFERENCE_TILE_SIZE; i++){
+                uint32_t x = (t % 2) * SERAPHIM_REFERENCE_TILE_SIZE + i;
+                uint32_t y = (t / 2) * SERAPHIM_REFERENCE_TILE_SIZE + j;
+                uint8_t * pixel = &bvh.image[4 * (y * bvh.image_size.x + x)];
+                drawn += pixel[0] > pixel[2];
+            }
+        }
+        TEST_ASSERT(drawn > 0, "every tile should draw some of the spheres");
+    }
+
+    size_t size = 4 * list.image_size.x * list.image_size.y;
+    TEST_ASSERT(memcmp(list.image, bvh.image, size) == 0, "the bvh should draw what the list draws");
+
+    reference_renderer_destroy(&list);
+    reference_renderer_destroy(&bvh);
+    generator_destroy(&generator);
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_REFERENCE_H
@@ -0,0 +1,53 @@
+#ifndef SERAPHIM_TEST_REGION_H
+#define SERAPHIM_TEST_REGION_H
+
+#include "test_header.h"
+
+#include "../frontend/region.h"
+
+extern inline const char * test_region_coalesce(){
+    // slot 2 is written twice, slots 0 and 1 follow on from one another in
+    // both buffers, and the last region partly covers an earlier one
+    buffer_region_t regions[5] = {
+        { 0, 32, 16 },
+        { 16, 0, 16 },
+        { 32, 16, 16 },
+        { 64, 32, 16 },
+        { 80, 72, 16 },
+    };
+    buffer_region_t covered = { 96, 64, 16 };
+
+    std::vector<buffer_region_t> coalesced;
+    buffer_regions_coalesce(regions, 5, &coalesced);
+    TEST_ASSERT(coalesced.size() == 3, "regions should be joined and duplicates dropped");
+    TEST_ASSERT(coalesced[0].source == 16 && coalesced[0].destination == 0 && coalesced[0].size == 32,
+                "neighbouring regions should be joined");
+    TEST_ASSERT(coalesced[1].source == 64 && coalesced[1].destination == 32,
+                "the last write to a slot should be copied");
+
+    buffer_region_t overlapping[2] = { regions[4], covered };
+    buffer_regions_coalesce(overlapping, 2, &coalesced);
+    TEST_ASSERT(coalesced.size() == 2, "overlapped region should be cut short");
+    TEST_ASSERT(coalesced[0].destination == 64 && coalesced[0].size == 16 && coalesced[0].source == 96,
+                "later region should be copied whole");
+    TEST_ASSERT(coalesced[1].destination == 80 && coalesced[1].size == 8 && coalesced[1].source == 88,
+                "earlier region should keep only its uncovered part");
+
+    // writes to distinct slots, out of order, are sorted and joined without
+    // being cut
+    buffer_region_t distinct[3] = {
+        { 48, 48, 16 },
+        { 0, 0, 16 },
+        { 16, 16, 16 },
+    };
+    buffer_regions_coalesce(distinct, 3, &coalesced);
+    TEST_ASSERT(coalesced.size() == 2, "only neighbouring regions should be joined");
+    TEST_ASSERT(coalesced[0].destination == 0 && coalesced[0].size == 32 && coalesced[0].source == 0,
+                "regions written out of order should still be joined");
+    TEST_ASSERT(coalesced[1].destination == 48 && coalesced[1].size == 16,
+                "regions that do not follow on should be kept apart");
+
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_REGION_H
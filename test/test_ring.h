@@ -0,0 +1,38 @@
+#ifndef SERAPHIM_TEST_RING_H
+#define SERAPHIM_TEST_RING_H
+
+#include "test_header.h"
+
+#include "../frontend/ring.h"
+
+extern inline const char * test_ring_handoff(){
+    request_ring_t ring;
+    request_ring_create(&ring, 16);
+
+    uint32_t count;
+    TEST_ASSERT(request_ring_peek(&ring, &count) == NULL, "new ring should be empty");
+
+    for (uint32_t i = 0; i < SERAPHIM_RING_SIZE; i++){
+        request_t * batch = request_ring_acquire(&ring);
+        TEST_ASSERT(batch != NULL, "ring should have a free batch");
+        batch[0].hash = i;
+        request_ring_publish(&ring, i + 1);
+    }
+
+    TEST_ASSERT(request_ring_acquire(&ring) == NULL, "full ring should refuse a batch");
+
+    for (uint32_t i = 0; i < SERAPHIM_RING_SIZE; i++){
+        request_t * batch = request_ring_peek(&ring, &count);
+        TEST_ASSERT(batch != NULL && batch[0].hash == i, "batches should be taken in order");
+        TEST_ASSERT(count == i + 1, "batch should keep its count");
+        request_ring_release(&ring);
+    }
+
+    TEST_ASSERT(request_ring_peek(&ring, &count) == NULL, "drained ring should be empty");
+    TEST_ASSERT(request_ring_acquire(&ring) != NULL, "drained ring should have a free batch");
+
+    request_ring_destroy(&ring);
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_RING_H
@@ -0,0 +1,104 @@
+#ifndef SERAPHIM_TEST_SCHEDULE_H
+#define SERAPHIM_TEST_SCHEDULE_H
+
+#include "test_header.h"
+
+#include "../frontend/schedule.h"
+
+static inline request_t test_schedule_request(uint32_t status, float radius, uint32_t hash){
+    request_t request = {};
+    request.status = status;
+    request.radius = radius;
+    request.hash = hash;
+    return request;
+}
+
+extern inline const char * test_schedule_priority(){
+    request_schedule_t schedule;
+    request_schedule_create(&schedule, 2);
+
+    request_t fine = test_schedule_request(geometry_request, 0.125f, 1);
+    request_t coarse = test_schedule_request(geometry_request, 1.0f, 2);
+    request_t texture = test_schedule_request(texture_request, 1.0f, 3);
+    request_schedule_push(&schedule, &texture);
+    request_schedule_push(&schedule, &fine);
+    request_schedule_push(&schedule, &coarse);
+
+    request_t popped;
+    uint32_t status;
+    TEST_ASSERT(request_schedule_pop(&schedule, &popped, 1, &status) == 1, "schedule should not be empty");
+    TEST_ASSERT(status == geometry_request && popped.hash == 2, "coarse geometry should be handled first");
+
+    // each of the two workers has a budget
+    request_schedule_spend(&schedule, geometry_request, SERAPHIM_SCHEDULE_GEOMETRY_BUDGET);
+    TEST_ASSERT(request_schedule_pop(&schedule, &popped, 1, &status) == 1, "schedule should not be empty");
+    TEST_ASSERT(status == geometry_request && popped.hash == 1, "one worker's time should leave budget for the other");
+    request_schedule_push(&schedule, &fine);
+
+    request_schedule_spend(&schedule, geometry_request, SERAPHIM_SCHEDULE_GEOMETRY_BUDGET);
+    TEST_ASSERT(request_schedule_pop(&schedule, &popped, 1, &status) == 1, "schedule should not be empty");
+    TEST_ASSERT(status == texture_request, "geometry should wait once its budget is spent");
+
+    request_schedule_advance(&schedule, NULL);
+    TEST_ASSERT(request_schedule_pop(&schedule, &popped, 1, &status) == 1, "schedule should not be empty");
+    TEST_ASSERT(popped.hash == 1, "budget should be renewed each frame");
+
+    request_schedule_destroy(&schedule);
+    return TEST_SUCCESS;
+}
+
+extern inline const char * test_schedule_age(){
+    request_schedule_t schedule;
+    request_schedule_create(&schedule, 1);
+
+    request_t old = test_schedule_request(geometry_request, 0.5f, 1);
+    request_schedule_push(&schedule, &old);
+
+    for (int i = 0; i < 2 * SERAPHIM_SCHEDULE_FRAMES_PER_LEVEL; i++){
+        request_schedule_advance(&schedule, NULL);
+    }
+
+    request_t young = test_schedule_request(geometry_request, 1.0f, 2);
+    request_schedule_push(&schedule, &young);
+
+    request_t popped;
+    uint32_t status;
+    request_schedule_pop(&schedule, &popped, 1, &status);
+    TEST_ASSERT(popped.hash == 1, "old requests should overtake coarser new ones");
+
+    request_schedule_destroy(&schedule);
+    return TEST_SUCCESS;
+}
+
+extern inline const char * test_schedule_speculative_expiry(){
+    request_schedule_t schedule;
+    request_schedule_create(&schedule, 1);
+
+    request_t speculative = test_schedule_request(geometry_request, 4.0f, 1);
+    request_schedule_push_speculative(&schedule, &speculative, 2);
+
+    std::vector<request_t> expired;
+    request_schedule_advance(&schedule, &expired);
+    request_schedule_advance(&schedule, &expired);
+    TEST_ASSERT(expired.empty(), "speculative requests should wait for the frames they were given");
+
+    request_schedule_advance(&schedule, &expired);
+    TEST_ASSERT(expired.size() == 1 && expired[0].hash == 1, "expired speculative requests should be dropped");
+    TEST_ASSERT(schedule.size == 0 && schedule.speculative == 0, "nothing should be left waiting");
+
+    // speculative requests can't fill the queue
+    for (uint32_t i = 0; i < SERAPHIM_SCHEDULE_MAX_SPECULATIVE; i++){
+        request_t request = test_schedule_request(geometry_request, 1.0f, i);
+        request_schedule_push_speculative(&schedule, &request, 2);
+    }
+    TEST_ASSERT(!request_schedule_push_speculative(&schedule, &speculative, 2),
+                "speculative requests should be capped");
+
+    request_t demand = test_schedule_request(geometry_request, 0.125f, 2);
+    TEST_ASSERT(request_schedule_push(&schedule, &demand), "demand requests should still be queued");
+
+    request_schedule_destroy(&schedule);
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_SCHEDULE_H
@@ -0,0 +1,81 @@
+#ifndef SERAPHIM_TEST_SDF_H
+#define SERAPHIM_TEST_SDF_H
+
+#include "test_header.h"
+
+#include "../backend/platonic.h"
+#include "../backend/primitive.h"
+#include "../common/constant.h"
+
+static inline double test_sdf_offset_sphere(void *data, const vec3 *x){
+    vec3 y = *x;
+    y.x -= 3.0;
+    return sdf_sphere(data, &y);
+}
+
+extern inline const char * test_sdf_bound_primitive(){
+    double torus_radii[2] = {1.0, 0.25};
+    sdf_t torus_sdf;
+    sdf_create(0, &torus_sdf, sdf_torus, torus_radii);
+
+    bound3_t *bound = sdf_bound(&torus_sdf);
+    TEST_ASSERT(fabs(bound->upper.x - 1.25) < 1e-9, "incorrect torus bound");
+    TEST_ASSERT(fabs(bound->upper.y - 0.25) < 1e-9, "incorrect torus bound");
+    TEST_ASSERT(fabs(bound->lower.z + 1.25) < 1e-9, "incorrect torus bound");
+    TEST_ASSERT(fabs(sdf_bounding_sphere(&torus_sdf)->r - 1.25) < 1e-9, "incorrect torus bounding sphere");
+
+    return TEST_SUCCESS;
+}
+
+extern inline const char * test_sdf_bound_search(){
+    double r = 1.0;
+    sdf_t sphere_sdf;
+    sdf_create(0, &sphere_sdf, test_sdf_offset_sphere, &r);
+
+    bound3_t *bound = sdf_bound(&sphere_sdf);
+    vec3 lower = {{2.0, -1.0, -1.0}};
+    vec3 upper = {{4.0,  1.0,  1.0}};
+    for (int i = 0; i < 3; i++){
+        TEST_ASSERT(bound->lower.v[i] <= lower.v[i], "bound should contain the sdf");
+        TEST_ASSERT(bound->upper.v[i] >= upper.v[i], "bound should contain the sdf");
+        TEST_ASSERT(lower.v[i] - bound->lower.v[i] < 0.01, "bound is not tight");
+        TEST_ASSERT(bound->upper.v[i] - upper.v[i] < 0.01, "bound is not tight");
+    }
+
+    return TEST_SUCCESS;
+}
+
+extern inline const char * test_sdf_raycast_packet(){
+    double torus_radii[2] = {1.0, 0.25};
+    sdf_t torus_sdf;
+    sdf_create(0, &torus_sdf, sdf_torus, torus_radii);
+
+    ray_t rays[SERAPHIM_SDF_PACKET_SIZE];
+    for (int i = 0; i < SERAPHIM_SDF_PACKET_SIZE; i++){
+        rays[i].position = {{-0.5 * i, 0.1, -5.0}};
+        rays[i].direction = {{0.0, 0.0, 1.0}};
+    }
+
+    intersection_t intersections[SERAPHIM_SDF_PACKET_SIZE];
+    sdf_raycast_packet(&torus_sdf, rays, SERAPHIM_SDF_PACKET_SIZE, intersections);
+
+    for (int i = 0; i < SERAPHIM_SDF_PACKET_SIZE; i++){
+        intersection_t intersection;
+        sdf_raycast(&torus_sdf, &rays[i], &intersection);
+
+        TEST_ASSERT(intersection.position.z == intersections[i].position.z, "packet and single raycasts should agree");
+        TEST_ASSERT(intersection.distance == intersections[i].distance, "packet and single raycasts should agree");
+    }
+
+    // outer edge of the tube at this height, where the ray enters the torus
+    double tube = 1.0 + sqrt(0.25 * 0.25 - 0.1 * 0.1);
+    vec3 hit = {{-1.0, 0.1, -sqrt(tube * tube - 1.0)}};
+    TEST_ASSERT(intersections[0].distance > 0.0, "ray through the hole should miss");
+    TEST_ASSERT(intersections[2].distance < epsilon, "ray should hit the torus");
+    TEST_ASSERT(fabs(intersections[2].position.z - hit.z) < 0.01, "incorrect intersection position");
+    TEST_ASSERT(intersections[2].normal.z < 0.0, "normal should face the ray");
+
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_SDF_H
@@ -0,0 +1,79 @@
+#ifndef SERAPHIM_TEST_STORE_H
+#define SERAPHIM_TEST_STORE_H
+
+#include "test_header.h"
+
+#include <string.h>
+
+#include "../backend/primitive.h"
+#include "../frontend/generator.h"
+#include "../frontend/store.h"
+
+extern inline const char * test_store_persists(){
+    const char * filename = "test_store.bin";
+    remove(filename);
+
+    uint32_t value = 42;
+    store_t store;
+    TEST_ASSERT(store_open(&store, filename, sizeof(value), 64), "store should open");
+    TEST_ASSERT(!store_load(&store, 7, &value), "new store should be empty");
+    store_save(&store, 7, &value);
+    store_close(&store);
+
+    value = 0;
+    TEST_ASSERT(store_open(&store, filename, sizeof(value), 64), "store should open again");
+    TEST_ASSERT(store_load(&store, 7, &value) && value == 42, "value should outlive the store");
+    store_close(&store);
+
+    uint64_t wider;
+    TEST_ASSERT(store_open(&store, filename, sizeof(wider), 64), "store should open for another size");
+    TEST_ASSERT(!store_load(&store, 7, &wider), "values of another size should be discarded");
+    store_close(&store);
+
+    remove(filename);
+    return TEST_SUCCESS;
+}
+
+extern inline const char * test_store_invalidated_by_sdf(){
+    remove("test_patches.bin");
+    remove("test_textures.bin");
+
+    double r = 1.0;
+    sdf_t sdf;
+    sdf_create(0, &sdf, sdf_sphere, &r);
+    uint32_t num_sdfs = 1;
+    uint32_t num_materials = 0;
+
+    generator_t generator;
+    generator_create(&generator, &sdf, &num_sdfs, NULL, &num_materials);
+    TEST_ASSERT(generator_open_stores(&generator, "test_patches.bin", "test_textures.bin"), "stores should open");
+
+    request_t request = {};
+    request.position = {{0.5f, 0.5f, 0.5f}};
+    request.radius = 0.25f;
+    request.hash = 1234;
+    request.status = geometry_request;
+
+    patch_t generated;
+    patch_t loaded;
+    generator_geometry(&generator, &request, &generated);
+    generator_geometry(&generator, &request, &loaded);
+
+    store_statistics_t patches;
+    store_statistics_t textures;
+    generator_store_statistics(&generator, &patches, &textures);
+    TEST_ASSERT(patches.hits == 1 && patches.writes == 1, "second request should load the stored patch");
+    TEST_ASSERT(memcmp(&generated, &loaded, sizeof(patch_t)) == 0, "stored patch should match the generated one");
+
+    r = 2.0;
+    generator_geometry(&generator, &request, &loaded);
+    generator_store_statistics(&generator, &patches, &textures);
+    TEST_ASSERT(patches.hits == 0 && patches.writes == 1, "changed sdf should not load the old patch");
+
+    generator_destroy(&generator);
+    remove("test_patches.bin");
+    remove("test_textures.bin");
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_STORE_H
@@ -0,0 +1,67 @@
+#ifndef SERAPHIM_TEST_SUBSTANCES_H
+#define SERAPHIM_TEST_SUBSTANCES_H
+
+#include "test_header.h"
+
+#include "../backend/primitive.h"
+#include "../frontend/substances.h"
+
+extern inline const char * test_substance_list_writes_changes(){
+    double r = 1.0;
+    sdf_t sdf;
+    sdf_create(0, &sdf, sdf_sphere, &r);
+
+    vec3 colour = {{1.0, 1.0, 1.0}};
+    material_t material;
+    material_create(&material, 0, &colour);
+
+    form_t form;
+    substance_t substances[3];
+    matter_t matters[3];
+    for (uint32_t i = 0; i < 3; i++){
+        vec3 position = {{0.0, 0.0, 4.0 * i}};
+        matter_create(&matters[i], &sdf, &material, &position, true, false);
+        substance_create(&substances[i], &form, &matters[i], i);
+    }
+
+    substance_list_t list;
+    substance_list_create(&list, 8);
+
+    vec3 eye = vec3_zero;
+    std::vector<substance_range_t> ranges;
+    substance_list_update(&list, substances, 3, &eye, &ranges);
+    TEST_ASSERT(ranges.size() == 1 && ranges[0].first == 0 && ranges[0].number == 8,
+                "the first update should write every entry");
+    TEST_ASSERT(list.sorted[0].id == 0 && list.sorted[2].id == 2 && list.sorted[3].id == (uint32_t) ~0,
+                "entries should be sorted by far distance and followed by null entries");
+
+    substance_list_update(&list, substances, 3, &eye, &ranges);
+    TEST_ASSERT(ranges.empty(), "nothing should be written when nothing moved");
+
+    // the nearest substance moves behind the others
+    vec3 x = {{0.0, 0.0, 12.0}};
+    transform_translate(&substances[0].matter.transform, &x);
+    substances[0].version.fetch_add(1, std::memory_order_release);
+
+    substance_list_statistics_t statistics;
+    substance_list_statistics(&list, &statistics);
+    substance_list_update(&list, substances, 3, &eye, &ranges);
+    substance_list_statistics(&list, &statistics);
+    TEST_ASSERT(statistics.recalculated == 1, "only the moved substance should be recalculated");
+    TEST_ASSERT(ranges.size() == 1 && ranges[0].first == 0 && ranges[0].number == 3,
+                "only the reordered entries should be written");
+    TEST_ASSERT(list.sorted[0].id == 1 && list.sorted[2].id == 0, "the moved substance should be last");
+
+    substance_list_update(&list, substances, 2, &eye, &ranges);
+    TEST_ASSERT(ranges.size() == 1 && ranges[0].first == 1 && ranges[0].number == 2,
+                "removed substances should be overwritten by null entries");
+    TEST_ASSERT(list.sorted[2].id == (uint32_t) ~0, "the removed substance should be null");
+
+    for (uint32_t i = 0; i < 3; i++){
+        matter_destroy(&matters[i]);
+    }
+
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_SUBSTANCES_H
@@ -0,0 +1,31 @@
+#ifndef SERAPHIM_TEST_TRACKER_H
+#define SERAPHIM_TEST_TRACKER_H
+
+#include "test_header.h"
+
+#include "../frontend/tracker.h"
+
+extern inline const char * test_tracker_drops_duplicates(){
+    request_tracker_t tracker;
+    request_tracker_create(&tracker);
+
+    uint64_t geometry = request_tracker_key(1, 42);
+    uint64_t texture = request_tracker_key(2, 42);
+
+    TEST_ASSERT(request_tracker_dispatch(&tracker, geometry), "first request should be dispatched");
+    TEST_ASSERT(request_tracker_dispatch(&tracker, texture), "requests of different types should not collide");
+    TEST_ASSERT(!request_tracker_dispatch(&tracker, geometry), "request in flight should be dropped");
+
+    request_tracker_complete(&tracker, geometry);
+    request_tracker_advance(&tracker);
+    TEST_ASSERT(!request_tracker_dispatch(&tracker, geometry), "recently served request should be dropped");
+
+    for (int i = 0; i < SERAPHIM_TRACKER_SERVED_FRAMES; i++){
+        request_tracker_advance(&tracker);
+    }
+    TEST_ASSERT(request_tracker_dispatch(&tracker, geometry), "served request should expire");
+
+    return TEST_SUCCESS;
+}
+
+#endif //SERAPHIM_TEST_TRACKER_H